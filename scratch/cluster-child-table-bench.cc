@@ -0,0 +1,141 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * 比较ClusterChildTable和原来的vector线性查找
+ *
+ * For fan-outs of 4, 64 and 1024 children, time the two operations the
+ * join handlers do on every request:
+ *  - lookup: "is this address a child or a waiting child?", half hits
+ *  - join:   add a waiting child, then promote it to child
+ * once with the old pair of std::vector<Mac16Address> and once with
+ * ClusterChildTable, and print ns/op for each.
+ *
+ *   ./waf --run "cluster-child-table-bench --ops=2000000"
+ */
+#include <ns3/core-module.h>
+#include <ns3/mac16-address.h>
+#include <ns3/cluster-child-table.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace ns3;
+
+static Mac16Address MakeAddress (uint16_t addr16)
+{
+  uint8_t addr8[2];
+  addr8[0] = addr16 >> 8;
+  addr8[1] = addr16 & 0xff;
+  Mac16Address address;
+  address.CopyFrom (addr8);
+  return address;
+}
+
+// 原来DataIndication里的做法：children和children_wait两个vector
+struct VectorTable
+{
+  std::vector<Mac16Address> children;
+  std::vector<Mac16Address> childrenWait;
+
+  bool IsKnown (Mac16Address a) const
+  {
+    return std::find (children.begin (), children.end (), a) != children.end ()
+           || std::find (childrenWait.begin (), childrenWait.end (), a) != childrenWait.end ();
+  }
+  void Join (Mac16Address a)
+  {
+    childrenWait.push_back (a);
+    std::vector<Mac16Address>::iterator i = std::find (childrenWait.begin (), childrenWait.end (), a);
+    childrenWait.erase (i);
+    children.push_back (a);
+  }
+  void Leave (Mac16Address a)
+  {
+    children.erase (std::find (children.begin (), children.end (), a));
+  }
+};
+
+static double ElapsedNs (std::chrono::steady_clock::time_point t0, uint32_t ops)
+{
+  return std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - t0).count () / ops;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t ops = 2000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("ops", "operations per measurement", ops);
+  cmd.Parse (argc, argv);
+
+  Time now = Seconds (1);
+  Time expiry = Seconds (3);
+  uint32_t fanouts[] = { 4, 64, 1024 };
+  volatile uint32_t sink = 0;
+
+  std::cout << "fanout,vector_lookup_ns,table_lookup_ns,vector_join_ns,table_join_ns" << std::endl;
+  for (uint32_t f = 0; f < sizeof (fanouts) / sizeof (fanouts[0]); ++f)
+    {
+      uint32_t fanout = fanouts[f];
+      // 孩子地址分散在整个地址空间里，查询一半命中一半不命中
+      std::vector<uint32_t> probes;
+      VectorTable vectorTable;
+      ClusterChildTable childTable;
+      for (uint32_t i = 0; i < fanout; ++i)
+        {
+          uint32_t child = i * 37;
+          vectorTable.children.push_back (MakeAddress (child + 1));
+          childTable.AddChild (child);
+          probes.push_back (child);
+          probes.push_back (child + 1);
+        }
+      std::mt19937 rng (fanout);
+      std::shuffle (probes.begin (), probes.end (), rng);
+      std::vector<Mac16Address> probeAddresses;
+      for (uint32_t i = 0; i < probes.size (); ++i)
+        {
+          probeAddresses.push_back (MakeAddress (probes[i] + 1));
+        }
+
+      std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now ();
+      for (uint32_t i = 0; i < ops; ++i)
+        {
+          sink += vectorTable.IsKnown (probeAddresses[i % probes.size ()]);
+        }
+      double vectorLookup = ElapsedNs (t0, ops);
+
+      t0 = std::chrono::steady_clock::now ();
+      for (uint32_t i = 0; i < ops; ++i)
+        {
+          uint32_t a = probes[i % probes.size ()];
+          sink += childTable.IsChild (a) || childTable.IsPending (a, now);
+        }
+      double tableLookup = ElapsedNs (t0, ops);
+
+      // 加入再离开，保持fan-out不变
+      uint32_t joinOps = ops / 10;
+      uint32_t newcomer = 0xffef;
+      Mac16Address newcomerAddress = MakeAddress (newcomer + 1);
+      t0 = std::chrono::steady_clock::now ();
+      for (uint32_t i = 0; i < joinOps; ++i)
+        {
+          vectorTable.Join (newcomerAddress);
+          vectorTable.Leave (newcomerAddress);
+        }
+      double vectorJoin = ElapsedNs (t0, joinOps);
+
+      t0 = std::chrono::steady_clock::now ();
+      for (uint32_t i = 0; i < joinOps; ++i)
+        {
+          childTable.AddPending (newcomer, expiry);
+          sink += childTable.PromotePending (newcomer, now);
+          childTable.Remove (newcomer);
+        }
+      double tableJoin = ElapsedNs (t0, joinOps);
+
+      std::cout << fanout << "," << vectorLookup << "," << tableLookup << ","
+                << vectorJoin << "," << tableJoin << std::endl;
+    }
+  return sink == 0xffffffff;
+}
@@ -0,0 +1,247 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * 每一跳的包头开销：ClusterHeader编解码、Packet加头去头、整条控制消息的构造和解析
+ *
+ * Times the header work a cluster tree frame goes through at every hop
+ * and prints, for each case, ns/op and heap allocations per op (every
+ * operator new in the process, ns-3 included, is counted):
+ *  - header_serialize / header_deserialize / header_print: ClusterHeader
+ *    on a preallocated Buffer, without ("plain") and with ("addressed")
+ *    the optional originator and target
+ *  - small_add_remove / small_peek: AddHeader + RemoveHeader and
+ *    PeekHeader of a ClusterHeader on a 5-byte control packet
+ *  - fragmented_add_remove / fragmented_peek: the same on a packet glued
+ *    from two fragments of a larger one
+ *  - control_cycle: what SendP2p and DataIndication do for a join
+ *    request: allocate, add ClusterJoinHeader and ClusterHeader, copy as
+ *    the receiving MAC does, remove the ClusterHeader and peek the join
+ *    header; control_cycle_pooled allocates from a ClusterPacketPool
+ *  - data_cycle: a --size byte reading with ClusterDataHeader, removed
+ *    again and copied out with CopyData
+ *
+ * Run it before and after a header or packet-handling change, with the
+ * same --ops, to catch regressions.
+ *
+ *   ./waf --run "cluster-header-bench --ops=1000000"
+ */
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/cluster-header.h>
+#include <ns3/cluster-packet-pool.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+// 替换全局 operator new，整个进程（包括ns-3库）的每次堆分配都记下来
+static uint64_t g_allocations = 0;
+
+void *
+operator new (std::size_t size)
+{
+  g_allocations++;
+  void *p = std::malloc (size != 0 ? size : 1);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void *
+operator new[] (std::size_t size)
+{
+  return operator new (size);
+}
+
+void
+operator delete (void *p) noexcept
+{
+  std::free (p);
+}
+
+void
+operator delete[] (void *p) noexcept
+{
+  std::free (p);
+}
+
+void
+operator delete (void *p, std::size_t) noexcept
+{
+  std::free (p);
+}
+
+void
+operator delete[] (void *p, std::size_t) noexcept
+{
+  std::free (p);
+}
+
+/// Start of one measured case.
+struct Mark
+{
+  std::chrono::steady_clock::time_point time;  //!< wall clock
+  uint64_t allocations;                        //!< g_allocations
+};
+
+static Mark Start (void)
+{
+  Mark mark;
+  mark.allocations = g_allocations;
+  mark.time = std::chrono::steady_clock::now ();
+  return mark;
+}
+
+static void Report (const std::string &name, const Mark &mark, uint32_t ops)
+{
+  double ns = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - mark.time).count ();
+  uint64_t allocations = g_allocations - mark.allocations;
+  std::cout << name << "," << ops << "," << ns / ops << "," << double (allocations) / ops << std::endl;
+}
+
+static ClusterHeader MakeHeader (bool addressed)
+{
+  ClusterHeader header;
+  header.SetType (HEADER_REQUEST_CLUSTER_FOR_CHILD);
+  header.SetSequence (42);
+  header.SetClusterId (3);
+  if (addressed)
+    {
+      header.SetOriginator (1234);
+      header.SetTarget (17);
+    }
+  return header;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t ops = 1000000;
+  uint32_t size = 10;
+
+  CommandLine cmd;
+  cmd.AddValue ("ops", "operations per case", ops);
+  cmd.AddValue ("size", "reading size in bytes of data_cycle", size);
+  cmd.Parse (argc, argv);
+
+  volatile uint32_t sink = 0;
+  std::cout << "case,ops,ns_per_op,allocs_per_op" << std::endl;
+
+  // ClusterHeader 本身：缓冲区预先分配好，只量编解码
+  for (uint32_t a = 0; a < 2; ++a)
+    {
+      std::string suffix = a == 0 ? "_plain" : "_addressed";
+      ClusterHeader header = MakeHeader (a != 0);
+      Buffer buffer;
+      buffer.AddAtStart (header.GetSerializedSize ());
+
+      Mark mark = Start ();
+      for (uint32_t i = 0; i < ops; ++i)
+        {
+          header.Serialize (buffer.Begin ());
+        }
+      Report ("header_serialize" + suffix, mark, ops);
+
+      ClusterHeader parsed;
+      mark = Start ();
+      for (uint32_t i = 0; i < ops; ++i)
+        {
+          sink += parsed.Deserialize (buffer.Begin ());
+        }
+      Report ("header_deserialize" + suffix, mark, ops);
+
+      std::ostringstream os;
+      uint32_t printOps = ops / 10;
+      mark = Start ();
+      for (uint32_t i = 0; i < printOps; ++i)
+        {
+          os.seekp (0);
+          header.Print (os);
+        }
+      Report ("header_print" + suffix, mark, printOps);
+    }
+
+  // 小包和分片拼起来的包上加头、去头、看头
+  Ptr<Packet> whole = Create<Packet> (100);
+  Ptr<Packet> fragmented = whole->CreateFragment (10, 30);
+  fragmented->AddAtEnd (whole->CreateFragment (60, 20));
+  Ptr<Packet> packets[] = { Create<Packet> (5), fragmented };
+  std::string names[] = { "small", "fragmented" };
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      Ptr<Packet> p = packets[k];
+      ClusterHeader header = MakeHeader (false);
+      ClusterHeader parsed;
+      Mark mark = Start ();
+      for (uint32_t i = 0; i < ops; ++i)
+        {
+          p->AddHeader (header);
+          sink += p->RemoveHeader (parsed);
+        }
+      Report (names[k] + "_add_remove", mark, ops);
+
+      p->AddHeader (header);
+      mark = Start ();
+      for (uint32_t i = 0; i < ops; ++i)
+        {
+          sink += p->PeekHeader (parsed);
+        }
+      Report (names[k] + "_peek", mark, ops);
+      p->RemoveHeader (parsed);
+    }
+
+  // 一条入网请求从构造到对端解析完
+  ClusterPacketPool pool;
+  pool.SetCapacity (16);
+  for (uint32_t pooled = 0; pooled < 2; ++pooled)
+    {
+      Mark mark = Start ();
+      for (uint32_t i = 0; i < ops; ++i)
+        {
+          Ptr<Packet> p = pooled != 0 ? pool.Allocate (0) : Create<Packet> ();
+          ClusterJoinHeader joinHeader;
+          joinHeader.SetFather (5);
+          joinHeader.SetChild (i & 0xfff);
+          p->AddHeader (joinHeader);
+          ClusterHeader header = MakeHeader (false);
+          p->AddHeader (header);
+
+          Ptr<Packet> rx = p->Copy ();
+          ClusterHeader rcvHeader;
+          rx->RemoveHeader (rcvHeader);
+          ClusterJoinHeader rcvJoin;
+          rx->PeekHeader (rcvJoin);
+          sink += rcvJoin.GetChild ();
+        }
+      Report (pooled != 0 ? "control_cycle_pooled" : "control_cycle", mark, ops);
+    }
+
+  // 一条读数：加数据头，对端去头后把内容拷出来
+  std::vector<uint8_t> reading (size);
+  Mark mark = Start ();
+  for (uint32_t i = 0; i < ops; ++i)
+    {
+      Ptr<Packet> p = Create<Packet> (size);
+      ClusterDataHeader dataHeader;
+      dataHeader.SetOriginator (i & 0xfff);
+      p->AddHeader (dataHeader);
+      ClusterHeader header = MakeHeader (false);
+      header.SetType (HEADER_SEND_DATA_TO_COORDINATOR);
+      p->AddHeader (header);
+
+      Ptr<Packet> rx = p->Copy ();
+      ClusterHeader rcvHeader;
+      rx->RemoveHeader (rcvHeader);
+      ClusterDataHeader rcvData;
+      rx->RemoveHeader (rcvData);
+      sink += rx->CopyData (&reading[0], size);
+    }
+  Report ("data_cycle", mark, ops);
+
+  return sink == 0xffffffff;
+}
@@ -0,0 +1,270 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * 网络寿命测试：每个节点一节电池，按不同的读数速率跑到一半节点没电为止
+ *
+ * A --nodes grid (one node per --spacing x --spacing square, coordinator
+ * in a corner and mains powered) forms a tree from 0 s; from --start on
+ * every node sends a --size byte reading every 1 / rate seconds, for
+ * every rate of --rates, until its battery is empty.  Every battery
+ * holds --energy joules, spread uniformly by +-(--energySpread) of that,
+ * and feeds a ClusterRadioEnergyModel.  A run stops when half of the
+ * battery powered nodes are dead, or at --maxTime.
+ *
+ * Each CSV row gives the time the first node died (first_death_s) and
+ * the time half of them were dead (half_death_s), empty if it did not
+ * happen before --maxTime, the readings sent and delivered, the Join
+ * events (first joins and rejoins), the live cluster heads that retired and
+ * the mean energy consumed per battery powered node.
+ *
+ * The MAC keeps the receiver on between frames, so with the default
+ * currents listening dominates and the rate hardly matters; lower
+ * --listenCurrent to approximate a duty-cycled MAC and let the relay
+ * load show.
+ *
+ *   ./waf --run "cluster-lifetime-bench --rates=0.1,1,5 --variants=base,energyaware --listenCurrent=0.001"
+ *
+ * Variants (--variants, comma separated):
+ *  - base: parent choice and cluster heads ignore the residual energy
+ *  - energyaware: candidates lose up to --energyWeight of score as their
+ *    battery drains (EnergyWeight), and a cluster head below
+ *    --rotation of its energy releases its children (RotationThreshold)
+ */
+#include <ns3/core-module.h>
+#include <ns3/mobility-module.h>
+#include <ns3/lr-wpan-module.h>
+#include <ns3/energy-module.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/cluster-tree-helper.h>
+#include <ns3/cluster-tree-network.h>
+#include <ns3/cluster-tree-protocol.h>
+#include <ns3/cluster-radio-energy-model.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/// Counters of one run.
+struct LifetimeStats
+{
+  uint64_t sent;
+  uint64_t delivered;
+  uint64_t joins;
+  uint32_t dead;
+  uint32_t halfOf;
+  double firstDeath;
+  double halfDeath;
+};
+
+static LifetimeStats g_stats;
+
+static void DataRx (Ptr<const Packet> p, uint32_t originator)
+{
+  g_stats.delivered++;
+}
+
+static void Join (uint32_t father, uint16_t clusterId)
+{
+  g_stats.joins++;
+}
+
+static void EnergyDepleted (uint32_t index)
+{
+  double now = Simulator::Now ().GetSeconds ();
+  if (g_stats.dead++ == 0)
+    {
+      g_stats.firstDeath = now;
+    }
+  // 一半节点没电就算网络到头了，后面不用再跑
+  if (g_stats.dead == g_stats.halfOf)
+    {
+      g_stats.halfDeath = now;
+      Simulator::Stop ();
+    }
+}
+
+static void SendReading (Ptr<ClusterTreeProtocol> protocol, Time interval, uint32_t size)
+{
+  if (protocol->IsDepleted ())
+    {
+      return;
+    }
+  g_stats.sent++;
+  protocol->SendData (Create<Packet> (size));
+  Simulator::Schedule (interval, &SendReading, protocol, interval, size);
+}
+
+/// Scenario parameters shared by every run.
+struct LifetimeConfig
+{
+  uint32_t nodes;
+  double spacing;
+  double exponent;
+  double start;
+  uint32_t size;
+  double energy;
+  double energySpread;
+  double listenCurrent;
+  double maxTime;
+  double energyWeight;
+  double rotation;
+};
+
+static void RunOne (const LifetimeConfig &config, const std::string &variant, double rate, uint64_t run)
+{
+  g_stats = LifetimeStats ();
+  g_stats.halfOf = config.nodes / 2;  // 有电池的 nodes - 1 个节点的一半，向上取整
+  g_stats.firstDeath = -1;
+  g_stats.halfDeath = -1;
+  RngSeedManager::SetRun (run);
+  std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now ();
+
+  NodeContainer nodes;
+  nodes.Create (config.nodes);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (config.spacing),
+                                 "DeltaY", DoubleValue (config.spacing),
+                                 "GridWidth", UintegerValue (uint32_t (std::ceil (std::sqrt (config.nodes)))),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.Install (nodes);
+
+  ClusterTreeHelper clusterTree;
+  Ptr<LogDistancePropagationLossModel> logModel =
+    DynamicCast<LogDistancePropagationLossModel> (clusterTree.GetPropagationLossModel ());
+  logModel->SetPathLossExponent (config.exponent);
+  clusterTree.EnableEnergy ();
+  clusterTree.SetRadioEnergyModelAttribute ("ListenCurrentA", DoubleValue (config.listenCurrent));
+  if (variant == "energyaware")
+    {
+      clusterTree.SetParentSelectorAttribute ("EnergyWeight", DoubleValue (config.energyWeight));
+      clusterTree.SetProtocolAttribute ("RotationThreshold", DoubleValue (config.rotation));
+    }
+  else
+    {
+      NS_ABORT_MSG_UNLESS (variant == "base", "unknown variant " << variant);
+    }
+  NetDeviceContainer devices = clusterTree.Install (nodes);
+  int64_t stream = 0;
+  for (uint32_t i = 0; i < devices.GetN (); ++i)
+    {
+      stream += DynamicCast<LrWpanNetDevice> (devices.Get (i))->AssignStreams (stream);
+    }
+  stream += clusterTree.AssignStreams (stream);
+
+  // 电池容量各不相同，不然大家同时没电，看不出选父亲的差别
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  uniform->SetStream (stream++);
+  for (uint32_t i = 1; i < config.nodes; ++i)
+    {
+      Ptr<BasicEnergySource> source = DynamicCast<BasicEnergySource> (clusterTree.GetEnergySource (i));
+      source->SetInitialEnergy (config.energy * (1 + uniform->GetValue (-config.energySpread, config.energySpread)));
+      clusterTree.GetProtocol (i)->TraceConnectWithoutContext ("Join", MakeCallback (&Join));
+      clusterTree.GetProtocol (i)->TraceConnectWithoutContext ("EnergyDepleted", MakeCallback (&EnergyDepleted));
+    }
+  clusterTree.GetProtocol (0)->TraceConnectWithoutContext ("DataRx", MakeCallback (&DataRx));
+
+  clusterTree.StartFormation (Seconds (0));
+  Time interval = Seconds (1 / rate);
+  for (uint32_t i = 1; i < config.nodes; ++i)
+    {
+      Time first = Seconds (config.start + uniform->GetValue (0, interval.GetSeconds ()));
+      Simulator::ScheduleWithContext (nodes.Get (i)->GetId (), first, &SendReading, clusterTree.GetProtocol (i),
+                                      interval, config.size);
+    }
+  Simulator::Stop (Seconds (config.maxTime));
+  Simulator::Run ();
+
+  uint32_t retired = 0;
+  double consumed = 0;
+  for (uint32_t i = 1; i < config.nodes; ++i)
+    {
+      retired += clusterTree.GetProtocol (i)->IsRetired ();
+      consumed += clusterTree.GetRadioEnergyModel (i)->GetTotalEnergyConsumption ();
+    }
+  Simulator::Destroy ();
+  double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - wallStart).count ();
+
+  std::cout << config.nodes << "," << variant << "," << rate << "," << RngSeedManager::GetSeed () << "," << run << ","
+            << config.energy << ",";
+  if (g_stats.firstDeath >= 0)
+    {
+      std::cout << g_stats.firstDeath;
+    }
+  std::cout << ",";
+  if (g_stats.halfDeath >= 0)
+    {
+      std::cout << g_stats.halfDeath;
+    }
+  std::cout << "," << g_stats.dead << "," << g_stats.sent << "," << g_stats.delivered << ","
+            << (g_stats.sent != 0 ? double (g_stats.delivered) / g_stats.sent : 0) << ","
+            << g_stats.joins << "," << retired << "," << consumed / (config.nodes - 1) << "," << wall << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string rates = "0.1,1,5";
+  std::string variants = "base,energyaware";
+  uint32_t seed = 1;
+  uint32_t firstRun = 1;
+  uint32_t runs = 1;
+  LifetimeConfig config;
+  config.nodes = 49;
+  config.spacing = 30;
+  config.exponent = 2.5;
+  config.start = 10;
+  config.size = 10;
+  config.energy = 10;
+  config.energySpread = 0.1;
+  config.listenCurrent = 0.0197;
+  config.maxTime = 3600;
+  config.energyWeight = 20;
+  config.rotation = 0.3;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "nodes of the grid, coordinator included", config.nodes);
+  cmd.AddValue ("rates", "comma separated readings per second sent by every node", rates);
+  cmd.AddValue ("variants", "comma separated variants: base, energyaware", variants);
+  cmd.AddValue ("seed", "RNG seed shared by every run", seed);
+  cmd.AddValue ("firstRun", "RNG run number of the first run", firstRun);
+  cmd.AddValue ("runs", "runs per rate and variant", runs);
+  cmd.AddValue ("spacing", "meters between grid neighbours", config.spacing);
+  cmd.AddValue ("exponent", "path-loss exponent of the log-distance model", config.exponent);
+  cmd.AddValue ("start", "time the first readings are sent, after formation", config.start);
+  cmd.AddValue ("size", "reading size in bytes", config.size);
+  cmd.AddValue ("energy", "initial energy in joules of every battery", config.energy);
+  cmd.AddValue ("energySpread", "batteries hold energy * (1 +- energySpread), uniformly", config.energySpread);
+  cmd.AddValue ("listenCurrent", "ListenCurrentA of the radio energy model", config.listenCurrent);
+  cmd.AddValue ("maxTime", "seconds after which a run stops even if half the nodes live", config.maxTime);
+  cmd.AddValue ("energyWeight", "EnergyWeight of the energyaware variant", config.energyWeight);
+  cmd.AddValue ("rotation", "RotationThreshold of the energyaware variant", config.rotation);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_UNLESS (config.nodes > 1, "need a coordinator and at least one node");
+  NS_ABORT_MSG_UNLESS (config.energySpread >= 0 && config.energySpread < 1, "energySpread must be in [0, 1)");
+  RngSeedManager::SetSeed (seed);
+
+  std::cout << "nodes,variant,rate,seed,run,energy_j,first_death_s,half_death_s,dead,sent,delivered,"
+            << "delivery_ratio,joins,retired,mean_consumed_j,wall_s" << std::endl;
+  std::istringstream rateList (rates);
+  std::string item;
+  while (std::getline (rateList, item, ','))
+    {
+      double rate = std::stod (item);
+      NS_ABORT_MSG_UNLESS (rate > 0, "rates must be positive");
+      std::istringstream variantList (variants);
+      std::string variant;
+      while (std::getline (variantList, variant, ','))
+        {
+          for (uint32_t run = firstRun; run < firstRun + runs; ++run)
+            {
+              RunOne (config, variant, rate, run);
+            }
+        }
+    }
+  return 0;
+}
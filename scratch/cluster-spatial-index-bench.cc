@@ -0,0 +1,140 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * 邻居查询开销：网格索引和逐个比较
+ *
+ * For every node count N and for a grid and a uniform random deployment
+ * of the same density, register the nodes in a ClusterSpatialIndex whose
+ * cells match the radio range of the default channel (0 dBm, -90 dBm,
+ * LogDistance 2.5 / 46.6777 dB) and time:
+ *  - the index build,
+ *  - a neighbour query through the index,
+ *  - the same query by scanning every node, as without an index.
+ * The two queries must return the same neighbour count.
+ *
+ *   ./waf --run "cluster-spatial-index-bench --sizes=1000,10000,100000"
+ */
+#include <ns3/core-module.h>
+#include <ns3/mobility-module.h>
+#include <ns3/cluster-tree-helper.h>
+#include <ns3/cluster-tree-network.h>
+#include <ns3/cluster-spatial-index.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+static double ElapsedNs (std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - t0).count ();
+}
+
+static void RunOne (std::string layout, uint32_t nodeNum, double spacing, double range,
+                    uint32_t queries, uint32_t bruteQueries)
+{
+  uint32_t width = std::ceil (std::sqrt (nodeNum));
+  double side = width * spacing;
+  std::mt19937 rng (nodeNum);
+  std::uniform_real_distribution<double> coordinate (0, side);
+
+  std::vector<Ptr<MobilityModel> > mobility;
+  std::vector<Vector> positions;
+  for (uint32_t i = 0; i < nodeNum; ++i)
+    {
+      Vector position;
+      if (layout == "grid")
+        {
+          position = Vector ((i % width) * spacing, (i / width) * spacing, 0);
+        }
+      else
+        {
+          position = Vector (coordinate (rng), coordinate (rng), 0);
+        }
+      Ptr<ConstantPositionMobilityModel> m = CreateObject<ConstantPositionMobilityModel> ();
+      m->SetPosition (position);
+      mobility.push_back (m);
+      positions.push_back (position);
+    }
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now ();
+  Ptr<ClusterSpatialIndex> index = CreateObject<ClusterSpatialIndex> ();
+  index->SetCellSize (range);
+  for (uint32_t i = 0; i < nodeNum; ++i)
+    {
+      index->AddNode (mobility[i]);
+    }
+  double buildMs = ElapsedNs (t0) / 1e6;
+
+  std::vector<uint32_t> neighbors;
+  uint64_t found = 0;
+  t0 = std::chrono::steady_clock::now ();
+  for (uint32_t q = 0; q < queries; ++q)
+    {
+      index->GetNeighbors ((q * 7919u) % nodeNum, range, neighbors);
+      found += neighbors.size ();
+    }
+  double indexNs = ElapsedNs (t0) / queries;
+
+  // 没有索引时只能和每个节点比距离
+  uint64_t bruteFound = 0;
+  double range2 = range * range;
+  t0 = std::chrono::steady_clock::now ();
+  for (uint32_t q = 0; q < bruteQueries; ++q)
+    {
+      const Vector &center = positions[(q * 7919u) % nodeNum];
+      for (uint32_t j = 0; j < nodeNum; ++j)
+        {
+          double dx = positions[j].x - center.x;
+          double dy = positions[j].y - center.y;
+          bruteFound += (dx * dx + dy * dy <= range2);
+        }
+    }
+  double bruteNs = ElapsedNs (t0) / bruteQueries;
+
+  uint64_t checkFound = 0;
+  for (uint32_t q = 0; q < bruteQueries; ++q)
+    {
+      index->GetNeighbors ((q * 7919u) % nodeNum, range, neighbors);
+      checkFound += neighbors.size () + 1;  // the scan also counts the center node
+    }
+  NS_ABORT_MSG_UNLESS (checkFound == bruteFound, "index and scan disagree");
+
+  std::cout << layout << "," << nodeNum << "," << buildMs << "," << indexNs << ","
+            << bruteNs << "," << double (found) / queries << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string sizes = "1000,10000,100000";
+  double spacing = 15;
+  uint32_t queries = 100000;
+  uint32_t bruteQueries = 200;
+
+  CommandLine cmd;
+  cmd.AddValue ("sizes", "comma separated node counts", sizes);
+  cmd.AddValue ("spacing", "grid spacing in meters, the random layout keeps the same density", spacing);
+  cmd.AddValue ("queries", "neighbour queries through the index", queries);
+  cmd.AddValue ("bruteQueries", "neighbour queries by scanning every node", bruteQueries);
+  cmd.Parse (argc, argv);
+
+  // 用默认信道算出通信半径
+  ClusterTreeHelper clusterTree;
+  Ptr<ClusterTreeNetwork> network = CreateObject<ClusterTreeNetwork> ();
+  network->SetPropagationLossModel (clusterTree.GetPropagationLossModel ());
+  double range = network->GetRange (0.0, -90.0);
+  std::cout << "# range " << range << " m" << std::endl;
+
+  std::cout << "layout,nodes,build_ms,index_query_ns,scan_query_ns,avg_neighbors" << std::endl;
+  std::istringstream list (sizes);
+  std::string item;
+  while (std::getline (list, item, ','))
+    {
+      uint32_t nodeNum = std::stoul (item);
+      RunOne ("grid", nodeNum, spacing, range, queries, bruteQueries);
+      RunOne ("random", nodeNum, spacing, range, queries, bruteQueries);
+    }
+  return 0;
+}
@@ -0,0 +1,126 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * 把ClusterEventTracer写的二进制事件文件转成文本或CSV
+ *
+ * Reads a trace written by ClusterTreeHelper::EnableEventTracer and
+ * prints one line per record, as text or as CSV, optionally only the
+ * records of one node or one event.
+ *
+ *   ./waf --run "cluster-trace-decode --input=tree.ctev --format=csv" > tree.csv
+ */
+#include <ns3/core-module.h>
+#include <ns3/cluster-event-tracer.h>
+#include <ns3/cluster-tree-network.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+using namespace ns3;
+
+static const char *EventName (uint8_t event)
+{
+  switch (event)
+    {
+    case CLUSTER_TRACE_TX:
+      return "tx";
+    case CLUSTER_TRACE_RX:
+      return "rx";
+    case CLUSTER_TRACE_RX_WEAK:
+      return "rx-weak";
+    case CLUSTER_TRACE_TX_FAILED:
+      return "tx-failed";
+    case CLUSTER_TRACE_JOIN:
+      return "join";
+    case CLUSTER_TRACE_DATA:
+      return "data";
+    case CLUSTER_TRACE_DUPLICATE:
+      return "duplicate";
+    default:
+      return "unknown";
+    }
+}
+
+static void PrintPeer (uint32_t peer)
+{
+  if (peer == ClusterTreeNetwork::NO_NODE)
+    {
+      std::cout << "-";
+    }
+  else
+    {
+      std::cout << peer;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  std::string input;
+  std::string format = "text";
+  int64_t node = -1;
+  std::string event;
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "binary trace file", input);
+  cmd.AddValue ("format", "text or csv", format);
+  cmd.AddValue ("node", "only print records of this node index, -1 for all", node);
+  cmd.AddValue ("event", "only print this event (tx, rx, rx-weak, tx-failed, join, data)", event);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (input.empty (), "--input is required");
+  NS_ABORT_MSG_UNLESS (format == "text" || format == "csv", "unknown format " << format);
+
+  std::FILE *file = std::fopen (input.c_str (), "rb");
+  NS_ABORT_MSG_IF (file == 0, "cannot open " << input);
+  ClusterTraceFileHeader header;
+  if (std::fread (&header, sizeof (header), 1, file) != 1 || std::memcmp (header.magic, "CTEV", 4) != 0)
+    {
+      NS_FATAL_ERROR (input << " is not a cluster event trace");
+    }
+  NS_ABORT_MSG_UNLESS (header.version == ClusterEventTracer::VERSION
+                       && header.recordSize == sizeof (ClusterTraceRecord),
+                       "unsupported trace version " << header.version);
+
+  if (format == "csv")
+    {
+      std::cout << "time_ns,node,event,peer,type,rx_power_dbm" << std::endl;
+    }
+  // 按块读，和写的时候一样
+  std::vector<ClusterTraceRecord> block (65536);
+  uint64_t records = 0;
+  size_t n;
+  while ((n = std::fread (&block[0], sizeof (ClusterTraceRecord), block.size (), file)) > 0)
+    {
+      for (size_t i = 0; i < n; ++i)
+        {
+          const ClusterTraceRecord &r = block[i];
+          records++;
+          if ((node >= 0 && r.node != node) || (!event.empty () && event != EventName (r.event)))
+            {
+              continue;
+            }
+          bool hasPower = r.event == CLUSTER_TRACE_RX || r.event == CLUSTER_TRACE_RX_WEAK;
+          if (format == "csv")
+            {
+              std::cout << r.time << "," << r.node << "," << EventName (r.event) << ",";
+              PrintPeer (r.peer);
+              std::cout << "," << r.type << ",";
+              if (hasPower)
+                {
+                  std::cout << r.rxPowerDbm;
+                }
+              std::cout << "\n";
+              continue;
+            }
+          std::cout << r.time / 1e9 << "s node " << r.node << " " << EventName (r.event) << " peer ";
+          PrintPeer (r.peer);
+          std::cout << " type " << r.type;
+          if (hasPower)
+            {
+              std::cout << " at " << r.rxPowerDbm << " dBm";
+            }
+          std::cout << "\n";
+        }
+    }
+  std::fclose (file);
+  std::cerr << records << " records" << std::endl;
+  return 0;
+}
@@ -0,0 +1,802 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * 簇树建网与汇聚测试：按节点数、布局、配置扫一遍，每次运行输出一行CSV
+ *
+ * Every node count in --sizes is run --runs times per deployment pattern
+ * and configuration.  Formation starts at 0 s; from --start on every node
+ * sends --readings readings of --size bytes at --rate readings per second,
+ * with a random phase.  Run r uses seed --seed and run number r, and the
+ * protocol streams are pinned with AssignStreams, so a row can be
+ * reproduced alone with the same --seed and --firstRun.
+ *
+ * Each CSV row gives the tree depth (largest cluster id) and the mean
+ * hop count of the joined nodes (mean_depth), the formation
+ * time (last Join), the control frames the protocol sent per node and per
+ * join, the frames the MACs confirmed as failed, the delivery ratio at the
+ * coordinator and the end-to-end latency percentiles of delivered
+ * readings, the frames put on the air and their airtime, the frames the
+ * PHYs dropped (mostly collisions), the frames the MACs gave up on, the
+ * simulator events executed and the wall-clock time of the run.
+ *
+ *   ./waf --run "cluster-tree-bench --sizes=20,100,1000,10000 --patterns=grid,random --runs=3"
+ *
+ * With --kill=K, K random cluster heads (joined nodes with children) lose
+ * their radio --killDelay seconds after the readings start.  repair_s is
+ * then the time from the kill to the last Join, repair_control the
+ * control frames sent after the kill, and orphans the surviving nodes
+ * left outside the tree.  The nodes repair the tree locally unless the
+ * variant is "rebuild".
+ *
+ * goodput_bps is the reading bytes delivered per second of the reading
+ * period, queue_drops the readings a full ClusterSlottedMac queue dropped
+ * and slotframe_s the slotframe length of the tsch variant.
+ *
+ * packet_allocs is the control frame packets created by the protocols and
+ * allocs_per_frame the same per control frame sent (forwarded ones
+ * included); packets recycled by the ClusterPacketPool are not counted.
+ *
+ * relay_frames is the HEADER_REQUEST_CLUSTER_FOR_CHILD and
+ * HEADER_RETURN_CLUSTER_FOR_CHILD frames sent, forwarded ones included,
+ * and duplicates the relayed copies the nodes dropped as already handled.
+ *
+ * max_children is the most children any node has, max_branch the most
+ * nodes below one child of the coordinator, and rejected the adoptions
+ * the coordinator's ClusterAdmissionPolicy refused.
+ *
+ * beacon_rate_steady is the beacons broadcast per node and second in the
+ * --rateWindow seconds before the kill (before the end without --kill),
+ * beacon_rate_repair the same in the --rateWindow seconds after the kill.
+ *
+ * With --trace=<prefix> every run also writes a binary event trace,
+ * <prefix>-<nodes>-<pattern>-<variant>-<run>.ctev, for cluster-trace-decode.
+ *
+ * Deployment patterns (--patterns, comma separated), all with a density
+ * of one node per --spacing x --spacing square:
+ *  - grid: a square grid (--gridWidth nodes per row), coordinator in a corner
+ *  - random: uniform over the square, coordinator in the middle
+ *  - clustered: Gaussian groups of --clusterSize nodes (sigma --clusterSigma)
+ *    around uniform centres, coordinator in the middle
+ *
+ * Variants (--variants, comma separated):
+ *  - base: coordinator admission, no aggregation
+ *  - flooding: base with the permission flooded to every child
+ *    (DescendantFilterBits = 0), the routing before descendant filters
+ *  - unjittered: base answering beacons at once (JoinBackoff = 0)
+ *  - slotted: base with JoinSlot = --slot
+ *  - aggregation: AggregationWindow = --window (HEADER_SEND_AGGREGATE_TO_COORDINATOR)
+ *  - delegated: Admission = Delegated with --maxChildren and --maxDepth
+ *  - firstbeacon: ask the first beacon heard (ParentSelectionWindow = 0),
+ *    the parent choice before scored selection
+ *  - lqi: base scoring the MAC LQI instead of the received power
+ *  - tsch: data in the cells of a collision-free convergecast schedule
+ *    computed one second before --start (--cellsPerNode cells per node of
+ *    a subtree, --slotDuration slots, --channels data channels), control
+ *    frames still with CSMA-CA; compare with base as --sizes grows
+ *  - multichannel: clusters coloured over --channels channels one second
+ *    before --start (ClusterChannelPlan), uplink sent on the father's
+ *    cluster channel; run with --channels=1, 4 and 16 and compare
+ *    goodput_bps.  clusters and channel_conflicts describe the plan
+ *  - periodic: beacons every BeaconImin, never doubled nor suppressed
+ *    (BeaconDoublings = 0, BeaconRedundancy = 0), against the Trickle default
+ *  - culled: base on a ClusterCulledSpectrumChannel that only delivers
+ *    frames to the PHYs receiving at least --floor dBm; compare events and
+ *    wall_s with base at 1000 and 10000 nodes.  deliveries and culled are
+ *    the receptions the channel scheduled and skipped
+ *  - appfilter: base with the ClusterTreePhy threshold switched off, so
+ *    frames below RxSensitivity are decoded and acknowledged and only
+ *    dropped by the protocol, as before the PHY threshold; joined,
+ *    delivered and depth should match base while events and tx_frames
+ *    (which count ACKs) grow.  rx_below_sensitivity is the frames the
+ *    PHYs ignored
+ *  - nopool: base with PacketPoolSize = 0, every control frame payload
+ *    freshly allocated as before the packet pool; compare allocs_per_frame
+ *  - nodedup: base with DuplicateCacheSize = 0, every copy of a relayed
+ *    join request or permission handled and forwarded again as before the
+ *    duplicate cache; compare relay_frames with base
+ *  - admission: base with the coordinator limiting every node to
+ *    --admitChildren children, the tree to --admitDepth levels and each
+ *    branch to --admitLoad nodes (0 lifts a limit), redirecting refused
+ *    orphans; compare depth, max_children, max_branch and latency_max_ms
+ *    with base
+ *  - rebuild: no local repair (ParentLossThreshold = 0); after a kill every
+ *    surviving node is Reset and the coordinator restarts formation
+ */
+#include <ns3/core-module.h>
+#include <ns3/mobility-module.h>
+#include <ns3/lr-wpan-module.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/cluster-tree-helper.h>
+#include <ns3/cluster-tree-network.h>
+#include <ns3/cluster-tree-protocol.h>
+#include <ns3/cluster-header.h>
+#include <ns3/cluster-channel-plan.h>
+#include <ns3/cluster-culled-spectrum-channel.h>
+#include <ns3/cluster-tree-phy.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Send time of a reading.  A byte tag, so it stays on the reading's bytes
+ * when a cluster head packs it into an aggregate.
+ */
+class BenchTimestampTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::BenchTimestampTag")
+      .SetParent<Tag> ()
+      .AddConstructor<BenchTimestampTag> ()
+    ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return 8;
+  }
+  virtual void Serialize (TagBuffer i) const
+  {
+    i.WriteU64 (m_sent.GetTimeStep ());
+  }
+  virtual void Deserialize (TagBuffer i)
+  {
+    m_sent = TimeStep (i.ReadU64 ());
+  }
+  virtual void Print (std::ostream &os) const
+  {
+    os << "sent=" << m_sent;
+  }
+  void SetSent (Time sent)
+  {
+    m_sent = sent;
+  }
+  Time GetSent (void) const
+  {
+    return m_sent;
+  }
+
+private:
+  Time m_sent;
+};
+
+/// Counters of one run.
+struct BenchStats
+{
+  uint64_t sent;
+  uint64_t delivered;
+  uint64_t txFrames;
+  double airtime;
+  uint64_t phyRxDrops;
+  uint64_t macTxDrops;
+  uint64_t queueDrops;
+  uint64_t controlFrames;
+  uint64_t relayFrames;
+  uint64_t txFailed;
+  double formation;
+  double killAt;
+  double repair;
+  uint64_t repairControl;
+  double rateWindow;
+  double steadyEnd;
+  uint64_t steadyBeacons;
+  uint64_t repairBeacons;
+  std::vector<bool> dead;
+  std::vector<double> latencies;
+};
+
+static BenchStats g_stats;
+
+static void DataRx (Ptr<const Packet> p, uint32_t originator)
+{
+  g_stats.delivered++;
+  BenchTimestampTag tag;
+  if (p->FindFirstMatchingByteTag (tag))
+    {
+      g_stats.latencies.push_back ((Simulator::Now () - tag.GetSent ()).GetSeconds ());
+    }
+}
+
+static void Join (uint32_t father, uint16_t clusterId)
+{
+  if (g_stats.killAt >= 0 && Simulator::Now ().GetSeconds () >= g_stats.killAt)
+    {
+      g_stats.repair = Simulator::Now ().GetSeconds () - g_stats.killAt;
+      return;
+    }
+  g_stats.formation = Simulator::Now ().GetSeconds ();
+}
+
+static void ProtocolTx (uint16_t type, uint32_t dst)
+{
+  if (type != HEADER_SEND_DATA_TO_COORDINATOR && type != HEADER_SEND_AGGREGATE_TO_COORDINATOR)
+    {
+      g_stats.controlFrames++;
+      if (g_stats.killAt >= 0 && Simulator::Now ().GetSeconds () >= g_stats.killAt)
+        {
+          g_stats.repairControl++;
+        }
+    }
+  if (type == HEADER_REQUEST_CLUSTER_FOR_CHILD || type == HEADER_RETURN_CLUSTER_FOR_CHILD)
+    {
+      g_stats.relayFrames++;
+    }
+  if (type == HEADER_BEACON && dst == ClusterTreeNetwork::NO_NODE)
+    {
+      double now = Simulator::Now ().GetSeconds ();
+      if (now >= g_stats.steadyEnd - g_stats.rateWindow && now < g_stats.steadyEnd)
+        {
+          g_stats.steadyBeacons++;
+        }
+      if (g_stats.killAt >= 0 && now >= g_stats.killAt && now < g_stats.killAt + g_stats.rateWindow)
+        {
+          g_stats.repairBeacons++;
+        }
+    }
+}
+
+static void TxFailed (LrWpanMcpsDataConfirmStatus status)
+{
+  g_stats.txFailed++;
+}
+
+static void PhyTxBegin (Ptr<const Packet> p)
+{
+  // 2.4 GHz O-QPSK：250 kb/s，另加4字节前导、1字节SFD、1字节PHR
+  g_stats.txFrames++;
+  g_stats.airtime += (p->GetSize () + 6) * 8 / 250e3;
+}
+
+static void PhyRxDrop (Ptr<const Packet> p)
+{
+  g_stats.phyRxDrops++;
+}
+
+static void MacTxDrop (Ptr<const Packet> p)
+{
+  g_stats.macTxDrops++;
+}
+
+static void QueueDrop (Ptr<const Packet> p)
+{
+  g_stats.queueDrops++;
+}
+
+static void ConnectQueueDrops (void)
+{
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::ClusterSlottedMac/QueueDrop", MakeCallback (&QueueDrop));
+}
+
+static void SendReading (Ptr<ClusterTreeProtocol> protocol, Time interval, uint32_t remaining, uint32_t size)
+{
+  if (g_stats.dead[protocol->GetIndex ()])
+    {
+      return;
+    }
+  g_stats.sent++;
+  Ptr<Packet> reading = Create<Packet> (size);
+  BenchTimestampTag tag;
+  tag.SetSent (Simulator::Now ());
+  reading->AddByteTag (tag);
+  protocol->SendData (reading);
+  if (remaining > 1)
+    {
+      Simulator::Schedule (interval, &SendReading, protocol, interval, remaining - 1, size);
+    }
+}
+
+/**
+ * Switch off the radio of kill random cluster heads; with rebuild, reset
+ * the survivors and restart formation.
+ * \param helper the installed tree
+ * \param devices the devices, in node index order
+ * \param kill how many cluster heads to switch off
+ * \param rebuild rebuild the whole tree instead of repairing it locally
+ * \param stream random stream of the victim choice
+ */
+static void KillClusterHeads (ClusterTreeHelper *helper, NetDeviceContainer devices, uint32_t kill, bool rebuild,
+                              int64_t stream)
+{
+  std::vector<uint32_t> heads;
+  for (uint32_t i = 1; i < devices.GetN (); ++i)
+    {
+      Ptr<ClusterTreeProtocol> protocol = helper->GetProtocol (i);
+      if (protocol->IsJoined () && protocol->GetNChildren () != 0)
+        {
+          heads.push_back (i);
+        }
+    }
+  Ptr<UniformRandomVariable> pick = CreateObject<UniformRandomVariable> ();
+  pick->SetStream (stream);
+  for (uint32_t k = 0; k < kill && !heads.empty (); ++k)
+    {
+      uint32_t j = pick->GetInteger (0, heads.size () - 1);
+      uint32_t victim = heads[j];
+      heads[j] = heads.back ();
+      heads.pop_back ();
+      g_stats.dead[victim] = true;
+      helper->GetProtocol (victim)->Reset ();
+      Ptr<LrWpanNetDevice> dev = DynamicCast<LrWpanNetDevice> (devices.Get (victim));
+      dev->GetMac ()->SetRxOnWhenIdle (false);
+      dev->GetPhy ()->PlmeSetTRXStateRequest (IEEE_802_15_4_PHY_TRX_OFF);
+    }
+  if (rebuild)
+    {
+      for (uint32_t i = 0; i < devices.GetN (); ++i)
+        {
+          if (!g_stats.dead[i])
+            {
+              helper->GetProtocol (i)->Reset ();
+            }
+        }
+      helper->GetProtocol (0)->StartFormation ();
+    }
+}
+
+/**
+ * \param sorted ascending values, not empty
+ * \param q quantile in [0, 1]
+ * \return the nearest-rank quantile
+ */
+static double Percentile (const std::vector<double> &sorted, double q)
+{
+  uint32_t rank = uint32_t (std::ceil (q * sorted.size ()));
+  return sorted[std::max<uint32_t> (rank, 1) - 1];
+}
+
+/// Scenario parameters shared by every run.
+struct BenchConfig
+{
+  double spacing;
+  uint32_t gridWidth;
+  uint32_t clusterSize;
+  double clusterSigma;
+  double exponent;
+  uint32_t readings;
+  double rate;
+  double start;
+  uint32_t size;
+  double window;
+  uint32_t maxChildren;
+  uint32_t maxDepth;
+  double slot;
+  double slotDuration;
+  uint32_t channels;
+  uint32_t cellsPerNode;
+  std::string trace;
+  uint32_t kill;
+  double killDelay;
+  double rateWindow;
+  double floor;
+  uint32_t admitChildren;
+  uint32_t admitDepth;
+  uint32_t admitLoad;
+};
+
+/**
+ * Place the nodes following a deployment pattern.
+ * \param config scenario parameters
+ * \param pattern grid, random or clustered
+ * \param nodes the nodes, given a ConstantPositionMobilityModel
+ */
+static void Deploy (const BenchConfig &config, const std::string &pattern, NodeContainer nodes)
+{
+  uint32_t nodeNum = nodes.GetN ();
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  if (pattern == "grid")
+    {
+      uint32_t width = config.gridWidth != 0 ? config.gridWidth : uint32_t (std::ceil (std::sqrt (nodeNum)));
+      mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                     "MinX", DoubleValue (0.0),
+                                     "MinY", DoubleValue (0.0),
+                                     "DeltaX", DoubleValue (config.spacing),
+                                     "DeltaY", DoubleValue (config.spacing),
+                                     "GridWidth", UintegerValue (width),
+                                     "LayoutType", StringValue ("RowFirst"));
+      mobility.Install (nodes);
+      return;
+    }
+
+  // 随机和成团布局：一个节点占 spacing x spacing，Coor放在正中间
+  double side = config.spacing * std::sqrt (nodeNum);
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  Ptr<NormalRandomVariable> normal = CreateObject<NormalRandomVariable> ();
+  normal->SetAttribute ("Variance", DoubleValue (config.clusterSigma * config.clusterSigma));
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  positions->Add (Vector (side / 2, side / 2, 0));
+  Vector centre;
+  for (uint32_t i = 1; i < nodeNum; ++i)
+    {
+      if (pattern == "random")
+        {
+          positions->Add (Vector (uniform->GetValue (0, side), uniform->GetValue (0, side), 0));
+          continue;
+        }
+      NS_ABORT_MSG_UNLESS (pattern == "clustered", "unknown pattern " << pattern);
+      if ((i - 1) % config.clusterSize == 0)
+        {
+          centre = Vector (uniform->GetValue (0, side), uniform->GetValue (0, side), 0);
+        }
+      positions->Add (Vector (centre.x + normal->GetValue (), centre.y + normal->GetValue (), 0));
+    }
+  mobility.SetPositionAllocator (positions);
+  mobility.Install (nodes);
+}
+
+static void RunOne (const BenchConfig &config, uint32_t nodeNum, const std::string &pattern,
+                    const std::string &variant, uint64_t run)
+{
+  g_stats = BenchStats ();
+  g_stats.killAt = config.kill != 0 ? config.start + config.killDelay : -1;
+  g_stats.dead.assign (nodeNum, false);
+  double stop = config.start + config.window + (config.readings + 2) / config.rate;
+  g_stats.rateWindow = config.rateWindow;
+  g_stats.steadyEnd = g_stats.killAt >= 0 ? g_stats.killAt : stop;
+  RngSeedManager::SetRun (run);
+  std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now ();
+
+  NodeContainer nodes;
+  nodes.Create (nodeNum);
+  Deploy (config, pattern, nodes);
+
+  ClusterTreeHelper clusterTree;
+  Ptr<LogDistancePropagationLossModel> logModel =
+    DynamicCast<LogDistancePropagationLossModel> (clusterTree.GetPropagationLossModel ());
+  logModel->SetPathLossExponent (config.exponent);
+  Ptr<ClusterCulledSpectrumChannel> culled;
+  if (variant == "aggregation")
+    {
+      clusterTree.SetProtocolAttribute ("AggregationWindow", TimeValue (Seconds (config.window)));
+    }
+  else if (variant == "unjittered")
+    {
+      clusterTree.SetProtocolAttribute ("JoinBackoff", TimeValue (Seconds (0)));
+    }
+  else if (variant == "slotted")
+    {
+      clusterTree.SetProtocolAttribute ("JoinSlot", TimeValue (Seconds (config.slot)));
+    }
+  else if (variant == "flooding")
+    {
+      clusterTree.SetProtocolAttribute ("DescendantFilterBits", UintegerValue (0));
+    }
+  else if (variant == "firstbeacon")
+    {
+      clusterTree.SetProtocolAttribute ("ParentSelectionWindow", TimeValue (Seconds (0)));
+    }
+  else if (variant == "lqi")
+    {
+      clusterTree.SetParentSelectorAttribute ("LinkMetric", StringValue ("Lqi"));
+    }
+  else if (variant == "tsch")
+    {
+      NS_ABORT_MSG_UNLESS (config.start > 1, "the tsch variant needs --start above 1 s");
+      clusterTree.SetSlottedMacAttribute ("SlotDuration", TimeValue (Seconds (config.slotDuration)));
+      clusterTree.SetSlottedMacAttribute ("Channels", UintegerValue (config.channels));
+    }
+  else if (variant == "multichannel")
+    {
+      NS_ABORT_MSG_UNLESS (config.start > 1, "the multichannel variant needs --start above 1 s");
+      clusterTree.SetChannelPlanAttribute ("Channels", UintegerValue (config.channels));
+    }
+  else if (variant == "periodic")
+    {
+      clusterTree.SetProtocolAttribute ("BeaconDoublings", UintegerValue (0));
+      clusterTree.SetProtocolAttribute ("BeaconRedundancy", UintegerValue (0));
+    }
+  else if (variant == "culled")
+    {
+      culled = clusterTree.EnableCulledChannel ();
+      culled->SetAttribute ("InterferenceFloor", DoubleValue (config.floor));
+    }
+  else if (variant == "appfilter")
+    {
+      // Install 之后再关掉PHY门限
+    }
+  else if (variant == "nopool")
+    {
+      clusterTree.SetNetworkAttribute ("PacketPoolSize", UintegerValue (0));
+    }
+  else if (variant == "admission")
+    {
+      clusterTree.SetAdmissionPolicyAttribute ("MaxChildren", UintegerValue (config.admitChildren));
+      clusterTree.SetAdmissionPolicyAttribute ("MaxDepth", UintegerValue (config.admitDepth));
+      clusterTree.SetAdmissionPolicyAttribute ("MaxSubtreeLoad", UintegerValue (config.admitLoad));
+    }
+  else if (variant == "nodedup")
+    {
+      clusterTree.SetProtocolAttribute ("DuplicateCacheSize", UintegerValue (0));
+    }
+  else if (variant == "rebuild")
+    {
+      clusterTree.SetProtocolAttribute ("ParentLossThreshold", UintegerValue (0));
+    }
+  else if (variant == "delegated")
+    {
+      clusterTree.SetProtocolAttribute ("Admission", StringValue ("Delegated"));
+      clusterTree.SetProtocolAttribute ("MaxChildren", UintegerValue (config.maxChildren));
+      clusterTree.SetProtocolAttribute ("MaxDepth", UintegerValue (config.maxDepth));
+    }
+  else
+    {
+      NS_ABORT_MSG_UNLESS (variant == "base", "unknown variant " << variant);
+    }
+  if (!config.trace.empty ())
+    {
+      std::ostringstream traceFile;
+      traceFile << config.trace << "-" << nodeNum << "-" << pattern << "-" << variant << "-" << run << ".ctev";
+      clusterTree.EnableEventTracer (traceFile.str ());
+    }
+  NetDeviceContainer devices = clusterTree.Install (nodes);
+  int64_t stream = 0;
+  for (uint32_t i = 0; i < devices.GetN (); ++i)
+    {
+      Ptr<LrWpanNetDevice> dev = DynamicCast<LrWpanNetDevice> (devices.Get (i));
+      stream += dev->AssignStreams (stream);
+      dev->GetPhy ()->TraceConnectWithoutContext ("PhyTxBegin", MakeCallback (&PhyTxBegin));
+      dev->GetPhy ()->TraceConnectWithoutContext ("PhyRxDrop", MakeCallback (&PhyRxDrop));
+      dev->GetMac ()->TraceConnectWithoutContext ("MacTxDrop", MakeCallback (&MacTxDrop));
+      if (variant == "appfilter")
+        {
+          DynamicCast<ClusterTreePhy> (dev->GetPhy ())->SetRxSensitivity (-1000);
+        }
+    }
+  stream += clusterTree.AssignStreams (stream);
+  for (uint32_t i = 0; i < nodeNum; ++i)
+    {
+      clusterTree.GetProtocol (i)->TraceConnectWithoutContext ("Join", MakeCallback (&Join));
+      clusterTree.GetProtocol (i)->TraceConnectWithoutContext ("Tx", MakeCallback (&ProtocolTx));
+      clusterTree.GetProtocol (i)->TraceConnectWithoutContext ("TxFailed", MakeCallback (&TxFailed));
+    }
+  clusterTree.GetProtocol (0)->TraceConnectWithoutContext ("DataRx", MakeCallback (&DataRx));
+
+  clusterTree.StartFormation (Seconds (0));
+  Ptr<ClusterChannelPlan> plan;
+  if (variant == "multichannel")
+    {
+      plan = clusterTree.EnableChannelPlan (Seconds (config.start - 1));
+    }
+  if (variant == "tsch")
+    {
+      clusterTree.EnableSlottedConvergecast (Seconds (config.start - 1), config.cellsPerNode);
+      // 时隙层到那时才建，同一时刻排在后面再接上
+      Simulator::Schedule (Seconds (config.start - 1), &ConnectQueueDrops);
+    }
+  Time interval = Seconds (1 / config.rate);
+  Ptr<UniformRandomVariable> phase = CreateObject<UniformRandomVariable> ();
+  phase->SetStream (stream);
+  for (uint32_t i = 1; i < nodeNum; ++i)
+    {
+      Time first = Seconds (config.start + phase->GetValue (0, interval.GetSeconds ()));
+      Simulator::ScheduleWithContext (nodes.Get (i)->GetId (), first, &SendReading, clusterTree.GetProtocol (i),
+                                      interval, config.readings, config.size);
+    }
+  if (config.kill != 0)
+    {
+      Simulator::Schedule (Seconds (g_stats.killAt), &KillClusterHeads, &clusterTree, devices, config.kill,
+                           variant == "rebuild", stream + 1);
+    }
+  Simulator::Stop (Seconds (stop));
+  Simulator::Run ();
+  uint64_t events = Simulator::GetEventCount ();
+
+  uint32_t joined = 0;
+  uint32_t orphans = 0;
+  uint16_t depth = 0;
+  uint64_t depthSum = 0;
+  uint64_t duplicates = 0;
+  uint32_t maxChildren = 0;
+  std::vector<uint32_t> fathers (nodeNum, ClusterTreeNetwork::NO_NODE);
+  for (uint32_t i = 0; i < nodeNum; ++i)
+    {
+      Ptr<ClusterTreeProtocol> protocol = clusterTree.GetProtocol (i);
+      duplicates += protocol->GetNDuplicates ();
+      maxChildren = std::max (maxChildren, protocol->GetNChildren ());
+      if (protocol->IsJoined ())
+        {
+          fathers[i] = protocol->GetFather ();
+          joined++;
+          depth = std::max (depth, protocol->GetClusterId ());
+          depthSum += protocol->GetClusterId ();
+        }
+      else if (!g_stats.dead[i])
+        {
+          orphans++;
+        }
+    }
+  // 每个节点顺着父亲往上找到Coor的哪个儿子，数每一支有多少节点
+  std::vector<uint32_t> branchSize (nodeNum, 0);
+  for (uint32_t i = 1; i < nodeNum; ++i)
+    {
+      uint32_t n = i;
+      uint32_t hops = 0;
+      while (fathers[n] != ClusterTreeNetwork::NO_NODE && fathers[n] != 0 && hops++ < nodeNum)
+        {
+          n = fathers[n];
+        }
+      if (fathers[n] == 0)
+        {
+          branchSize[n]++;
+        }
+    }
+  uint32_t maxBranch = *std::max_element (branchSize.begin (), branchSize.end ());
+  uint64_t rejected = clusterTree.GetProtocol (0)->GetNRejected ();
+  uint32_t slotframe = clusterTree.GetSchedule ().GetSlotframeLength ();
+  uint64_t packetAllocs = clusterTree.GetNetwork ()->GetPacketPool ().GetNAllocated ();
+  uint64_t belowSensitivity = 0;
+  for (uint32_t i = 0; i < devices.GetN (); ++i)
+    {
+      Ptr<LrWpanNetDevice> dev = DynamicCast<LrWpanNetDevice> (devices.Get (i));
+      belowSensitivity += DynamicCast<ClusterTreePhy> (dev->GetPhy ())->GetNRxBelowSensitivity ();
+    }
+  Simulator::Destroy ();
+  double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - wallStart).count ();
+
+  std::vector<double> &latencies = g_stats.latencies;
+  std::sort (latencies.begin (), latencies.end ());
+  std::cout << nodeNum << "," << pattern << "," << variant << "," << RngSeedManager::GetSeed () << "," << run << ","
+            << joined << "," << depth << "," << (joined > 1 ? double (depthSum) / (joined - 1) : 0) << ","
+            << g_stats.formation << ","
+            << g_stats.controlFrames << "," << double (g_stats.controlFrames) / nodeNum << ","
+            << (joined > 1 ? double (g_stats.controlFrames) / (joined - 1) : 0) << ","
+            << g_stats.txFailed << "," << g_stats.sent << "," << g_stats.delivered << ","
+            << (g_stats.sent != 0 ? double (g_stats.delivered) / g_stats.sent : 0) << ",";
+  if (latencies.empty ())
+    {
+      std::cout << ",,,";
+    }
+  else
+    {
+      std::cout << Percentile (latencies, 0.5) * 1e3 << "," << Percentile (latencies, 0.9) * 1e3 << ","
+                << Percentile (latencies, 0.99) * 1e3 << "," << latencies.back () * 1e3 << ",";
+    }
+  std::cout << g_stats.txFrames << "," << g_stats.airtime << ","
+            << g_stats.phyRxDrops << "," << g_stats.macTxDrops << ","
+            << events << "," << wall << ","
+            << std::count (g_stats.dead.begin (), g_stats.dead.end (), true) << "," << orphans << ","
+            << g_stats.repair << "," << g_stats.repairControl << ","
+            << double (g_stats.steadyBeacons) / nodeNum / config.rateWindow << ",";
+  if (g_stats.killAt >= 0)
+    {
+      std::cout << double (g_stats.repairBeacons) / nodeNum / config.rateWindow;
+    }
+  std::cout << "," << g_stats.delivered * config.size * 8 / (config.readings / config.rate) << ","
+            << g_stats.queueDrops << ",";
+  if (variant == "tsch")
+    {
+      std::cout << slotframe * config.slotDuration;
+    }
+  std::cout << ",";
+  if (plan != 0)
+    {
+      std::cout << plan->GetNClusters () << "," << plan->GetNConflicts ();
+    }
+  else
+    {
+      std::cout << ",";
+    }
+  std::cout << ",";
+  if (culled != 0)
+    {
+      std::cout << culled->GetNDeliveries () << "," << culled->GetNCulled ();
+    }
+  else
+    {
+      std::cout << ",";
+    }
+  std::cout << "," << belowSensitivity << "," << packetAllocs << ","
+            << (g_stats.controlFrames != 0 ? double (packetAllocs) / g_stats.controlFrames : 0) << ","
+            << g_stats.relayFrames << "," << duplicates << ","
+            << maxChildren << "," << maxBranch << "," << rejected << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string sizes = "20,100,400";
+  std::string patterns = "grid";
+  std::string variants = "base,aggregation";
+  uint32_t seed = 1;
+  uint32_t firstRun = 1;
+  uint32_t runs = 1;
+  BenchConfig config;
+  config.spacing = 30;
+  config.gridWidth = 0;
+  config.clusterSize = 20;
+  config.clusterSigma = 20;
+  config.exponent = 2.5;
+  config.readings = 10;
+  config.rate = 1;
+  config.start = 10;
+  config.size = 10;
+  config.window = 0.2;
+  config.maxChildren = 6;
+  config.maxDepth = 8;
+  config.slot = 0.004;
+  config.slotDuration = 0.01;
+  config.channels = 4;
+  config.cellsPerNode = 1;
+  config.kill = 0;
+  config.killDelay = 2;
+  config.rateWindow = 2;
+  config.floor = -110;
+  config.admitChildren = 4;
+  config.admitDepth = 0;
+  config.admitLoad = 0;
+
+  CommandLine cmd;
+  cmd.AddValue ("sizes", "comma separated node counts", sizes);
+  cmd.AddValue ("patterns", "comma separated deployment patterns: grid, random, clustered", patterns);
+  cmd.AddValue ("variants", "comma separated variants: base, unjittered, slotted, flooding, aggregation, delegated, "
+                "firstbeacon, lqi, tsch, multichannel, periodic, culled, appfilter, nopool, nodedup, admission, rebuild",
+                variants);
+  cmd.AddValue ("seed", "RNG seed shared by every run", seed);
+  cmd.AddValue ("firstRun", "RNG run number of the first run", firstRun);
+  cmd.AddValue ("runs", "runs per node count, pattern and variant", runs);
+  cmd.AddValue ("spacing", "meters between neighbours, one node per spacing^2", config.spacing);
+  cmd.AddValue ("gridWidth", "nodes per grid row, 0 for a square grid", config.gridWidth);
+  cmd.AddValue ("clusterSize", "nodes per group of the clustered pattern", config.clusterSize);
+  cmd.AddValue ("clusterSigma", "standard deviation in meters of a group of the clustered pattern",
+                config.clusterSigma);
+  cmd.AddValue ("exponent", "path-loss exponent of the log-distance model", config.exponent);
+  cmd.AddValue ("readings", "readings sent by every node", config.readings);
+  cmd.AddValue ("rate", "readings per second sent by every node", config.rate);
+  cmd.AddValue ("start", "time the first readings are sent, after formation", config.start);
+  cmd.AddValue ("size", "reading size in bytes", config.size);
+  cmd.AddValue ("window", "AggregationWindow in seconds of the aggregation variant", config.window);
+  cmd.AddValue ("maxChildren", "MaxChildren of the delegated variant", config.maxChildren);
+  cmd.AddValue ("maxDepth", "MaxDepth of the delegated variant", config.maxDepth);
+  cmd.AddValue ("kill", "cluster heads switched off after the readings start", config.kill);
+  cmd.AddValue ("killDelay", "seconds after --start at which cluster heads are switched off", config.killDelay);
+  cmd.AddValue ("rateWindow", "seconds over which the beacon rates are counted", config.rateWindow);
+  cmd.AddValue ("trace", "file name prefix of per-run binary event traces, empty for none", config.trace);
+  cmd.AddValue ("slot", "JoinSlot in seconds of the slotted variant", config.slot);
+  cmd.AddValue ("slotDuration", "cell length in seconds of the tsch variant", config.slotDuration);
+  cmd.AddValue ("channels", "data channels of the tsch and multichannel variants", config.channels);
+  cmd.AddValue ("cellsPerNode", "cells per slotframe per subtree node of the tsch variant", config.cellsPerNode);
+  cmd.AddValue ("floor", "InterferenceFloor in dBm of the culled variant", config.floor);
+  cmd.AddValue ("admitChildren", "MaxChildren of the admission variant, 0 for any", config.admitChildren);
+  cmd.AddValue ("admitDepth", "MaxDepth of the admission variant, 0 for any", config.admitDepth);
+  cmd.AddValue ("admitLoad", "MaxSubtreeLoad of the admission variant, 0 for any", config.admitLoad);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_UNLESS (config.rate > 0, "rate must be positive");
+  RngSeedManager::SetSeed (seed);
+
+  std::cout << "nodes,pattern,variant,seed,run,joined,depth,mean_depth,formation_s,control_frames,control_per_node,"
+            << "control_per_join,tx_failed,sent,delivered,delivery_ratio,"
+            << "latency_p50_ms,latency_p90_ms,latency_p99_ms,latency_max_ms,"
+            << "tx_frames,airtime_s,phy_rx_drops,mac_tx_drops,events,wall_s,"
+            << "killed,orphans,repair_s,repair_control,beacon_rate_steady,beacon_rate_repair,"
+            << "goodput_bps,queue_drops,slotframe_s,clusters,channel_conflicts,deliveries,culled,rx_below_sensitivity,packet_allocs,allocs_per_frame,"
+            << "relay_frames,duplicates,max_children,max_branch,rejected" << std::endl;
+  std::istringstream sizeList (sizes);
+  std::string item;
+  while (std::getline (sizeList, item, ','))
+    {
+      uint32_t nodeNum = std::stoul (item);
+      std::istringstream patternList (patterns);
+      std::string pattern;
+      while (std::getline (patternList, pattern, ','))
+        {
+          std::istringstream variantList (variants);
+          std::string variant;
+          while (std::getline (variantList, variant, ','))
+            {
+              for (uint32_t run = firstRun; run < firstRun + runs; ++run)
+                {
+                  RunOne (config, nodeNum, pattern, variant, run);
+                }
+            }
+        }
+    }
+  return 0;
+}
@@ -0,0 +1,138 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * 长时间转发测试：看内存会不会涨
+ *
+ * Three nodes on a line, 40 m apart, so the leaf can only reach the
+ * coordinator through the relay.  After formation the leaf sends a
+ * reading every --interval seconds and the relay forwards it; every
+ * --report delivered frames the resident memory of the process is
+ * printed.  With the typed headers the receive path allocates nothing
+ * per frame, so RSS stays flat once the simulator reached steady state.
+ *
+ * The first sample is the baseline.  The run aborts if RSS later grows
+ * by more than --maxGrowth KiB, or if the packet pool of the network
+ * creates packets after the baseline instead of recycling them (unless
+ * PacketPoolSize is 0).
+ *
+ *   ./waf --run "cluster-tree-rss --frames=1000000"
+ */
+#include <ns3/core-module.h>
+#include <ns3/mobility-module.h>
+#include <ns3/cluster-tree-helper.h>
+#include <ns3/cluster-tree-network.h>
+#include <ns3/cluster-tree-protocol.h>
+#include <cstdio>
+#include <iostream>
+#include <unistd.h>
+
+using namespace ns3;
+
+static uint32_t g_delivered = 0;
+static uint32_t g_report = 100000;
+static uint64_t g_firstRss = 0;
+static uint64_t g_maxGrowthKib = 1024;
+static uint32_t g_samples = 0;
+static uint64_t g_firstAllocated = 0;
+static Ptr<ClusterTreeNetwork> g_network;
+
+static uint64_t ResidentBytes (void)
+{
+  unsigned long pages = 0;
+  unsigned long resident = 0;
+  FILE *statm = std::fopen ("/proc/self/statm", "r");
+  if (statm != 0)
+    {
+      if (std::fscanf (statm, "%lu %lu", &pages, &resident) != 2)
+        {
+          resident = 0;
+        }
+      std::fclose (statm);
+    }
+  return uint64_t (resident) * sysconf (_SC_PAGESIZE);
+}
+
+static void DataRx (Ptr<const Packet> p, uint32_t originator)
+{
+  g_delivered++;
+  if (g_delivered % g_report == 0)
+    {
+      uint64_t rss = ResidentBytes ();
+      uint64_t allocated = g_network->GetPacketPool ().GetNAllocated ();
+      if (g_samples++ == 0)
+        {
+          g_firstRss = rss;
+          g_firstAllocated = allocated;
+        }
+      int64_t growthKib = (int64_t (rss) - int64_t (g_firstRss)) / 1024;
+      std::cout << g_delivered << "," << Simulator::Now ().GetSeconds () << ","
+                << rss / 1024 << "," << growthKib << "," << allocated - g_firstAllocated << std::endl;
+      // 稳态以后每帧都不该再要内存
+      NS_ABORT_MSG_IF (growthKib > int64_t (g_maxGrowthKib),
+                       "RSS grew by " << growthKib << " KiB after " << g_delivered << " frames");
+      NS_ABORT_MSG_IF (g_network->GetPacketPool ().GetCapacity () != 0 && allocated != g_firstAllocated,
+                       "packet pool created " << allocated - g_firstAllocated << " packets after the baseline");
+    }
+}
+
+static void SendReading (Ptr<ClusterTreeProtocol> leaf, Time interval, uint32_t remaining, uint32_t size)
+{
+  leaf->SendData (Create<Packet> (size));
+  if (remaining > 1)
+    {
+      Simulator::Schedule (interval, &SendReading, leaf, interval, remaining - 1, size);
+    }
+}
+
+static void CheckTree (Ptr<ClusterTreeProtocol> relay, Ptr<ClusterTreeProtocol> leaf)
+{
+  NS_ABORT_MSG_UNLESS (leaf->IsJoined () && leaf->GetFather () == relay->GetIndex (),
+                       "the leaf did not join through the relay");
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t frames = 1000000;
+  double interval = 0.02;
+  uint32_t size = 10;
+
+  CommandLine cmd;
+  cmd.AddValue ("frames", "readings sent by the leaf", frames);
+  cmd.AddValue ("interval", "seconds between two readings", interval);
+  cmd.AddValue ("size", "reading size in bytes", size);
+  cmd.AddValue ("report", "delivered frames between two memory samples", g_report);
+  cmd.AddValue ("maxGrowth", "RSS growth in KiB allowed after the first sample", g_maxGrowthKib);
+  cmd.Parse (argc, argv);
+
+  NodeContainer nodes;
+  nodes.Create (3);
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (40),
+                                 "DeltaY", DoubleValue (40),
+                                 "GridWidth", UintegerValue (3),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  ClusterTreeHelper clusterTree;
+  clusterTree.Install (nodes);
+  clusterTree.GetProtocol (0)->TraceConnectWithoutContext ("DataRx", MakeCallback (&DataRx));
+  g_network = clusterTree.GetNetwork ();
+
+  clusterTree.StartFormation (Seconds (0));
+  Simulator::Schedule (Seconds (0.9), &CheckTree, clusterTree.GetProtocol (1), clusterTree.GetProtocol (2));
+  Simulator::ScheduleWithContext (nodes.Get (2)->GetId (), Seconds (1), &SendReading,
+                                  clusterTree.GetProtocol (2), Seconds (interval), frames, size);
+
+  std::cout << "delivered,sim_s,rss_kib,rss_growth_kib,pool_growth" << std::endl;
+  Simulator::Run ();
+  Simulator::Destroy ();
+  g_network = 0;
+  std::cout << "sent " << frames << ", delivered " << g_delivered << std::endl;
+  // 只有一个样本就没有可比的
+  NS_ABORT_MSG_IF (g_samples < 2, "only " << g_samples << " memory samples, lower --report or raise --frames");
+  std::cout << "RSS stayed within " << g_maxGrowthKib << " KiB over " << g_samples << " samples" << std::endl;
+  return 0;
+}
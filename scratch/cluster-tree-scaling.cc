@@ -0,0 +1,131 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * 测试ClusterTreeHelper在大规模部署下的建网开销
+ *
+ * For every node count N the deployment (nodes, grid mobility, devices,
+ * addresses and ClusterTreeProtocol) is built in a forked child process,
+ * so that each row starts from a clean heap, and the child reports the
+ * wall-clock setup time and the resident memory it added.
+ *
+ * With --linkBudget=Dense or Sparse the link budget cache is also filled
+ * for every pair before measuring, and the stored links and cache bytes
+ * per node are reported.  Dense needs 4*N^2 bytes, so keep it for small N.
+ *
+ *   ./waf --run "cluster-tree-scaling --sizes=100,1000,10000,50000"
+ *   ./waf --run "cluster-tree-scaling --sizes=1000,10000 --linkBudget=Sparse"
+ *   ./waf --run "cluster-tree-scaling --sizes=100000 --extended=1"
+ */
+#include <ns3/core-module.h>
+#include <ns3/mobility-module.h>
+#include <ns3/cluster-tree-helper.h>
+#include <ns3/cluster-tree-network.h>
+#include <ns3/cluster-link-budget.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+// 当前进程的常驻内存(字节)
+static uint64_t ResidentBytes (void)
+{
+  unsigned long pages = 0;
+  unsigned long resident = 0;
+  FILE *statm = std::fopen ("/proc/self/statm", "r");
+  if (statm != 0)
+    {
+      if (std::fscanf (statm, "%lu %lu", &pages, &resident) != 2)
+        {
+          resident = 0;
+        }
+      std::fclose (statm);
+    }
+  return uint64_t (resident) * sysconf (_SC_PAGESIZE);
+}
+
+static void RunOne (uint32_t nodeNum, double spacing, std::string linkBudget, bool extended)
+{
+  uint64_t rssBefore = ResidentBytes ();
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now ();
+
+  NodeContainer nodes;
+  nodes.Create (nodeNum);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (std::ceil (std::sqrt (nodeNum))),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  ClusterTreeHelper clusterTree;
+  clusterTree.SetNetworkAttribute ("ExtendedAddressing", BooleanValue (extended));
+  if (linkBudget != "None")
+    {
+      clusterTree.SetLinkBudgetAttribute ("Mode", StringValue (linkBudget));
+    }
+  clusterTree.Install (nodes);
+  Ptr<ClusterLinkBudget> budget = clusterTree.GetNetwork ()->GetLinkBudget ();
+  if (linkBudget != "None")
+    {
+      budget->Precompute ();
+    }
+
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now ();
+  uint64_t rssAfter = ResidentBytes ();
+
+  double setupMs = std::chrono::duration<double, std::milli> (t1 - t0).count ();
+  double bytesPerNode = double (rssAfter - rssBefore) / nodeNum;
+  std::cout << nodeNum << "," << setupMs << "," << setupMs * 1000 / nodeNum << ","
+            << (rssAfter - rssBefore) / 1024 << "," << bytesPerNode << ","
+            << budget->GetNLinks () << "," << double (budget->GetMemoryUsage ()) / nodeNum << std::endl;
+
+  Simulator::Destroy ();
+}
+
+int main (int argc, char *argv[])
+{
+  std::string sizes = "100,1000,10000,20000,50000";
+  double spacing = 15;
+  std::string linkBudget = "None";
+  bool extended = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("sizes", "comma separated node counts", sizes);
+  cmd.AddValue ("spacing", "grid spacing in meters", spacing);
+  cmd.AddValue ("linkBudget", "None, or the link budget Mode to precompute (Dense/Sparse)", linkBudget);
+  cmd.AddValue ("extended", "use extended addressing, needed beyond 65533 nodes", extended);
+  cmd.Parse (argc, argv);
+
+  std::cout << "nodes,setup_ms,setup_us_per_node,rss_kib,rss_bytes_per_node,links,budget_bytes_per_node" << std::endl;
+
+  std::istringstream list (sizes);
+  std::string item;
+  while (std::getline (list, item, ','))
+    {
+      uint32_t nodeNum = std::stoul (item);
+      uint32_t maxNodes = extended ? ClusterTreeNetwork::MAX_EXTENDED_NODES : ClusterTreeNetwork::MAX_SHORT_NODES;
+      NS_ABORT_MSG_IF (nodeNum == 0 || nodeNum > maxNodes,
+                       "unsupported node count " << nodeNum);
+      std::cout.flush ();
+      pid_t pid = fork ();
+      if (pid == 0)
+        {
+          RunOne (nodeNum, spacing, linkBudget, extended);
+          std::cout.flush ();
+          _exit (0);
+        }
+      int status = 0;
+      waitpid (pid, &status, 0);
+    }
+  return 0;
+}
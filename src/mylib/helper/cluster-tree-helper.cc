@@ -0,0 +1,448 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/simulator.h>
+#include <ns3/mobility-model.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/propagation-delay-model.h>
+#include <ns3/single-model-spectrum-channel.h>
+#include <ns3/lr-wpan-net-device.h>
+#include <ns3/string.h>
+#include <ns3/energy-source.h>
+#include "ns3/cluster-admission-policy.h"
+#include "ns3/cluster-link-budget.h"
+#include "ns3/cluster-event-tracer.h"
+#include "ns3/cluster-parent-selector.h"
+#include "ns3/cluster-slotted-mac.h"
+#include "ns3/cluster-channel-plan.h"
+#include "ns3/cluster-culled-spectrum-channel.h"
+#include "ns3/cluster-radio-energy-model.h"
+#include "ns3/cluster-tree-network.h"
+#include "ns3/cluster-tree-phy.h"
+#include "ns3/cluster-tree-protocol.h"
+#include "ns3/cluster-tree-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterTreeHelper");
+
+ClusterTreeHelper::ClusterTreeHelper ()
+  : m_energy (false),
+    m_tracing (false),
+    m_slottedEnabled (false),
+    m_channelPlanEnabled (false)
+{
+  // 信号以2.5为指数衰减，在1米处的衰减为46.6777dB
+  Ptr<LogDistancePropagationLossModel> logModel = CreateObject<LogDistancePropagationLossModel> ();
+  logModel->SetPathLossExponent (2.5);
+  logModel->SetReference (1, 46.6777);
+  m_loss = logModel;
+
+  Ptr<ConstantSpeedPropagationDelayModel> delayModel = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  delayModel->SetSpeed (299792458);
+
+  m_channel = CreateObject<SingleModelSpectrumChannel> ();
+  m_channel->AddPropagationLossModel (m_loss);
+  m_channel->SetPropagationDelayModel (delayModel);
+
+  m_protocolFactory.SetTypeId ("ns3::ClusterTreeProtocol");
+  m_networkFactory.SetTypeId ("ns3::ClusterTreeNetwork");
+  m_linkBudgetFactory.SetTypeId ("ns3::ClusterLinkBudget");
+  m_tracerFactory.SetTypeId ("ns3::ClusterEventTracer");
+  m_selectorFactory.SetTypeId ("ns3::ClusterWeightedParentSelector");
+  m_admissionFactory.SetTypeId ("ns3::ClusterAdmissionPolicy");
+  m_slottedFactory.SetTypeId ("ns3::ClusterSlottedMac");
+  m_channelPlanFactory.SetTypeId ("ns3::ClusterChannelPlan");
+  m_energySourceFactory.SetTypeId ("ns3::BasicEnergySource");
+  m_radioEnergyFactory.SetTypeId ("ns3::ClusterRadioEnergyModel");
+}
+
+ClusterTreeHelper::~ClusterTreeHelper ()
+{
+  m_channel = 0;
+  m_loss = 0;
+  m_network = 0;
+  m_radioModels.clear ();
+}
+
+void
+ClusterTreeHelper::SetChannel (Ptr<SpectrumChannel> channel, Ptr<PropagationLossModel> loss)
+{
+  m_channel = channel;
+  m_loss = loss;
+}
+
+Ptr<SpectrumChannel>
+ClusterTreeHelper::GetChannel (void) const
+{
+  return m_channel;
+}
+
+Ptr<PropagationLossModel>
+ClusterTreeHelper::GetPropagationLossModel (void) const
+{
+  return m_loss;
+}
+
+Ptr<ClusterCulledSpectrumChannel>
+ClusterTreeHelper::EnableCulledChannel (void)
+{
+  NS_ABORT_MSG_IF (m_network, "EnableCulledChannel must be called before Install");
+  Ptr<ConstantSpeedPropagationDelayModel> delayModel = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  delayModel->SetSpeed (299792458);
+
+  Ptr<ClusterCulledSpectrumChannel> channel = CreateObject<ClusterCulledSpectrumChannel> ();
+  channel->AddPropagationLossModel (m_loss);
+  channel->SetPropagationDelayModel (delayModel);
+  m_channel = channel;
+  return channel;
+}
+
+void
+ClusterTreeHelper::SetProtocolAttribute (std::string name, const AttributeValue &value)
+{
+  m_protocolFactory.Set (name, value);
+}
+
+void
+ClusterTreeHelper::SetNetworkAttribute (std::string name, const AttributeValue &value)
+{
+  m_networkFactory.Set (name, value);
+}
+
+void
+ClusterTreeHelper::SetLinkBudgetAttribute (std::string name, const AttributeValue &value)
+{
+  m_linkBudgetFactory.Set (name, value);
+}
+
+void
+ClusterTreeHelper::EnableEventTracer (std::string fileName)
+{
+  NS_ABORT_MSG_IF (m_network != 0, "enable the event tracer before Install");
+  m_tracerFactory.Set ("FileName", StringValue (fileName));
+  m_tracing = true;
+}
+
+void
+ClusterTreeHelper::SetEventTracerAttribute (std::string name, const AttributeValue &value)
+{
+  m_tracerFactory.Set (name, value);
+}
+
+void
+ClusterTreeHelper::SetParentSelector (std::string type)
+{
+  m_selectorFactory.SetTypeId (type);
+}
+
+void
+ClusterTreeHelper::SetParentSelectorAttribute (std::string name, const AttributeValue &value)
+{
+  m_selectorFactory.Set (name, value);
+}
+
+void
+ClusterTreeHelper::SetAdmissionPolicyAttribute (std::string name, const AttributeValue &value)
+{
+  m_admissionFactory.Set (name, value);
+}
+
+void
+ClusterTreeHelper::SetSlottedMacAttribute (std::string name, const AttributeValue &value)
+{
+  m_slottedFactory.Set (name, value);
+}
+
+void
+ClusterTreeHelper::SetChannelPlanAttribute (std::string name, const AttributeValue &value)
+{
+  m_channelPlanFactory.Set (name, value);
+}
+
+void
+ClusterTreeHelper::EnableEnergy (void)
+{
+  NS_ABORT_MSG_IF (m_network != 0, "enable energy before Install");
+  m_energy = true;
+}
+
+void
+ClusterTreeHelper::SetEnergySourceAttribute (std::string name, const AttributeValue &value)
+{
+  m_energySourceFactory.Set (name, value);
+}
+
+void
+ClusterTreeHelper::SetRadioEnergyModelAttribute (std::string name, const AttributeValue &value)
+{
+  m_radioEnergyFactory.Set (name, value);
+}
+
+NetDeviceContainer
+ClusterTreeHelper::Install (NodeContainer c)
+{
+  NS_ABORT_MSG_IF (m_network != 0, "ClusterTreeHelper::Install may only be called once");
+  m_network = m_networkFactory.Create<ClusterTreeNetwork> ();
+  NS_ABORT_MSG_IF (c.GetN () > m_network->GetMaxNodes (),
+                   "too many nodes for the addressing mode: " << c.GetN ());
+  bool extended = m_network->IsExtendedAddressing ();
+  m_network->SetLinkBudget (m_linkBudgetFactory.Create<ClusterLinkBudget> ());
+  m_network->SetPropagationLossModel (m_loss);
+  if (m_tracing)
+    {
+      m_network->SetEventTracer (m_tracerFactory.Create<ClusterEventTracer> ());
+    }
+  // 打分不带状态，全网共用一个
+  Ptr<ClusterParentSelector> selector = m_selectorFactory.Create<ClusterParentSelector> ();
+
+  NetDeviceContainer devices;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      Ptr<MobilityModel> position = node->GetObject<MobilityModel> ();
+      NS_ABORT_MSG_UNLESS (position, "cluster tree nodes need a MobilityModel");
+
+      Ptr<ClusterTreeProtocol> protocol = m_protocolFactory.Create<ClusterTreeProtocol> ();
+      // 太弱的帧在PHY就丢掉，不再解码、回ACK后才在协议里丢
+      Ptr<ClusterTreePhy> phy = CreateObject<ClusterTreePhy> ();
+      phy->SetRxSensitivity (protocol->GetRxSensitivity ());
+      Ptr<LrWpanNetDevice> dev = CreateObject<LrWpanNetDevice> ();
+      dev->SetPhy (phy);
+      dev->SetChannel (m_channel);
+      node->AddDevice (dev);
+      dev->SetNode (node);
+      dev->GetPhy ()->SetMobility (position);
+
+      Ptr<LrWpanMac> mac = dev->GetMac ();
+      uint32_t index = m_network->AddNode (node, mac);
+      if (extended)
+        {
+          // ff:fe表示没有短地址，只用扩展地址通信
+          mac->SetShortAddress (Mac16Address ("ff:fe"));
+          mac->SetExtendedAddress (ClusterTreeNetwork::IndexToExtendedAddress (index));
+        }
+      else
+        {
+          mac->SetShortAddress (ClusterTreeNetwork::IndexToAddress (index));
+        }
+
+      protocol->SetParentSelector (selector);
+      if (index == ClusterTreeNetwork::COORDINATOR_INDEX)
+        {
+          protocol->SetAdmissionPolicy (m_admissionFactory.Create<ClusterAdmissionPolicy> ());
+        }
+      protocol->Setup (dev, m_network, index);
+      node->AggregateObject (protocol);
+      devices.Add (dev);
+
+      // Coor接电源，其余节点装电池，收发机的状态决定耗电
+      m_radioModels.push_back (0);
+      if (m_energy && index != ClusterTreeNetwork::COORDINATOR_INDEX)
+        {
+          Ptr<EnergySource> source = m_energySourceFactory.Create<EnergySource> ();
+          source->SetNode (node);
+          node->AggregateObject (source);
+          Ptr<ClusterRadioEnergyModel> radio = m_radioEnergyFactory.Create<ClusterRadioEnergyModel> ();
+          radio->SetEnergySource (source);
+          source->AppendDeviceEnergyModel (radio);
+          radio->AttachPhy (phy);
+          radio->SetEnergyDepletionCallback (MakeCallback (&ClusterTreeProtocol::EnergyDepleted, protocol));
+          protocol->SetEnergySource (source);
+          m_radioModels.back () = radio;
+        }
+    }
+  return devices;
+}
+
+Ptr<ClusterTreeNetwork>
+ClusterTreeHelper::GetNetwork (void) const
+{
+  return m_network;
+}
+
+Ptr<ClusterTreeProtocol>
+ClusterTreeHelper::GetProtocol (uint32_t index) const
+{
+  return m_network->GetNode (index)->GetObject<ClusterTreeProtocol> ();
+}
+
+Ptr<EnergySource>
+ClusterTreeHelper::GetEnergySource (uint32_t index) const
+{
+  return m_network->GetNode (index)->GetObject<EnergySource> ();
+}
+
+Ptr<ClusterRadioEnergyModel>
+ClusterTreeHelper::GetRadioEnergyModel (uint32_t index) const
+{
+  if (index >= m_radioModels.size ())
+    {
+      return 0;
+    }
+  return m_radioModels[index];
+}
+
+void
+ClusterTreeHelper::PrintEnergy (std::ostream &os) const
+{
+  NS_ASSERT (m_network != 0);
+  os << "node,residual_j,consumed_j,depleted" << std::endl;
+  for (uint32_t i = 0; i < m_network->GetN (); ++i)
+    {
+      Ptr<EnergySource> source = GetEnergySource (i);
+      Ptr<ClusterRadioEnergyModel> radio = GetRadioEnergyModel (i);
+      if (source == 0 || radio == 0)
+        {
+          continue;
+        }
+      os << i << "," << source->GetRemainingEnergy () << "," << radio->GetTotalEnergyConsumption ()
+         << "," << GetProtocol (i)->IsDepleted () << std::endl;
+    }
+}
+
+int64_t
+ClusterTreeHelper::AssignStreams (int64_t stream)
+{
+  NS_ASSERT (m_network != 0);
+  int64_t currentStream = stream;
+  for (uint32_t i = 0; i < m_network->GetN (); ++i)
+    {
+      currentStream += GetProtocol (i)->AssignStreams (currentStream);
+    }
+  return currentStream - stream;
+}
+
+void
+ClusterTreeHelper::StartFormation (Time start)
+{
+  NS_ASSERT (m_network != 0);
+  uint32_t coordinator = ClusterTreeNetwork::COORDINATOR_INDEX;
+  Simulator::ScheduleWithContext (m_network->GetNode (coordinator)->GetId (), start,
+                                  &ClusterTreeProtocol::StartFormation, GetProtocol (coordinator));
+}
+
+void
+ClusterTreeHelper::ScheduleConvergecast (Time start, Time spacing, uint32_t size)
+{
+  NS_ASSERT (m_network != 0);
+  Time sendTime = start;
+  for (uint32_t i = 1; i < m_network->GetN (); ++i)
+    {
+      Ptr<ClusterTreeProtocol> protocol = GetProtocol (i);
+      // SendData is resolved against the father the node has at send time
+      Simulator::ScheduleWithContext (m_network->GetNode (i)->GetId (), sendTime,
+                                      &ClusterTreeProtocol::SendData, protocol, Create<Packet> (size));
+      sendTime += spacing;
+    }
+}
+
+void
+ClusterTreeHelper::EnableSlottedConvergecast (Time at, uint32_t cellsPerNode)
+{
+  NS_ASSERT (m_network != 0);
+  // 时隙层绕过协议直接调信道、交帧，和信道规划的排队切信道会互相打乱
+  NS_ABORT_MSG_IF (m_channelPlanEnabled, "slotted convergecast cannot be combined with a channel plan");
+  m_slottedEnabled = true;
+  Simulator::Schedule (at, &ClusterTreeHelper::InstallSchedule, this, cellsPerNode);
+}
+
+const ClusterConvergecastSchedule &
+ClusterTreeHelper::GetSchedule (void) const
+{
+  return m_schedule;
+}
+
+Ptr<ClusterChannelPlan>
+ClusterTreeHelper::EnableChannelPlan (Time at)
+{
+  NS_ASSERT (m_network != 0);
+  NS_ABORT_MSG_IF (m_slottedEnabled, "a channel plan cannot be combined with slotted convergecast");
+  m_channelPlanEnabled = true;
+  Ptr<ClusterChannelPlan> plan = m_channelPlanFactory.Create<ClusterChannelPlan> ();
+  Simulator::Schedule (at, &ClusterTreeHelper::InstallChannelPlan, this, plan);
+  return plan;
+}
+
+void
+ClusterTreeHelper::InstallChannelPlan (Ptr<ClusterChannelPlan> plan)
+{
+  // 和时隙表一样由全局算好直接装上，不模拟下发
+  std::vector<uint32_t> fathers (m_network->GetN (), ClusterTreeNetwork::NO_NODE);
+  for (uint32_t i = 0; i < m_network->GetN (); ++i)
+    {
+      Ptr<ClusterTreeProtocol> protocol = GetProtocol (i);
+      if (protocol->IsJoined () && !protocol->IsCoordinator ())
+        {
+          fathers[i] = protocol->GetFather ();
+        }
+    }
+  double txPowerDbm = GetProtocol (ClusterTreeNetwork::COORDINATOR_INDEX)->GetTxPower ();
+  plan->Build (m_network, fathers, txPowerDbm);
+  m_network->SetChannelPlan (plan);
+  for (uint32_t i = 0; i < m_network->GetN (); ++i)
+    {
+      GetProtocol (i)->ApplyChannelPlan ();
+    }
+}
+
+void
+ClusterTreeHelper::InstallSchedule (uint32_t cellsPerNode)
+{
+  // Coor手里有整棵树，这里直接照各节点的父亲算表、发给大家，没模拟下发的帧
+  std::vector<uint32_t> fathers (m_network->GetN (), ClusterTreeNetwork::NO_NODE);
+  std::vector<Ptr<ClusterSlottedMac> > slotted (m_network->GetN ());
+  for (uint32_t i = 0; i < m_network->GetN (); ++i)
+    {
+      Ptr<ClusterTreeProtocol> protocol = GetProtocol (i);
+      // 重装时表换了，沿用已经聚合在节点上的时隙层，不能再聚合一个
+      Ptr<ClusterSlottedMac> mac = m_network->GetNode (i)->GetObject<ClusterSlottedMac> ();
+      if (!protocol->IsJoined ())
+        {
+          if (mac != 0)
+            {
+              mac->Stop ();
+              protocol->SetSlottedMac (0);
+            }
+          continue;
+        }
+      if (!protocol->IsCoordinator ())
+        {
+          fathers[i] = protocol->GetFather ();
+        }
+      if (mac == 0)
+        {
+          mac = m_slottedFactory.Create<ClusterSlottedMac> ();
+          mac->Setup (protocol->GetDevice (), i);
+          m_network->GetNode (i)->AggregateObject (mac);
+        }
+      slotted[i] = mac;
+    }
+  Ptr<ClusterSlottedMac> coordinator = slotted[ClusterTreeNetwork::COORDINATOR_INDEX];
+  m_schedule.Build (fathers, cellsPerNode, coordinator->GetNChannels ());
+  NS_LOG_INFO ("slotframe of " << m_schedule.GetSlotframeLength () << " slots, "
+                               << m_schedule.GetCells ().size () << " cells");
+  for (uint32_t i = 0; i < m_network->GetN (); ++i)
+    {
+      if (slotted[i] != 0)
+        {
+          slotted[i]->Start (m_schedule, Simulator::Now ());
+          GetProtocol (i)->SetSlottedMac (slotted[i]);
+        }
+    }
+}
+
+}
@@ -0,0 +1,292 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_TREE_HELPER_H
+#define CLUSTER_TREE_HELPER_H
+
+#include <ns3/node-container.h>
+#include <ns3/net-device-container.h>
+#include <ns3/object-factory.h>
+#include <ns3/nstime.h>
+#include "ns3/cluster-convergecast-schedule.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class SpectrumChannel;
+class PropagationLossModel;
+class ClusterTreeNetwork;
+class ClusterTreeProtocol;
+class ClusterChannelPlan;
+class ClusterCulledSpectrumChannel;
+class ClusterRadioEnergyModel;
+class EnergySource;
+
+/**
+ * \ingroup mylib
+ *
+ * Builds a cluster tree: one LrWpanNetDevice per node on a shared
+ * channel, a short address per node and a ClusterTreeProtocol aggregated
+ * to every node.  The first installed node is the PAN coordinator.
+ * Nodes use short addresses unless the ExtendedAddressing attribute of
+ * the network is set with SetNetworkAttribute.
+ *
+ * By default the channel is a SingleModelSpectrumChannel with a
+ * LogDistancePropagationLossModel (exponent 2.5, 46.6777 dB at 1 m) and
+ * a constant-speed delay model.
+ *
+ * With EnableEnergy every node but the coordinator, which is taken to be
+ * mains powered, gets a BasicEnergySource aggregated to it and a
+ * ClusterRadioEnergyModel following its PHY; a node whose source runs
+ * out is switched off through ClusterTreeProtocol::EnergyDepleted.
+ */
+class ClusterTreeHelper
+{
+public:
+  ClusterTreeHelper ();
+  ~ClusterTreeHelper ();
+
+  /**
+   * Replace the default channel.
+   * \param channel the channel every device attaches to
+   * \param loss the loss model installed on channel, used by the protocol
+   */
+  void SetChannel (Ptr<SpectrumChannel> channel, Ptr<PropagationLossModel> loss);
+  /**
+   * \return the channel devices are attached to
+   */
+  Ptr<SpectrumChannel> GetChannel (void) const;
+  /**
+   * \return the propagation loss model of the channel
+   */
+  Ptr<PropagationLossModel> GetPropagationLossModel (void) const;
+  /**
+   * Replace the channel by a ClusterCulledSpectrumChannel with the same
+   * loss model, so that frames only reach the PHYs they can disturb.
+   * Must be called before Install; set InterferenceFloor and MaxTxPower
+   * on the returned channel.
+   * \return the new channel
+   */
+  Ptr<ClusterCulledSpectrumChannel> EnableCulledChannel (void);
+
+  /**
+   * Set an attribute of every ClusterTreeProtocol created by Install.
+   * \param name attribute name
+   * \param value attribute value
+   */
+  void SetProtocolAttribute (std::string name, const AttributeValue &value);
+  /**
+   * Set an attribute of the ClusterTreeNetwork created by Install.
+   * \param name attribute name
+   * \param value attribute value
+   */
+  void SetNetworkAttribute (std::string name, const AttributeValue &value);
+  /**
+   * Set an attribute of the ClusterLinkBudget created by Install.
+   * \param name attribute name
+   * \param value attribute value
+   */
+  void SetLinkBudgetAttribute (std::string name, const AttributeValue &value);
+  /**
+   * Record the protocol events of the installed tree into a binary
+   * ClusterEventTracer file, to be read back with cluster-trace-decode.
+   * Must be called before Install.
+   * \param fileName the trace file
+   */
+  void EnableEventTracer (std::string fileName);
+  /**
+   * Set an attribute of the ClusterEventTracer created by Install.
+   * \param name attribute name
+   * \param value attribute value
+   */
+  void SetEventTracerAttribute (std::string name, const AttributeValue &value);
+  /**
+   * Choose the ClusterParentSelector subclass that ranks candidate
+   * fathers, ns3::ClusterWeightedParentSelector by default.  Install
+   * creates one, shared by every node.
+   * \param type TypeId name of the selector
+   */
+  void SetParentSelector (std::string type);
+  /**
+   * Set an attribute of the ClusterParentSelector created by Install.
+   * \param name attribute name
+   * \param value attribute value
+   */
+  void SetParentSelectorAttribute (std::string name, const AttributeValue &value);
+  /**
+   * Set an attribute of the ClusterAdmissionPolicy Install gives the
+   * coordinator, e.g. MaxChildren, MaxDepth or MaxSubtreeLoad.
+   * \param name attribute name
+   * \param value attribute value
+   */
+  void SetAdmissionPolicyAttribute (std::string name, const AttributeValue &value);
+  /**
+   * Set an attribute of the ClusterSlottedMac created by
+   * EnableSlottedConvergecast.
+   * \param name attribute name
+   * \param value attribute value
+   */
+  void SetSlottedMacAttribute (std::string name, const AttributeValue &value);
+  /**
+   * Set an attribute of the ClusterChannelPlan created by
+   * EnableChannelPlan, e.g. Channels.
+   * \param name attribute name
+   * \param value attribute value
+   */
+  void SetChannelPlanAttribute (std::string name, const AttributeValue &value);
+  /**
+   * Give every node but the coordinator a battery and a radio energy
+   * model.  Must be called before Install.
+   */
+  void EnableEnergy (void);
+  /**
+   * Set an attribute of the BasicEnergySource created by Install, e.g.
+   * BasicEnergySourceInitialEnergyJ.
+   * \param name attribute name
+   * \param value attribute value
+   */
+  void SetEnergySourceAttribute (std::string name, const AttributeValue &value);
+  /**
+   * Set an attribute of the ClusterRadioEnergyModel created by Install,
+   * e.g. ListenCurrentA.
+   * \param name attribute name
+   * \param value attribute value
+   */
+  void SetRadioEnergyModelAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * Install devices and the protocol on nodes, which must already carry
+   * a MobilityModel.  May be called once per helper.  Each device gets a
+   * ClusterTreePhy ignoring frames below the protocol's RxSensitivity.
+   * \param c the nodes, the first one becomes the coordinator
+   * \return the installed devices, in node index order
+   */
+  NetDeviceContainer Install (NodeContainer c);
+
+  /**
+   * \return the state shared by the installed tree
+   */
+  Ptr<ClusterTreeNetwork> GetNetwork (void) const;
+  /**
+   * \param index node index
+   * \return the protocol of that node
+   */
+  Ptr<ClusterTreeProtocol> GetProtocol (uint32_t index) const;
+  /**
+   * \param index node index
+   * \return the battery of that node, null without EnableEnergy and for
+   * the coordinator
+   */
+  Ptr<EnergySource> GetEnergySource (uint32_t index) const;
+  /**
+   * \param index node index
+   * \return the radio energy model of that node, null without
+   * EnableEnergy and for the coordinator
+   */
+  Ptr<ClusterRadioEnergyModel> GetRadioEnergyModel (uint32_t index) const;
+  /**
+   * Write one CSV line per battery powered node:
+   * node,residual_j,consumed_j,depleted, after a header line.
+   * \param os the output stream
+   */
+  void PrintEnergy (std::ostream &os) const;
+
+  /**
+   * Assign fixed random variable streams to the protocols of the
+   * installed tree, one per node in index order.
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * Schedule the coordinator beacon that starts formation.
+   * \param start formation start time
+   */
+  void StartFormation (Time start);
+  /**
+   * Schedule one reading per non-coordinator node, node i sending at
+   * start + (i - 1) * spacing.
+   * \param start send time of node 1
+   * \param spacing delay between two consecutive nodes
+   * \param size payload size in bytes
+   */
+  void ScheduleConvergecast (Time start, Time spacing, uint32_t size);
+  /**
+   * At time at, once the tree is formed, compute the
+   * ClusterConvergecastSchedule of the joined nodes and make every one of
+   * them send its data in its cells, through a ClusterSlottedMac
+   * aggregated to the node.  Slot 0
+   * starts at at.  Nodes that join later, or change father, keep sending
+   * data with CSMA-CA, and so do nodes after ClusterTreeProtocol::Reset.
+   * Calling it again, e.g. after rebuilding the tree, installs a new
+   * schedule on the ClusterSlottedMac already aggregated to each node.
+   * Cells drive the MAC and PHY directly, so this aborts if
+   * EnableChannelPlan was called too.  The helper must outlive at.
+   * \param at schedule computation time
+   * \param cellsPerNode cells per slotframe per node of a subtree
+   */
+  void EnableSlottedConvergecast (Time at, uint32_t cellsPerNode);
+  /**
+   * \return the schedule computed by EnableSlottedConvergecast, empty before
+   */
+  const ClusterConvergecastSchedule &GetSchedule (void) const;
+  /**
+   * At time at, once the tree is formed, colour the clusters of the
+   * joined nodes over the channels of a ClusterChannelPlan and tune every
+   * node to its listen channel.  Aborts if EnableSlottedConvergecast was
+   * called too, as both retune the PHY.  The helper must outlive at.
+   * \param at plan computation time
+   * \return the plan, built at at
+   */
+  Ptr<ClusterChannelPlan> EnableChannelPlan (Time at);
+
+private:
+  /**
+   * Compute and install the slotted convergecast schedule.
+   * \param cellsPerNode cells per slotframe per node of a subtree
+   */
+  void InstallSchedule (uint32_t cellsPerNode);
+  /**
+   * Build the channel plan and tune the joined nodes.
+   * \param plan the plan set on the network
+   */
+  void InstallChannelPlan (Ptr<ClusterChannelPlan> plan);
+
+  Ptr<SpectrumChannel> m_channel;         //!< shared channel
+  Ptr<PropagationLossModel> m_loss;       //!< loss model of m_channel
+  ObjectFactory m_protocolFactory;        //!< creates ClusterTreeProtocol
+  ObjectFactory m_networkFactory;         //!< creates ClusterTreeNetwork
+  ObjectFactory m_linkBudgetFactory;      //!< creates ClusterLinkBudget
+  ObjectFactory m_tracerFactory;          //!< creates ClusterEventTracer
+  ObjectFactory m_selectorFactory;        //!< creates the ClusterParentSelector
+  ObjectFactory m_admissionFactory;       //!< creates the coordinator's ClusterAdmissionPolicy
+  ObjectFactory m_slottedFactory;         //!< creates ClusterSlottedMac
+  ObjectFactory m_channelPlanFactory;     //!< creates ClusterChannelPlan
+  ObjectFactory m_energySourceFactory;    //!< creates BasicEnergySource
+  ObjectFactory m_radioEnergyFactory;     //!< creates ClusterRadioEnergyModel
+  bool m_energy;                          //!< install batteries in Install
+  std::vector<Ptr<ClusterRadioEnergyModel> > m_radioModels; //!< per node index, null for the coordinator
+  ClusterConvergecastSchedule m_schedule; //!< slotted convergecast schedule
+  bool m_tracing;                         //!< create a tracer in Install
+  bool m_slottedEnabled;                  //!< EnableSlottedConvergecast was called
+  bool m_channelPlanEnabled;              //!< EnableChannelPlan was called
+  Ptr<ClusterTreeNetwork> m_network;      //!< installed tree
+};
+
+}
+#endif /* CLUSTER_TREE_HELPER_H */
@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/uinteger.h>
+#include "ns3/cluster-admission-policy.h"
+#include "ns3/cluster-tree-network.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterAdmissionPolicy");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterAdmissionPolicy);
+
+TypeId
+ClusterAdmissionPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterAdmissionPolicy")
+    .SetParent<Object> ()
+    .AddConstructor<ClusterAdmissionPolicy> ()
+    .AddAttribute ("MaxChildren",
+                   "Children the coordinator lets any node adopt; 0 for any number.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&ClusterAdmissionPolicy::m_maxChildren),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxDepth",
+                   "Deepest cluster id the coordinator admits; 0 for any depth.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&ClusterAdmissionPolicy::m_maxDepth),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("MaxSubtreeLoad",
+                   "Nodes allowed in the subtree of one child of the coordinator, "
+                   "which all reach the coordinator through that child; 0 for any number.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&ClusterAdmissionPolicy::m_maxSubtreeLoad),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+ClusterAdmissionPolicy::ClusterAdmissionPolicy ()
+  : m_maxChildren (0),
+    m_maxDepth (0),
+    m_maxSubtreeLoad (0)
+{
+  Reset ();
+}
+
+ClusterAdmissionPolicy::~ClusterAdmissionPolicy ()
+{
+}
+
+void
+ClusterAdmissionPolicy::DoDispose (void)
+{
+  m_records.clear ();
+  m_children.clear ();
+  Object::DoDispose ();
+}
+
+void
+ClusterAdmissionPolicy::Reset (void)
+{
+  m_records.clear ();
+  m_children.clear ();
+  Record &root = GetRecord (ClusterTreeNetwork::COORDINATOR_INDEX);
+  root.known = true;
+}
+
+ClusterAdmissionPolicy::Record &
+ClusterAdmissionPolicy::GetRecord (uint32_t node)
+{
+  if (node >= m_records.size ())
+    {
+      Record unknown;
+      unknown.father = ClusterTreeNetwork::NO_NODE;
+      unknown.branch = ClusterTreeNetwork::NO_NODE;
+      unknown.subtree = 1;
+      unknown.depth = 0;
+      unknown.known = false;
+      m_records.resize (node + 1, unknown);
+      m_children.resize (node + 1);
+    }
+  return m_records[node];
+}
+
+bool
+ClusterAdmissionPolicy::IsKnown (uint32_t node) const
+{
+  return node < m_records.size () && m_records[node].known;
+}
+
+uint16_t
+ClusterAdmissionPolicy::GetDepth (uint32_t node) const
+{
+  return m_records[node].depth;
+}
+
+uint32_t
+ClusterAdmissionPolicy::GetNChildren (uint32_t node) const
+{
+  return m_children[node].size ();
+}
+
+uint32_t
+ClusterAdmissionPolicy::GetSubtreeSize (uint32_t node) const
+{
+  return m_records[node].subtree;
+}
+
+bool
+ClusterAdmissionPolicy::CanAdmit (uint32_t father, uint32_t child) const
+{
+  if (!IsKnown (father))
+    {
+      // Coor不认识的父亲没法判断，照旧放行
+      return true;
+    }
+  const Record &f = m_records[father];
+  bool childKnown = IsKnown (child);
+  if (childKnown && m_records[child].father == father)
+    {
+      return true;
+    }
+  if (m_maxChildren != 0 && m_children[father].size () >= m_maxChildren)
+    {
+      return false;
+    }
+  if (m_maxDepth != 0 && f.depth >= m_maxDepth)
+    {
+      return false;
+    }
+  if (m_maxSubtreeLoad != 0)
+    {
+      // 带着子树来的按整棵子树算；在同一支里挪动不增加这一支的负载
+      uint32_t load = child < m_records.size () ? m_records[child].subtree : 1;
+      if (father == ClusterTreeNetwork::COORDINATOR_INDEX)
+        {
+          return load <= m_maxSubtreeLoad;
+        }
+      if (childKnown && m_records[child].branch == f.branch)
+        {
+          return true;
+        }
+      return m_records[f.branch].subtree + load <= m_maxSubtreeLoad;
+    }
+  return true;
+}
+
+void
+ClusterAdmissionPolicy::Admit (uint32_t father, uint32_t child)
+{
+  if (!IsKnown (father) || father == child)
+    {
+      return;
+    }
+  GetRecord (std::max (father, child));
+  Record &c = m_records[child];
+  if (c.known)
+    {
+      if (c.father == father)
+        {
+          return;
+        }
+      for (uint32_t a = father; a != ClusterTreeNetwork::NO_NODE; a = m_records[a].father)
+        {
+          if (a == child)
+            {
+              NS_LOG_WARN ("node " << father << " is below " << child << ", not recorded");
+              return;
+            }
+        }
+      // 换父亲：整棵子树从原来的祖先那里减掉
+      std::vector<uint32_t> &siblings = m_children[c.father];
+      siblings.erase (std::find (siblings.begin (), siblings.end (), child));
+      for (uint32_t a = c.father; a != ClusterTreeNetwork::NO_NODE; a = m_records[a].father)
+        {
+          m_records[a].subtree -= c.subtree;
+        }
+    }
+  c.known = true;
+  c.father = father;
+  c.depth = m_records[father].depth + 1;
+  m_children[father].push_back (child);
+  for (uint32_t a = father; a != ClusterTreeNetwork::NO_NODE; a = m_records[a].father)
+    {
+      m_records[a].subtree += c.subtree;
+    }
+  uint32_t branch = father == ClusterTreeNetwork::COORDINATOR_INDEX ? child : m_records[father].branch;
+  if (c.branch != branch)
+    {
+      SetBranch (child, branch);
+    }
+}
+
+void
+ClusterAdmissionPolicy::Detach (uint32_t father, uint32_t child)
+{
+  if (!IsKnown (child) || m_records[child].father != father)
+    {
+      // 早就换到别的父亲下面了，旧父亲报得晚
+      return;
+    }
+  Record &c = m_records[child];
+  std::vector<uint32_t> &siblings = m_children[father];
+  siblings.erase (std::find (siblings.begin (), siblings.end (), child));
+  for (uint32_t a = father; a != ClusterTreeNetwork::NO_NODE; a = m_records[a].father)
+    {
+      m_records[a].subtree -= c.subtree;
+    }
+  c.known = false;
+  c.father = ClusterTreeNetwork::NO_NODE;
+}
+
+void
+ClusterAdmissionPolicy::SetBranch (uint32_t node, uint32_t branch)
+{
+  // 只在子树换到另一支时走一遍，新加的叶子就是它自己
+  std::vector<uint32_t> stack (1, node);
+  while (!stack.empty ())
+    {
+      uint32_t n = stack.back ();
+      stack.pop_back ();
+      m_records[n].branch = branch;
+      stack.insert (stack.end (), m_children[n].begin (), m_children[n].end ());
+    }
+}
+
+uint32_t
+ClusterAdmissionPolicy::FindAlternative (uint32_t child, const std::vector<uint32_t> &candidates) const
+{
+  uint32_t best = ClusterTreeNetwork::NO_NODE;
+  for (uint32_t i = 0; i < candidates.size (); ++i)
+    {
+      uint32_t n = candidates[i];
+      // 带子树的节点不往自己那一支里指，免得接到自己的子树上成环
+      if (n == child || !IsKnown (n) || !CanAdmit (n, child)
+          || (IsKnown (child) && m_records[child].subtree > 1 && m_records[n].branch == m_records[child].branch))
+        {
+          continue;
+        }
+      if (best == ClusterTreeNetwork::NO_NODE)
+        {
+          best = n;
+          continue;
+        }
+      const Record &r = m_records[n];
+      const Record &b = m_records[best];
+      uint32_t load = n == ClusterTreeNetwork::COORDINATOR_INDEX ? 0 : m_records[r.branch].subtree;
+      uint32_t bestLoad = best == ClusterTreeNetwork::COORDINATOR_INDEX ? 0 : m_records[b.branch].subtree;
+      if (r.depth < b.depth
+          || (r.depth == b.depth && (load < bestLoad
+                                     || (load == bestLoad && m_children[n].size () < m_children[best].size ()))))
+        {
+          best = n;
+        }
+    }
+  return best;
+}
+
+}
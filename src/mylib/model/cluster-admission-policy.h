@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_ADMISSION_POLICY_H
+#define CLUSTER_ADMISSION_POLICY_H
+
+#include <ns3/object.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mylib
+ *
+ * The coordinator's view of the tree, used to accept or refuse each
+ * HEADER_REQUEST_CLUSTER_FOR_CHILD and its own adoptions.
+ *
+ * A father may take a child while it has fewer than MaxChildren
+ * children, the child would sit at most MaxDepth hops deep, and the
+ * branch the child joins (the subtree of one child of the coordinator,
+ * whose traffic shares one link into the coordinator) stays within
+ * MaxSubtreeLoad nodes.  0 lifts a limit.
+ *
+ * Every admitted node records its father, depth, branch, child count and
+ * subtree size, so CanAdmit reads a few counters and never walks the
+ * tree.  Admit adds the new node to the subtree size of each ancestor,
+ * O(depth); a child rejoining with its subtree is moved as a whole, and
+ * relabelled with its new branch when it changes branch.  Descendants of
+ * a moved node keep their depth, as their cluster ids do.  Detach takes
+ * a node that left or fell silent off its father, with its subtree, so
+ * the counters follow departures reported by the fathers.
+ */
+class ClusterAdmissionPolicy : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterAdmissionPolicy ();
+  virtual ~ClusterAdmissionPolicy ();
+
+  /**
+   * Forget every node but the coordinator.
+   */
+  void Reset (void);
+
+  /**
+   * \param father a node of the tree
+   * \param child the node asking to join below it
+   * \return false if adopting child would break a limit
+   */
+  bool CanAdmit (uint32_t father, uint32_t child) const;
+  /**
+   * Record that child joined below father, or moved there with its
+   * subtree.
+   * \param father a node of the tree
+   * \param child the admitted node
+   */
+  void Admit (uint32_t father, uint32_t child);
+  /**
+   * Record that child is no longer below father.  Its subtree stays
+   * attached to it and is moved back in whole if it rejoins.  No-op if
+   * child has moved elsewhere since.
+   * \param father the father reporting the departure
+   * \param child the departed node
+   */
+  void Detach (uint32_t father, uint32_t child);
+  /**
+   * Pick the father a refused child should ask instead: of the candidates
+   * that are in the tree and may admit it, the shallowest, then the one
+   * with the lightest branch, then the one with the fewest children.
+   * \param child the refused node
+   * \param candidates nodes child can hear
+   * \return the chosen candidate, ClusterTreeNetwork::NO_NODE if none fits
+   */
+  uint32_t FindAlternative (uint32_t child, const std::vector<uint32_t> &candidates) const;
+
+  /**
+   * \param node a node index
+   * \return true if node is the coordinator or was admitted
+   */
+  bool IsKnown (uint32_t node) const;
+  /**
+   * \param node a known node
+   * \return its depth, 0 for the coordinator
+   */
+  uint16_t GetDepth (uint32_t node) const;
+  /**
+   * \param node a known node
+   * \return its admitted children
+   */
+  uint32_t GetNChildren (uint32_t node) const;
+  /**
+   * \param node a known node
+   * \return nodes in its subtree, itself included
+   */
+  uint32_t GetSubtreeSize (uint32_t node) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// What the coordinator knows about one node.
+  struct Record
+  {
+    uint32_t father;   //!< father index, NO_NODE for the coordinator and unknown nodes
+    uint32_t branch;   //!< child of the coordinator at the top of its branch
+    uint32_t subtree;  //!< nodes in its subtree, itself included
+    uint16_t depth;    //!< hops from the coordinator
+    bool known;        //!< admitted or the coordinator
+  };
+
+  /**
+   * \param node a node index, the tables grow to hold it
+   * \return its record
+   */
+  Record &GetRecord (uint32_t node);
+  /**
+   * \param node a known node
+   * \param branch the branch node and its subtree now belong to
+   */
+  void SetBranch (uint32_t node, uint32_t branch);
+
+  uint32_t m_maxChildren;     //!< children per node, 0 for any
+  uint16_t m_maxDepth;        //!< deepest admitted node, 0 for any
+  uint32_t m_maxSubtreeLoad;  //!< nodes per branch, 0 for any
+  std::vector<Record> m_records;                  //!< by node index
+  std::vector<std::vector<uint32_t> > m_children; //!< admitted children by node index
+};
+
+}
+#endif /* CLUSTER_ADMISSION_POLICY_H */
@@ -0,0 +1,212 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/double.h>
+#include <ns3/uinteger.h>
+#include "ns3/cluster-tree-network.h"
+#include "ns3/cluster-channel-plan.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterChannelPlan");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterChannelPlan);
+
+namespace {
+
+/// Orders cluster heads by decreasing interference degree.
+struct DegreeGreater
+{
+  const std::vector<std::vector<uint32_t> > *adjacent;  //!< interfering heads per head
+  bool operator() (uint32_t a, uint32_t b) const
+  {
+    return (*adjacent)[a].size () > (*adjacent)[b].size ();
+  }
+};
+
+}
+
+TypeId
+ClusterChannelPlan::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterChannelPlan")
+    .SetParent<Object> ()
+    .AddConstructor<ClusterChannelPlan> ()
+    .AddAttribute ("BaseChannel",
+                   "Channel of nodes outside the plan and of colour 0.",
+                   UintegerValue (11),
+                   MakeUintegerAccessor (&ClusterChannelPlan::m_baseChannel),
+                   MakeUintegerChecker<uint8_t> (11, 26))
+    .AddAttribute ("Channels",
+                   "Channels the clusters are spread over, from BaseChannel up.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&ClusterChannelPlan::m_channels),
+                   MakeUintegerChecker<uint8_t> (1, 16))
+    .AddAttribute ("InterferenceFloor",
+                   "Received power in dBm from which a member of one cluster disturbs another cluster.",
+                   DoubleValue (-100.0),
+                   MakeDoubleAccessor (&ClusterChannelPlan::m_interferenceFloorDbm),
+                   MakeDoubleChecker<double> ())
+  ;
+  return tid;
+}
+
+ClusterChannelPlan::ClusterChannelPlan ()
+  : m_baseChannel (11),
+    m_channels (1),
+    m_interferenceFloorDbm (-100.0),
+    m_nClusters (0),
+    m_nConflicts (0)
+{
+}
+
+ClusterChannelPlan::~ClusterChannelPlan ()
+{
+}
+
+void
+ClusterChannelPlan::Build (Ptr<ClusterTreeNetwork> network, const std::vector<uint32_t> &fathers, double txPowerDbm)
+{
+  NS_ABORT_MSG_IF (m_baseChannel + m_channels - 1 > 26, "channels run past channel 26");
+  uint32_t n = fathers.size ();
+  const uint32_t none = ClusterTreeNetwork::NO_NODE;
+  std::vector<bool> inTree (n, false);
+  std::vector<bool> head (n, false);
+  inTree[ClusterTreeNetwork::COORDINATOR_INDEX] = true;
+  head[ClusterTreeNetwork::COORDINATOR_INDEX] = true;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      if (fathers[i] != none)
+        {
+          inTree[i] = true;
+          head[fathers[i]] = true;
+        }
+    }
+
+  // 冲突图：两个簇里各有一个成员能互相听到，就不能用同一个信道
+  std::vector<std::vector<uint32_t> > adjacent (n);
+  double range = network->GetRange (txPowerDbm, m_interferenceFloorDbm);
+  std::vector<uint32_t> neighbors;
+  for (uint32_t u = 0; u < n; ++u)
+    {
+      if (!inTree[u])
+        {
+          continue;
+        }
+      uint32_t uClusters[2] = { head[u] ? u : none, fathers[u] };
+      network->GetNeighbors (u, range, neighbors);
+      for (std::vector<uint32_t>::iterator v = neighbors.begin (); v != neighbors.end (); ++v)
+        {
+          if (!inTree[*v])
+            {
+              continue;
+            }
+          uint32_t vClusters[2] = { head[*v] ? *v : none, fathers[*v] };
+          for (uint32_t a = 0; a < 2; ++a)
+            {
+              for (uint32_t b = 0; b < 2; ++b)
+                {
+                  if (uClusters[a] != none && vClusters[b] != none && uClusters[a] != vClusters[b])
+                    {
+                      adjacent[uClusters[a]].push_back (vClusters[b]);
+                      adjacent[vClusters[b]].push_back (uClusters[a]);
+                    }
+                }
+            }
+        }
+    }
+  std::vector<uint32_t> heads;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      std::sort (adjacent[i].begin (), adjacent[i].end ());
+      adjacent[i].erase (std::unique (adjacent[i].begin (), adjacent[i].end ()), adjacent[i].end ());
+      if (head[i])
+        {
+          heads.push_back (i);
+        }
+    }
+  DegreeGreater greater;
+  greater.adjacent = &adjacent;
+  std::stable_sort (heads.begin (), heads.end (), greater);
+
+  const uint8_t uncoloured = 0xff;
+  std::vector<uint8_t> colour (n, uncoloured);
+  std::vector<uint32_t> used (m_channels);
+  m_nConflicts = 0;
+  for (std::vector<uint32_t>::iterator h = heads.begin (); h != heads.end (); ++h)
+    {
+      std::fill (used.begin (), used.end (), 0);
+      for (std::vector<uint32_t>::iterator v = adjacent[*h].begin (); v != adjacent[*h].end (); ++v)
+        {
+          if (colour[*v] != uncoloured)
+            {
+              used[colour[*v]]++;
+            }
+        }
+      // 没有空闲的颜色就挑邻居里用得最少的
+      colour[*h] = std::min_element (used.begin (), used.end ()) - used.begin ();
+      m_nConflicts += used[colour[*h]];
+    }
+
+  m_listen.assign (n, m_baseChannel);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      if (head[i])
+        {
+          m_listen[i] = m_baseChannel + colour[i];
+        }
+      else if (inTree[i])
+        {
+          m_listen[i] = m_baseChannel + colour[fathers[i]];
+        }
+    }
+  m_nClusters = heads.size ();
+  NS_LOG_INFO (m_nClusters << " clusters on " << uint32_t (m_channels) << " channels, "
+                           << m_nConflicts << " conflicts left");
+}
+
+bool
+ClusterChannelPlan::IsActive (void) const
+{
+  return m_channels > 1 && !m_listen.empty ();
+}
+
+uint8_t
+ClusterChannelPlan::GetBaseChannel (void) const
+{
+  return m_baseChannel;
+}
+
+uint8_t
+ClusterChannelPlan::GetListenChannel (uint32_t node) const
+{
+  return node < m_listen.size () ? m_listen[node] : m_baseChannel;
+}
+
+uint32_t
+ClusterChannelPlan::GetNClusters (void) const
+{
+  return m_nClusters;
+}
+
+uint32_t
+ClusterChannelPlan::GetNConflicts (void) const
+{
+  return m_nConflicts;
+}
+
+}
@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_CHANNEL_PLAN_H
+#define CLUSTER_CHANNEL_PLAN_H
+
+#include <ns3/object.h>
+#include <vector>
+
+namespace ns3 {
+
+class ClusterTreeNetwork;
+
+/**
+ * \ingroup mylib
+ *
+ * IEEE 802.15.4 channel of every cluster of a formed tree, so that
+ * clusters that can hear each other transmit in parallel.
+ *
+ * A cluster is a cluster head (the coordinator or a node with children)
+ * and its children.  Two clusters interfere when a member of one lies
+ * within InterferenceFloor range of a member of the other.  The
+ * interference graph is coloured greedily, highest degree first, with
+ * Channels colours; when every colour is taken by a neighbour the least
+ * used one is reused.  Cluster colour c runs on BaseChannel + c.
+ *
+ * A cluster head listens on its own cluster's channel and a leaf on its
+ * father's, so a frame to a node is sent on GetListenChannel of that
+ * node: uplink goes out on the father's channel.  Nodes outside the tree
+ * when the plan was built stay on BaseChannel.  A broadcast has no single
+ * listener, so ClusterTreeProtocol repeats it on the listen channel of
+ * each neighbour.
+ */
+class ClusterChannelPlan : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterChannelPlan ();
+  virtual ~ClusterChannelPlan ();
+
+  /**
+   * Colour the clusters of the tree.
+   * \param network the tree
+   * \param fathers father of every node index; ClusterTreeNetwork::NO_NODE
+   *        for the coordinator and for nodes outside the tree
+   * \param txPowerDbm transmit power of the nodes
+   */
+  void Build (Ptr<ClusterTreeNetwork> network, const std::vector<uint32_t> &fathers, double txPowerDbm);
+  /**
+   * \return true once Build ran with more than one channel
+   */
+  bool IsActive (void) const;
+
+  /**
+   * \return channel of nodes outside the plan
+   */
+  uint8_t GetBaseChannel (void) const;
+  /**
+   * \param node a node index
+   * \return channel node listens on
+   */
+  uint8_t GetListenChannel (uint32_t node) const;
+  /**
+   * \return clusters coloured by the last Build
+   */
+  uint32_t GetNClusters (void) const;
+  /**
+   * \return interfering cluster pairs left on the same channel
+   */
+  uint32_t GetNConflicts (void) const;
+
+private:
+  uint8_t m_baseChannel;            //!< colour 0, nodes outside the plan
+  uint8_t m_channels;               //!< colours available
+  double m_interferenceFloorDbm;    //!< received power at which clusters interfere
+  std::vector<uint8_t> m_listen;    //!< listen channel per node index
+  uint32_t m_nClusters;             //!< clusters of the last Build
+  uint32_t m_nConflicts;            //!< same-channel interfering pairs
+};
+
+}
+#endif /* CLUSTER_CHANNEL_PLAN_H */
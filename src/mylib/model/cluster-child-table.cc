@@ -0,0 +1,300 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include "ns3/cluster-child-table.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterChildTable");
+
+ClusterChildTable::ClusterChildTable ()
+  : m_slots (8),
+    m_mask (7),
+    m_shift (29),
+    m_used (0),
+    m_nPending (0)
+{
+}
+
+uint32_t
+ClusterChildTable::Home (uint32_t key) const
+{
+  // Fibonacci hashing spreads consecutive indices over the table
+  return (key * 2654435769u) >> m_shift;
+}
+
+uint32_t
+ClusterChildTable::Find (uint32_t key) const
+{
+  uint32_t slot = Home (key);
+  while (m_slots[slot].state != SLOT_EMPTY)
+    {
+      if (m_slots[slot].key == key)
+        {
+          return slot;
+        }
+      slot = (slot + 1) & m_mask;
+    }
+  return NOT_FOUND;
+}
+
+uint32_t
+ClusterChildTable::Insert (uint32_t key)
+{
+  if ((m_used + 1) * 2 > m_slots.size ())
+    {
+      Grow ();
+    }
+  uint32_t slot = Home (key);
+  while (m_slots[slot].state != SLOT_EMPTY)
+    {
+      slot = (slot + 1) & m_mask;
+    }
+  m_slots[slot].key = key;
+  m_used++;
+  return slot;
+}
+
+void
+ClusterChildTable::Erase (uint32_t slot)
+{
+  uint32_t hole = slot;
+  uint32_t next = (hole + 1) & m_mask;
+  while (m_slots[next].state != SLOT_EMPTY)
+    {
+      // move the entry back unless its home lies between the hole and it
+      uint32_t home = Home (m_slots[next].key);
+      if (((next - home) & m_mask) >= ((next - hole) & m_mask))
+        {
+          m_slots[hole] = m_slots[next];
+          hole = next;
+        }
+      next = (next + 1) & m_mask;
+    }
+  m_slots[hole].state = SLOT_EMPTY;
+  m_used--;
+}
+
+void
+ClusterChildTable::Grow (void)
+{
+  std::vector<Slot> old;
+  old.swap (m_slots);
+  m_slots.resize (old.size () * 2);
+  m_mask = m_slots.size () - 1;
+  m_shift--;
+  NS_LOG_LOGIC ("child table grows to " << m_slots.size () << " slots");
+  for (std::vector<Slot>::const_iterator i = old.begin (); i != old.end (); ++i)
+    {
+      if (i->state == SLOT_EMPTY)
+        {
+          continue;
+        }
+      uint32_t slot = Home (i->key);
+      while (m_slots[slot].state != SLOT_EMPTY)
+        {
+          slot = (slot + 1) & m_mask;
+        }
+      m_slots[slot] = *i;
+    }
+}
+
+void
+ClusterChildTable::LinkChild (uint32_t slot)
+{
+  m_slots[slot].state = SLOT_CHILD;
+  m_slots[slot].childIndex = m_children.size ();
+  m_slots[slot].heard = true;
+  m_children.push_back (m_slots[slot].key);
+}
+
+void
+ClusterChildTable::UnlinkChild (uint32_t slot)
+{
+  uint32_t index = m_slots[slot].childIndex;
+  if (index + 1 != m_children.size ())
+    {
+      m_children[index] = m_children.back ();
+      m_slots[Find (m_children[index])].childIndex = index;
+    }
+  m_children.pop_back ();
+}
+
+bool
+ClusterChildTable::IsChild (uint32_t node) const
+{
+  uint32_t slot = Find (node);
+  return slot != NOT_FOUND && m_slots[slot].state == SLOT_CHILD;
+}
+
+bool
+ClusterChildTable::IsPending (uint32_t node, Time now) const
+{
+  uint32_t slot = Find (node);
+  return slot != NOT_FOUND && m_slots[slot].state == SLOT_PENDING && m_slots[slot].expiry > now;
+}
+
+void
+ClusterChildTable::AddChild (uint32_t node, uint32_t treeAddress)
+{
+  uint32_t key = node;
+  uint32_t slot = Find (key);
+  if (slot == NOT_FOUND)
+    {
+      slot = Insert (key);
+    }
+  else if (m_slots[slot].state == SLOT_CHILD)
+    {
+      return;
+    }
+  else
+    {
+      m_nPending--;
+    }
+  m_slots[slot].treeAddress = treeAddress;
+  LinkChild (slot);
+}
+
+uint32_t
+ClusterChildTable::GetTreeAddress (uint32_t node) const
+{
+  uint32_t slot = Find (node);
+  if (slot == NOT_FOUND || m_slots[slot].state != SLOT_CHILD)
+    {
+      return 0;
+    }
+  return m_slots[slot].treeAddress;
+}
+
+void
+ClusterChildTable::AddPending (uint32_t node, Time expiry)
+{
+  uint32_t key = node;
+  uint32_t slot = Find (key);
+  if (slot == NOT_FOUND)
+    {
+      slot = Insert (key);
+      m_slots[slot].state = SLOT_PENDING;
+      m_nPending++;
+    }
+  else if (m_slots[slot].state == SLOT_CHILD)
+    {
+      return;
+    }
+  m_slots[slot].expiry = expiry;
+}
+
+bool
+ClusterChildTable::PromotePending (uint32_t node, Time now)
+{
+  uint32_t slot = Find (node);
+  if (slot == NOT_FOUND || m_slots[slot].state != SLOT_PENDING || m_slots[slot].expiry <= now)
+    {
+      return false;
+    }
+  m_nPending--;
+  m_slots[slot].treeAddress = 0;
+  LinkChild (slot);
+  return true;
+}
+
+bool
+ClusterChildTable::ExpirePending (uint32_t node, Time now)
+{
+  uint32_t slot = Find (node);
+  if (slot == NOT_FOUND || m_slots[slot].state != SLOT_PENDING || m_slots[slot].expiry > now)
+    {
+      return false;
+    }
+  m_nPending--;
+  Erase (slot);
+  return true;
+}
+
+bool
+ClusterChildTable::Remove (uint32_t node)
+{
+  uint32_t slot = Find (node);
+  if (slot == NOT_FOUND)
+    {
+      return false;
+    }
+  if (m_slots[slot].state == SLOT_CHILD)
+    {
+      UnlinkChild (slot);
+    }
+  else
+    {
+      m_nPending--;
+    }
+  Erase (slot);
+  return true;
+}
+
+void
+ClusterChildTable::MarkHeard (uint32_t node)
+{
+  uint32_t slot = Find (node);
+  if (slot != NOT_FOUND && m_slots[slot].state == SLOT_CHILD)
+    {
+      m_slots[slot].heard = true;
+    }
+}
+
+void
+ClusterChildTable::TakeSilent (std::vector<uint32_t> &silent)
+{
+  for (std::vector<uint32_t>::const_iterator i = m_children.begin (); i != m_children.end (); ++i)
+    {
+      Slot &s = m_slots[Find (*i)];
+      if (!s.heard)
+        {
+          silent.push_back (*i);
+        }
+      s.heard = false;
+    }
+}
+
+void
+ClusterChildTable::Clear (void)
+{
+  m_slots.assign (8, Slot ());
+  m_mask = 7;
+  m_shift = 29;
+  m_used = 0;
+  m_nPending = 0;
+  m_children.clear ();
+}
+
+uint32_t
+ClusterChildTable::GetNChildren (void) const
+{
+  return m_children.size ();
+}
+
+uint32_t
+ClusterChildTable::GetNPending (void) const
+{
+  return m_nPending;
+}
+
+const std::vector<uint32_t> &
+ClusterChildTable::GetChildren (void) const
+{
+  return m_children;
+}
+
+}
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_CHILD_TABLE_H
+#define CLUSTER_CHILD_TABLE_H
+
+#include <ns3/nstime.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mylib
+ *
+ * Children and pending (waiting for the coordinator) children of one
+ * cluster head, keyed by node index (see ClusterTreeNetwork), so short
+ * and extended addressing share the same table.
+ *
+ * Entries live in a flat open-addressing table with linear probing and
+ * backward-shift deletion, kept at most half full, so lookups, inserts
+ * and removals are constant time whatever the fan-out.  Adopted children
+ * are additionally kept in a dense array for iteration.  A pending entry
+ * carries an expiry time and stops counting once it is reached.  Each
+ * child carries a heard flag, so the owner can sweep out the children
+ * that fell silent with one pass per period instead of a timer each.
+ */
+class ClusterChildTable
+{
+public:
+  ClusterChildTable ();
+
+  /**
+   * \param node a node index
+   * \return true if node is an adopted child
+   */
+  bool IsChild (uint32_t node) const;
+  /**
+   * \param node a node index
+   * \param now the current time
+   * \return true if node is pending and has not expired
+   */
+  bool IsPending (uint32_t node, Time now) const;
+
+  /**
+   * Adopt a child, replacing a pending entry for the same node.
+   * \param node the child
+   * \param treeAddress tree address given to the child by delegated
+   * admission, 0 otherwise
+   */
+  void AddChild (uint32_t node, uint32_t treeAddress = 0);
+  /**
+   * \param node an adopted child
+   * \return the tree address recorded by AddChild, 0 if node is not a child
+   */
+  uint32_t GetTreeAddress (uint32_t node) const;
+  /**
+   * Add or refresh a pending child.  No-op if node is already a child.
+   * \param node the waiting child
+   * \param expiry time at which the entry expires
+   */
+  void AddPending (uint32_t node, Time expiry);
+  /**
+   * Turn a live pending entry into a child.
+   * \param node the waiting child
+   * \param now the current time
+   * \return false if node was not pending or had expired
+   */
+  bool PromotePending (uint32_t node, Time now);
+  /**
+   * Drop a pending entry if it has expired.
+   * \param node the waiting child
+   * \param now the current time
+   * \return true if an entry was removed
+   */
+  bool ExpirePending (uint32_t node, Time now);
+  /**
+   * Remove a child or pending entry.
+   * \param node the node to remove
+   * \return true if an entry was removed
+   */
+  bool Remove (uint32_t node);
+  /**
+   * Note that a child was heard from.  No-op for other nodes.
+   * \param node a node index
+   */
+  void MarkHeard (uint32_t node);
+  /**
+   * Collect the children not heard from since they were adopted or since
+   * the previous call, and clear the heard flag of the others.
+   * \param silent receives the silent children
+   */
+  void TakeSilent (std::vector<uint32_t> &silent);
+  /**
+   * Remove every entry.
+   */
+  void Clear (void);
+
+  /**
+   * \return the number of adopted children
+   */
+  uint32_t GetNChildren (void) const;
+  /**
+   * \return the number of pending entries, including expired ones not
+   * yet removed
+   */
+  uint32_t GetNPending (void) const;
+  /**
+   * \return the adopted children, in no particular order
+   */
+  const std::vector<uint32_t> &GetChildren (void) const;
+
+private:
+  /// Slot state.
+  enum SlotState
+  {
+    SLOT_EMPTY = 0,
+    SLOT_CHILD,
+    SLOT_PENDING
+  };
+
+  /// One table slot.
+  struct Slot
+  {
+    Slot ()
+      : key (0),
+        state (SLOT_EMPTY),
+        childIndex (0),
+        treeAddress (0),
+        heard (false)
+    {
+    }
+    uint32_t key;         //!< node index
+    uint8_t state;        //!< SlotState
+    uint32_t childIndex;  //!< position in m_children, SLOT_CHILD only
+    uint32_t treeAddress; //!< delegated tree address, SLOT_CHILD only
+    bool heard;           //!< heard from since the last TakeSilent, SLOT_CHILD only
+    Time expiry;          //!< expiry time, SLOT_PENDING only
+  };
+
+  static const uint32_t NOT_FOUND = 0xffffffff; //!< Find miss
+
+  /**
+   * \param key the key
+   * \return the home slot of key
+   */
+  uint32_t Home (uint32_t key) const;
+  /**
+   * \param key the key
+   * \return the slot holding key, NOT_FOUND if absent
+   */
+  uint32_t Find (uint32_t key) const;
+  /**
+   * Insert an empty entry for key, which must be absent.
+   * \param key the key
+   * \return the slot of the new entry
+   */
+  uint32_t Insert (uint32_t key);
+  /**
+   * Remove the entry of a slot, shifting its probe chain back.
+   * \param slot the slot
+   */
+  void Erase (uint32_t slot);
+  /**
+   * Double the table size.
+   */
+  void Grow (void);
+  /**
+   * Append a child to m_children and record its position.
+   * \param slot the slot of the child
+   */
+  void LinkChild (uint32_t slot);
+  /**
+   * Remove a child from m_children by swapping in the last one.
+   * \param slot the slot of the child
+   */
+  void UnlinkChild (uint32_t slot);
+
+  std::vector<Slot> m_slots;              //!< open-addressing table
+  uint32_t m_mask;                        //!< m_slots.size () - 1
+  uint32_t m_shift;                       //!< 32 - log2 (m_slots.size ())
+  uint32_t m_used;                        //!< occupied slots
+  uint32_t m_nPending;                    //!< pending slots
+  std::vector<uint32_t> m_children;       //!< dense array of children
+};
+
+}
+#endif /* CLUSTER_CHILD_TABLE_H */
@@ -0,0 +1,171 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include "ns3/cluster-tree-network.h"
+#include "ns3/cluster-convergecast-schedule.h"
+#include <algorithm>
+#include <set>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterConvergecastSchedule");
+
+namespace {
+
+/// Orders nodes deepest first.
+struct DepthGreater
+{
+  const std::vector<uint32_t> *depth;  //!< depth per node index
+  bool operator() (uint32_t a, uint32_t b) const
+  {
+    return (*depth)[a] > (*depth)[b];
+  }
+};
+
+/// Orders cells of one node by slot.
+struct CellSlotLess
+{
+  const std::vector<ClusterCell> *cells;  //!< the schedule's cells
+  bool operator() (uint32_t a, uint32_t b) const
+  {
+    return (*cells)[a].slot < (*cells)[b].slot;
+  }
+};
+
+}
+
+ClusterConvergecastSchedule::ClusterConvergecastSchedule ()
+  : m_length (0)
+{
+}
+
+void
+ClusterConvergecastSchedule::Build (const std::vector<uint32_t> &fathers, uint32_t cellsPerNode, uint8_t channels)
+{
+  NS_ASSERT (channels > 0);
+  uint32_t n = fathers.size ();
+  m_cells.clear ();
+  m_nodeCells.assign (n, std::vector<uint32_t> ());
+  m_length = 0;
+
+  // 先算深度，按父亲往上数；父亲为空的只有Coor和没入网的
+  const uint32_t unknown = 0xffffffff;
+  std::vector<uint32_t> depth (n, unknown);
+  std::vector<uint32_t> path;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      uint32_t v = i;
+      path.clear ();
+      while (v != ClusterTreeNetwork::NO_NODE && depth[v] == unknown)
+        {
+          path.push_back (v);
+          NS_ASSERT_MSG (path.size () <= n, "father pointers form a cycle");
+          v = fathers[v];
+        }
+      uint32_t d = v == ClusterTreeNetwork::NO_NODE ? 0 : depth[v] + 1;
+      for (std::vector<uint32_t>::reverse_iterator j = path.rbegin (); j != path.rend (); ++j)
+        {
+          depth[*j] = d++;
+        }
+    }
+  // 挂在Coor下面的才排进来；子树大小从最深的往上累加
+  std::vector<uint32_t> order;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      uint32_t root = i;
+      while (fathers[root] != ClusterTreeNetwork::NO_NODE)
+        {
+          root = fathers[root];
+        }
+      if (root == ClusterTreeNetwork::COORDINATOR_INDEX && i != root)
+        {
+          order.push_back (i);
+        }
+    }
+  DepthGreater deeper;
+  deeper.depth = &depth;
+  std::stable_sort (order.begin (), order.end (), deeper);
+  std::vector<uint32_t> subtree (n, 1);
+  for (std::vector<uint32_t>::iterator i = order.begin (); i != order.end (); ++i)
+    {
+      subtree[fathers[*i]] += subtree[*i];
+    }
+
+  std::vector<std::set<uint32_t> > busy (n);
+  std::vector<uint32_t> ready (n, 0);       // 收完所有儿子之后才开始往上发
+  std::vector<uint8_t> slotChannels;        // 每个slot已经用掉的信道偏移
+  for (std::vector<uint32_t>::iterator i = order.begin (); i != order.end (); ++i)
+    {
+      uint32_t child = *i;
+      uint32_t father = fathers[child];
+      uint32_t slot = ready[child];
+      for (uint32_t k = 0; k < subtree[child] * cellsPerNode; ++k)
+        {
+          while ((slot < slotChannels.size () && slotChannels[slot] >= channels)
+                 || busy[child].count (slot) != 0 || busy[father].count (slot) != 0)
+            {
+              slot++;
+            }
+          if (slot >= slotChannels.size ())
+            {
+              slotChannels.resize (slot + 1, 0);
+            }
+          ClusterCell cell;
+          cell.slot = slot;
+          cell.channelOffset = slotChannels[slot]++;
+          cell.tx = child;
+          cell.rx = father;
+          m_nodeCells[child].push_back (m_cells.size ());
+          m_nodeCells[father].push_back (m_cells.size ());
+          m_cells.push_back (cell);
+          busy[child].insert (slot);
+          busy[father].insert (slot);
+          ready[father] = std::max (ready[father], slot + 1);
+          m_length = std::max (m_length, slot + 1);
+        }
+    }
+  CellSlotLess less;
+  less.cells = &m_cells;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      std::sort (m_nodeCells[i].begin (), m_nodeCells[i].end (), less);
+    }
+  NS_LOG_INFO (order.size () << " links, " << m_cells.size () << " cells, " << m_length << " slots");
+}
+
+uint32_t
+ClusterConvergecastSchedule::GetSlotframeLength (void) const
+{
+  return m_length;
+}
+
+const std::vector<ClusterCell> &
+ClusterConvergecastSchedule::GetCells (void) const
+{
+  return m_cells;
+}
+
+void
+ClusterConvergecastSchedule::GetNodeCells (uint32_t node, std::vector<ClusterCell> &cells) const
+{
+  cells.clear ();
+  for (std::vector<uint32_t>::const_iterator i = m_nodeCells[node].begin (); i != m_nodeCells[node].end (); ++i)
+    {
+      cells.push_back (m_cells[*i]);
+    }
+}
+
+}
@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_CONVERGECAST_SCHEDULE_H
+#define CLUSTER_CONVERGECAST_SCHEDULE_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mylib
+ * One cell of a slotframe: tx sends one frame to rx in slot, on the
+ * channel given by channelOffset.
+ */
+struct ClusterCell
+{
+  uint32_t slot;           //!< slot within the slotframe
+  uint8_t channelOffset;   //!< channel offset, 0 .. channels - 1
+  uint32_t tx;             //!< sending node index
+  uint32_t rx;             //!< receiving node index, the father of tx
+};
+
+/**
+ * \ingroup mylib
+ *
+ * Collision-free convergecast schedule of a cluster tree, in the manner
+ * of TSCH: every child to father link gets cells sized to the load of the
+ * child's subtree, CellsPerNode per node of the subtree.
+ *
+ * Links are allocated deepest first.  A link starts after the last cell
+ * in which its child receives, so a reading generated before a slotframe
+ * reaches the coordinator within it.  A node is in at most one cell per
+ * slot, and a (slot, channel offset) pair is never reused, so no two
+ * scheduled frames can collide whatever the topology.
+ */
+class ClusterConvergecastSchedule
+{
+public:
+  ClusterConvergecastSchedule ();
+
+  /**
+   * Compute the schedule.
+   * \param fathers father of every node index; ClusterTreeNetwork::NO_NODE
+   *        for the coordinator and for nodes outside the tree
+   * \param cellsPerNode cells per slotframe each node's readings need
+   * \param channels channel offsets available per slot
+   */
+  void Build (const std::vector<uint32_t> &fathers, uint32_t cellsPerNode, uint8_t channels);
+
+  /**
+   * \return slots per slotframe
+   */
+  uint32_t GetSlotframeLength (void) const;
+  /**
+   * \return every cell, by link, deepest links first
+   */
+  const std::vector<ClusterCell> &GetCells (void) const;
+  /**
+   * \param node a node index
+   * \param cells filled with the cells node sends or receives in, by slot
+   */
+  void GetNodeCells (uint32_t node, std::vector<ClusterCell> &cells) const;
+
+private:
+  std::vector<ClusterCell> m_cells;                 //!< all cells
+  std::vector<std::vector<uint32_t> > m_nodeCells;  //!< indices into m_cells, per node
+  uint32_t m_length;                                //!< slots per slotframe
+};
+
+}
+#endif /* CLUSTER_CONVERGECAST_SCHEDULE_H */
@@ -0,0 +1,313 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/double.h>
+#include <ns3/simulator.h>
+#include <ns3/node.h>
+#include <ns3/net-device.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/propagation-delay-model.h>
+#include <ns3/spectrum-propagation-loss-model.h>
+#include "ns3/cluster-culled-spectrum-channel.h"
+#include "ns3/cluster-spatial-index.h"
+#include "ns3/cluster-tree-network.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterCulledSpectrumChannel");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterCulledSpectrumChannel);
+
+TypeId
+ClusterCulledSpectrumChannel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterCulledSpectrumChannel")
+    .SetParent<SingleModelSpectrumChannel> ()
+    .AddConstructor<ClusterCulledSpectrumChannel> ()
+    .AddAttribute ("InterferenceFloor",
+                   "Weakest received power in dBm still delivered to a PHY.",
+                   DoubleValue (-110.0),
+                   MakeDoubleAccessor (&ClusterCulledSpectrumChannel::m_floorDbm),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxTxPower",
+                   "Strongest transmit power in dBm of any attached PHY.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&ClusterCulledSpectrumChannel::m_maxTxPowerDbm),
+                   MakeDoubleChecker<double> ())
+  ;
+  return tid;
+}
+
+ClusterCulledSpectrumChannel::ClusterCulledSpectrumChannel ()
+  : m_floorDbm (-110.0),
+    m_maxTxPowerDbm (0.0),
+    m_range (0),
+    m_deliveries (0),
+    m_culled (0)
+{
+}
+
+ClusterCulledSpectrumChannel::~ClusterCulledSpectrumChannel ()
+{
+}
+
+void
+ClusterCulledSpectrumChannel::DoDispose (void)
+{
+  m_loss = 0;
+  m_spectrumLoss = 0;
+  m_delay = 0;
+  m_phys.clear ();
+  m_phyIndex.clear ();
+  m_mobility.clear ();
+  m_unlocated.clear ();
+  if (m_index)
+    {
+      m_index->Dispose ();
+      m_index = 0;
+    }
+  m_indexOf.clear ();
+  m_phyOf.clear ();
+  m_rows.clear ();
+  m_rowValid.clear ();
+  SingleModelSpectrumChannel::DoDispose ();
+}
+
+void
+ClusterCulledSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+  SingleModelSpectrumChannel::AddRx (phy);
+  if (m_phyIndex.find (PeekPointer (phy)) != m_phyIndex.end ())
+    {
+      return;
+    }
+  m_phyIndex[PeekPointer (phy)] = m_phys.size ();
+  m_phys.push_back (phy);
+  if (m_index)
+    {
+      // 索引已建好（运行中加入）：登记新接收机，所有行重新查
+      m_mobility.push_back (0);
+      m_indexOf.push_back (0);
+      m_rows.push_back (std::vector<Reach> ());
+      m_rowValid.push_back (0);
+      Locate (m_phys.size () - 1);
+      std::fill (m_rowValid.begin (), m_rowValid.end (), 0);
+    }
+}
+
+void
+ClusterCulledSpectrumChannel::AddPropagationLossModel (Ptr<PropagationLossModel> loss)
+{
+  NS_LOG_FUNCTION (this << loss);
+  NS_ABORT_MSG_IF (m_loss, "ClusterCulledSpectrumChannel takes a single propagation loss model");
+  m_loss = loss;
+  SingleModelSpectrumChannel::AddPropagationLossModel (loss);
+}
+
+void
+ClusterCulledSpectrumChannel::AddSpectrumPropagationLossModel (Ptr<SpectrumPropagationLossModel> loss)
+{
+  NS_LOG_FUNCTION (this << loss);
+  m_spectrumLoss = loss;
+  SingleModelSpectrumChannel::AddSpectrumPropagationLossModel (loss);
+}
+
+void
+ClusterCulledSpectrumChannel::SetPropagationDelayModel (Ptr<PropagationDelayModel> delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+  m_delay = delay;
+  SingleModelSpectrumChannel::SetPropagationDelayModel (delay);
+}
+
+void
+ClusterCulledSpectrumChannel::Precompute (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_index)
+    {
+      BuildIndex ();
+    }
+  for (uint32_t i = 0; i < m_phys.size (); ++i)
+    {
+      if (!m_rowValid[i])
+        {
+          BuildRow (i);
+        }
+    }
+}
+
+uint64_t
+ClusterCulledSpectrumChannel::GetNDeliveries (void) const
+{
+  return m_deliveries;
+}
+
+uint64_t
+ClusterCulledSpectrumChannel::GetNCulled (void) const
+{
+  return m_culled;
+}
+
+void
+ClusterCulledSpectrumChannel::BuildIndex (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_UNLESS (m_loss, "ClusterCulledSpectrumChannel needs a propagation loss model");
+  // 放在第一次发送时做：helper 在 SetChannel 之后才装 mobility
+  m_range = ClusterTreeNetwork::FindRange (m_loss, m_maxTxPowerDbm, m_floorDbm);
+  m_index = CreateObject<ClusterSpatialIndex> ();
+  m_index->SetCellSize (m_range);
+  m_mobility.assign (m_phys.size (), 0);
+  m_indexOf.assign (m_phys.size (), 0);
+  m_phyOf.clear ();
+  m_unlocated.clear ();
+  for (uint32_t i = 0; i < m_phys.size (); ++i)
+    {
+      Locate (i);
+    }
+  m_rows.assign (m_phys.size (), std::vector<Reach> ());
+  m_rowValid.assign (m_phys.size (), 0);
+  NS_LOG_DEBUG ("range " << m_range << " m for " << m_phyOf.size () << " located PHYs");
+}
+
+void
+ClusterCulledSpectrumChannel::Locate (uint32_t phy)
+{
+  Ptr<MobilityModel> mobility = m_phys[phy]->GetMobility ();
+  if (mobility == 0)
+    {
+      m_unlocated.push_back (phy);
+      return;
+    }
+  m_mobility[phy] = mobility;
+  m_indexOf[phy] = m_index->AddNode (mobility);
+  m_phyOf.push_back (phy);
+  mobility->TraceConnectWithoutContext ("CourseChange",
+                                        MakeCallback (&ClusterCulledSpectrumChannel::CourseChanged, this));
+}
+
+void
+ClusterCulledSpectrumChannel::BuildRow (uint32_t tx)
+{
+  std::vector<Reach> &row = m_rows[tx];
+  row.clear ();
+  m_rowValid[tx] = 1;
+  if (m_mobility[tx] == 0)
+    {
+      return;
+    }
+  std::vector<uint32_t> near;
+  m_index->GetNeighbors (m_indexOf[tx], m_range, near);
+  for (std::vector<uint32_t>::const_iterator i = near.begin (); i != near.end (); ++i)
+    {
+      uint32_t rx = m_phyOf[*i];
+      // 网格只按距离粗选，这里用损耗模型精确判断
+      double gainDb = m_loss->CalcRxPower (0, m_mobility[tx], m_mobility[rx]);
+      if (m_maxTxPowerDbm + gainDb >= m_floorDbm)
+        {
+          Reach reach;
+          reach.rx = rx;
+          reach.gainDb = gainDb;
+          row.push_back (reach);
+        }
+    }
+}
+
+void
+ClusterCulledSpectrumChannel::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << mobility);
+  // 一个节点移动会影响所有能听到它的行，简单起见全部作废
+  std::fill (m_rowValid.begin (), m_rowValid.end (), 0);
+}
+
+void
+ClusterCulledSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> params)
+{
+  NS_LOG_FUNCTION (this << params);
+  NS_ASSERT (params->txPhy);
+  if (!m_index)
+    {
+      BuildIndex ();
+    }
+  std::unordered_map<SpectrumPhy *, uint32_t>::const_iterator found = m_phyIndex.find (PeekPointer (params->txPhy));
+  NS_ABORT_MSG_IF (found == m_phyIndex.end (), "transmitter is not attached to this channel");
+  uint32_t tx = found->second;
+  if (!m_rowValid[tx])
+    {
+      BuildRow (tx);
+    }
+  uint64_t delivered = 0;
+  if (m_mobility[tx] == 0)
+    {
+      // 发送方没有位置：和基类一样不衰减地发给所有人
+      for (uint32_t rx = 0; rx < m_phys.size (); ++rx)
+        {
+          if (rx != tx)
+            {
+              Deliver (params, m_phys[rx], 0, false);
+              ++delivered;
+            }
+        }
+    }
+  else
+    {
+      const std::vector<Reach> &row = m_rows[tx];
+      for (std::vector<Reach>::const_iterator i = row.begin (); i != row.end (); ++i)
+        {
+          Deliver (params, m_phys[i->rx], i->gainDb, true);
+        }
+      for (std::vector<uint32_t>::const_iterator i = m_unlocated.begin (); i != m_unlocated.end (); ++i)
+        {
+          Deliver (params, m_phys[*i], 0, false);
+        }
+      delivered = row.size () + m_unlocated.size ();
+    }
+  m_deliveries += delivered;
+  m_culled += m_phys.size () - 1 - delivered;
+}
+
+void
+ClusterCulledSpectrumChannel::Deliver (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> rx,
+                                       double gainDb, bool attenuate)
+{
+  // Copy 会复制 psd，各接收机互不影响
+  Ptr<SpectrumSignalParameters> rxParams = params->Copy ();
+  Time delay;
+  if (attenuate)
+    {
+      Ptr<MobilityModel> txMobility = params->txPhy->GetMobility ();
+      Ptr<MobilityModel> rxMobility = rx->GetMobility ();
+      *(rxParams->psd) *= std::pow (10.0, gainDb / 10.0);
+      if (m_spectrumLoss)
+        {
+          rxParams->psd = m_spectrumLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, rxMobility);
+        }
+      if (m_delay)
+        {
+          delay = m_delay->GetDelay (txMobility, rxMobility);
+        }
+    }
+  Ptr<NetDevice> device = rx->GetDevice ();
+  uint32_t context = device ? device->GetNode ()->GetId () : 0;
+  Simulator::ScheduleWithContext (context, delay, &SpectrumPhy::StartRx, rx, rxParams);
+}
+
+}
@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_CULLED_SPECTRUM_CHANNEL_H
+#define CLUSTER_CULLED_SPECTRUM_CHANNEL_H
+
+#include <ns3/single-model-spectrum-channel.h>
+#include <ns3/mobility-model.h>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+class ClusterSpatialIndex;
+
+/**
+ * \ingroup mylib
+ *
+ * SingleModelSpectrumChannel that delivers a transmission only to the
+ * receivers that can get at least InterferenceFloor from a transmitter
+ * sending at MaxTxPower, instead of to every attached PHY.
+ *
+ * The receivers of a transmitter, with their propagation gain, are found
+ * on its first transmission through a ClusterSpatialIndex over the PHY
+ * positions and kept until a MobilityModel fires CourseChange.  A frame
+ * then costs O(reachable receivers) events and loss evaluations instead
+ * of O(attached PHYs).  Energy below InterferenceFloor is left out of
+ * the receivers' interference, so the floor should sit well below the
+ * noise floor of the PHYs.
+ *
+ * The propagation loss model must be deterministic and decrease with
+ * distance.  Antennas are taken as isotropic, which is what LrWpanPhy
+ * uses, and the PathLoss, Gain and TxSigParams traces of the base
+ * channel are not fired.  PHYs without a MobilityModel receive every
+ * frame unattenuated, as with SingleModelSpectrumChannel.
+ */
+class ClusterCulledSpectrumChannel : public SingleModelSpectrumChannel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterCulledSpectrumChannel ();
+  virtual ~ClusterCulledSpectrumChannel ();
+
+  virtual void AddRx (Ptr<SpectrumPhy> phy);
+  virtual void AddPropagationLossModel (Ptr<PropagationLossModel> loss);
+  virtual void AddSpectrumPropagationLossModel (Ptr<SpectrumPropagationLossModel> loss);
+  virtual void SetPropagationDelayModel (Ptr<PropagationDelayModel> delay);
+  virtual void StartTx (Ptr<SpectrumSignalParameters> params);
+
+  /**
+   * Find the receivers of every transmitter now instead of on first use.
+   */
+  void Precompute (void);
+  /**
+   * \return receptions scheduled so far
+   */
+  uint64_t GetNDeliveries (void) const;
+  /**
+   * \return receptions a full fan-out would have scheduled and were skipped
+   */
+  uint64_t GetNCulled (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// A receiver of a transmitter.
+  struct Reach
+  {
+    uint32_t rx;      //!< receiver position in m_phys
+    double gainDb;    //!< propagation gain
+  };
+
+  /**
+   * Register the mobility of every PHY in the spatial index, once they
+   * are all known.
+   */
+  void BuildIndex (void);
+  /**
+   * Register a PHY in the spatial index, or as unlocated.
+   * \param phy position in m_phys
+   */
+  void Locate (uint32_t phy);
+  /**
+   * Find the receivers of a transmitter.
+   * \param tx transmitter position in m_phys
+   */
+  void BuildRow (uint32_t tx);
+  /**
+   * CourseChange trace sink: every receiver list is stale.
+   * \param mobility the mobility model that moved
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+  /**
+   * Schedule the reception of params at rx.
+   * \param params the transmission
+   * \param rx the receiver
+   * \param gainDb propagation gain, ignored when attenuate is false
+   * \param attenuate false when either end has no mobility
+   */
+  void Deliver (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> rx, double gainDb, bool attenuate);
+
+  double m_floorDbm;                                  //!< weakest delivered power
+  double m_maxTxPowerDbm;                             //!< strongest transmitter assumed
+  Ptr<PropagationLossModel> m_loss;                   //!< loss model, also set on the base
+  Ptr<SpectrumPropagationLossModel> m_spectrumLoss;   //!< frequency-dependent loss, may be null
+  Ptr<PropagationDelayModel> m_delay;                 //!< delay model, may be null
+  std::vector<Ptr<SpectrumPhy> > m_phys;              //!< attached PHYs
+  std::unordered_map<SpectrumPhy *, uint32_t> m_phyIndex; //!< position of each PHY in m_phys
+  std::vector<Ptr<MobilityModel> > m_mobility;        //!< mobility per PHY when indexed, null if none
+  std::vector<uint32_t> m_unlocated;                  //!< PHYs without mobility
+  Ptr<ClusterSpatialIndex> m_index;                   //!< PHY positions, null until indexed
+  std::vector<uint32_t> m_indexOf;                    //!< spatial index entry per PHY
+  std::vector<uint32_t> m_phyOf;                      //!< PHY per spatial index entry
+  double m_range;                                     //!< distance at which the floor is reached
+  std::vector<std::vector<Reach> > m_rows;            //!< receivers per transmitter
+  std::vector<uint8_t> m_rowValid;                    //!< m_rows entry is current
+  uint64_t m_deliveries;                              //!< receptions scheduled
+  uint64_t m_culled;                                  //!< receptions skipped
+};
+
+}
+#endif /* CLUSTER_CULLED_SPECTRUM_CHANNEL_H */
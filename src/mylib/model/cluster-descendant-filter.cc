@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include "ns3/cluster-descendant-filter.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterDescendantFilter");
+
+ClusterDescendantFilter::ClusterDescendantFilter (uint32_t bits)
+  : m_bits (0),
+    m_words (0)
+{
+  SetSize (bits);
+}
+
+void
+ClusterDescendantFilter::SetSize (uint32_t bits)
+{
+  Clear ();
+  m_bits = 0;
+  if (bits != 0)
+    {
+      m_bits = 64;
+      while (m_bits < bits)
+        {
+          m_bits <<= 1;
+        }
+    }
+  m_words = m_bits / 64;
+}
+
+bool
+ClusterDescendantFilter::IsEnabled (void) const
+{
+  return m_bits != 0;
+}
+
+uint32_t
+ClusterDescendantFilter::FindFilter (uint32_t child) const
+{
+  // 儿子一般只有几个，顺序找就够了
+  for (uint32_t i = 0; i < m_owners.size (); ++i)
+    {
+      if (m_owners[i] == child)
+        {
+          return i * m_words;
+        }
+    }
+  return NO_FILTER;
+}
+
+uint32_t
+ClusterDescendantFilter::GetBit (uint32_t node, uint32_t k) const
+{
+  // 双重散列：一次乘法得到两个散列值，第k个位置为 h1 + k*h2
+  uint64_t h = (uint64_t (node) + 1) * 0x9e3779b97f4a7c15ULL;
+  uint32_t h1 = h >> 32;
+  uint32_t h2 = uint32_t (h) | 1;
+  return (h1 + k * h2) & (m_bits - 1);
+}
+
+void
+ClusterDescendantFilter::Add (uint32_t child, uint32_t node)
+{
+  if (m_bits == 0)
+    {
+      return;
+    }
+  uint32_t first = GetFilter (child);
+  for (uint32_t k = 0; k < NUM_HASHES; ++k)
+    {
+      uint32_t bit = GetBit (node, k);
+      m_filters[first + bit / 64] |= uint64_t (1) << (bit % 64);
+    }
+}
+
+void
+ClusterDescendantFilter::AddAll (uint32_t child)
+{
+  if (m_bits == 0)
+    {
+      return;
+    }
+  uint32_t first = GetFilter (child);
+  std::fill (m_filters.begin () + first, m_filters.begin () + first + m_words, ~uint64_t (0));
+}
+
+uint32_t
+ClusterDescendantFilter::GetFilter (uint32_t child)
+{
+  uint32_t first = FindFilter (child);
+  if (first == NO_FILTER)
+    {
+      first = m_filters.size ();
+      m_owners.push_back (child);
+      m_filters.resize (m_filters.size () + m_words, 0);
+    }
+  return first;
+}
+
+bool
+ClusterDescendantFilter::MayContain (uint32_t child, uint32_t node) const
+{
+  if (m_bits == 0)
+    {
+      return true;
+    }
+  uint32_t first = FindFilter (child);
+  if (first == NO_FILTER)
+    {
+      return false;
+    }
+  for (uint32_t k = 0; k < NUM_HASHES; ++k)
+    {
+      uint32_t bit = GetBit (node, k);
+      if ((m_filters[first + bit / 64] & (uint64_t (1) << (bit % 64))) == 0)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+ClusterDescendantFilter::Remove (uint32_t child)
+{
+  uint32_t first = FindFilter (child);
+  if (first == NO_FILTER)
+    {
+      return;
+    }
+  // 把最后一个过滤器挪到空出来的位置
+  uint32_t last = m_filters.size () - m_words;
+  std::copy (m_filters.begin () + last, m_filters.end (), m_filters.begin () + first);
+  m_owners[first / m_words] = m_owners.back ();
+  m_owners.pop_back ();
+  m_filters.resize (last);
+}
+
+void
+ClusterDescendantFilter::Clear (void)
+{
+  m_owners.clear ();
+  m_filters.clear ();
+}
+
+uint64_t
+ClusterDescendantFilter::GetMemoryUsage (void) const
+{
+  return m_owners.capacity () * sizeof (uint32_t) + m_filters.capacity () * sizeof (uint64_t);
+}
+
+}
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_DESCENDANT_FILTER_H
+#define CLUSTER_DESCENDANT_FILTER_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mylib
+ *
+ * Per-child Bloom filters of the descendants of one cluster head, used to
+ * send a downward message only into the branch that holds its target.
+ *
+ * Each filter has the same power-of-two number of bits and is tested with
+ * NUM_HASHES bit positions derived from the node index by double hashing.
+ * There are no false negatives: a node added under a child always tests
+ * positive for it, while a false positive only sends the message into one
+ * more branch.  A child gets its filter on its first Add, so leaf
+ * children cost nothing.
+ */
+class ClusterDescendantFilter
+{
+public:
+  /**
+   * \param bits bits per child filter, rounded up to a power of two of at
+   * least 64; 0 disables the filters
+   */
+  ClusterDescendantFilter (uint32_t bits = 0);
+
+  /**
+   * Forget every filter and change their size.
+   * \param bits bits per child filter, 0 disables the filters
+   */
+  void SetSize (uint32_t bits);
+  /**
+   * \return false if the filters are disabled
+   */
+  bool IsEnabled (void) const;
+
+  /**
+   * Record that node lives below child.
+   * \param child a child of this cluster head
+   * \param node a descendant reached through child
+   */
+  void Add (uint32_t child, uint32_t node);
+  /**
+   * \param child a child of this cluster head
+   * \param node a node index
+   * \return false if node is certainly not below child
+   */
+  bool MayContain (uint32_t child, uint32_t node) const;
+  /**
+   * Make every node test positive for child, for a child whose
+   * descendants are not known one by one.
+   * \param child a child of this cluster head
+   */
+  void AddAll (uint32_t child);
+  /**
+   * Forget the filter of a child.
+   * \param child the child
+   */
+  void Remove (uint32_t child);
+  /**
+   * Forget every filter, keeping the size.
+   */
+  void Clear (void);
+
+  /**
+   * \return the bytes used by the filters
+   */
+  uint64_t GetMemoryUsage (void) const;
+
+private:
+  static const uint32_t NUM_HASHES = 3;          //!< bits set per node
+  static const uint32_t NO_FILTER = 0xffffffff;  //!< child without a filter
+
+  /**
+   * \param child a child
+   * \return the first word of its filter, NO_FILTER if it has none
+   */
+  uint32_t FindFilter (uint32_t child) const;
+  /**
+   * \param node a node index
+   * \param k hash number, below NUM_HASHES
+   * \return the k-th bit position of node
+   */
+  uint32_t GetBit (uint32_t node, uint32_t k) const;
+  /**
+   * \param child a child
+   * \return the first word of its filter, allocated empty if needed
+   */
+  uint32_t GetFilter (uint32_t child);
+
+  uint32_t m_bits;                  //!< bits per filter, 0 when disabled
+  uint32_t m_words;                 //!< 64-bit words per filter
+  std::vector<uint32_t> m_owners;   //!< child owning each filter
+  std::vector<uint64_t> m_filters;  //!< the filters, back to back
+};
+
+}
+#endif /* CLUSTER_DESCENDANT_FILTER_H */
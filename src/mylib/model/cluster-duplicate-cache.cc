@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include "ns3/cluster-duplicate-cache.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterDuplicateCache");
+
+ClusterDuplicateCache::ClusterDuplicateCache (uint32_t size)
+  : m_mask (0),
+    m_lifetime (Seconds (2)),
+    m_duplicates (0),
+    m_evictions (0)
+{
+  SetSize (size);
+}
+
+void
+ClusterDuplicateCache::SetSize (uint32_t size)
+{
+  m_entries.clear ();
+  m_mask = 0;
+  if (size == 0)
+    {
+      return;
+    }
+  uint32_t slots = 1;
+  while (slots < size)
+    {
+      slots <<= 1;
+    }
+  Entry empty;
+  empty.originator = 0;
+  empty.type = 0;
+  empty.sequence = 0;
+  m_entries.assign (slots, empty);
+  m_mask = slots - 1;
+}
+
+bool
+ClusterDuplicateCache::IsEnabled (void) const
+{
+  return !m_entries.empty ();
+}
+
+void
+ClusterDuplicateCache::SetLifetime (Time lifetime)
+{
+  m_lifetime = lifetime;
+}
+
+bool
+ClusterDuplicateCache::IsDuplicate (uint16_t type, uint32_t originator, uint8_t sequence, Time now)
+{
+  if (m_entries.empty ())
+    {
+      return false;
+    }
+  // 同一发起者相邻的序号落在不同的格子里
+  uint32_t hash = originator * 0x9e3779b1U ^ (uint32_t (sequence) << 4 | type);
+  hash ^= hash >> 16;
+  Entry &entry = m_entries[hash & m_mask];
+  bool live = entry.expiry > now;
+  if (live && entry.originator == originator && entry.type == type && entry.sequence == sequence)
+    {
+      m_duplicates++;
+      return true;
+    }
+  if (live)
+    {
+      m_evictions++;
+    }
+  entry.originator = originator;
+  entry.type = type;
+  entry.sequence = sequence;
+  entry.expiry = now + m_lifetime;
+  return false;
+}
+
+void
+ClusterDuplicateCache::Clear (void)
+{
+  for (uint32_t i = 0; i < m_entries.size (); ++i)
+    {
+      m_entries[i].expiry = Time (0);
+    }
+}
+
+uint64_t
+ClusterDuplicateCache::GetNDuplicates (void) const
+{
+  return m_duplicates;
+}
+
+uint64_t
+ClusterDuplicateCache::GetNEvictions (void) const
+{
+  return m_evictions;
+}
+
+}
@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_DUPLICATE_CACHE_H
+#define CLUSTER_DUPLICATE_CACHE_H
+
+#include <ns3/nstime.h>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mylib
+ *
+ * Remembers the relayed messages a node has already handled, so a frame
+ * the MAC retransmitted after a lost ACK, or a request that reached the
+ * node twice, is forwarded only once.
+ *
+ * A message is known by its ClusterHeader type, originator and the
+ * originator's sequence number.  The table is direct-mapped: each key
+ * hashes to one of a power-of-two number of slots and replaces whatever
+ * the slot held.  An entry ages out Lifetime after it was recorded, which
+ * must stay below the time an originator takes to wrap its 8-bit
+ * sequence.  A collision can only make a duplicate go unnoticed, never
+ * drop a new message.
+ */
+class ClusterDuplicateCache
+{
+public:
+  /**
+   * \param size slots, rounded up to a power of two; 0 disables the cache
+   */
+  ClusterDuplicateCache (uint32_t size = 0);
+
+  /**
+   * Forget every entry and change the number of slots.
+   * \param size slots, rounded up to a power of two; 0 disables the cache
+   */
+  void SetSize (uint32_t size);
+  /**
+   * \return false if the cache is disabled
+   */
+  bool IsEnabled (void) const;
+  /**
+   * \param lifetime how long an entry suppresses its message
+   */
+  void SetLifetime (Time lifetime);
+
+  /**
+   * Look a message up and record it.
+   * \param type the ClusterHeaderType
+   * \param originator index of the node that numbered the message
+   * \param sequence the originator's sequence number
+   * \param now the current time
+   * \return true if the same message was recorded less than Lifetime ago
+   */
+  bool IsDuplicate (uint16_t type, uint32_t originator, uint8_t sequence, Time now);
+  /**
+   * Forget every entry, keeping the size.
+   */
+  void Clear (void);
+
+  /**
+   * \return duplicates found since construction
+   */
+  uint64_t GetNDuplicates (void) const;
+  /**
+   * \return live entries replaced by another message since construction
+   */
+  uint64_t GetNEvictions (void) const;
+
+private:
+  /// One slot of the table.
+  struct Entry
+  {
+    uint32_t originator;  //!< originator of the message
+    uint16_t type;        //!< ClusterHeaderType of the message
+    uint8_t sequence;     //!< sequence number of the message
+    Time expiry;          //!< when the entry stops counting, zero for an empty slot
+  };
+
+  std::vector<Entry> m_entries; //!< the slots
+  uint32_t m_mask;              //!< slots - 1
+  Time m_lifetime;              //!< age of an entry when it expires
+  uint64_t m_duplicates;        //!< duplicates found
+  uint64_t m_evictions;         //!< live entries replaced
+};
+
+}
+#endif /* CLUSTER_DUPLICATE_CACHE_H */
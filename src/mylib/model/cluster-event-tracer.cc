@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/string.h>
+#include <ns3/uinteger.h>
+#include "ns3/cluster-event-tracer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterEventTracer");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterEventTracer);
+
+TypeId
+ClusterEventTracer::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterEventTracer")
+    .SetParent<Object> ()
+    .AddConstructor<ClusterEventTracer> ()
+    .AddAttribute ("FileName",
+                   "Binary trace file; empty keeps the last Capacity records in memory.",
+                   StringValue (""),
+                   MakeStringAccessor (&ClusterEventTracer::m_fileName),
+                   MakeStringChecker ())
+    .AddAttribute ("Capacity",
+                   "Records held in memory, written out in one block when full.",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&ClusterEventTracer::SetCapacity,
+                                         &ClusterEventTracer::GetCapacity),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+ClusterEventTracer::ClusterEventTracer ()
+  : m_file (0),
+    m_ring (65536),
+    m_next (0),
+    m_pending (0),
+    m_total (0)
+{
+}
+
+ClusterEventTracer::~ClusterEventTracer ()
+{
+  Close ();
+}
+
+void
+ClusterEventTracer::DoDispose (void)
+{
+  Close ();
+  Object::DoDispose ();
+}
+
+void
+ClusterEventTracer::SetCapacity (uint32_t capacity)
+{
+  Flush ();
+  m_ring.assign (capacity, ClusterTraceRecord ());
+  m_next = 0;
+  m_pending = 0;
+}
+
+uint32_t
+ClusterEventTracer::GetCapacity (void) const
+{
+  return m_ring.size ();
+}
+
+void
+ClusterEventTracer::Flush (void)
+{
+  if (m_fileName.empty () || m_pending == 0)
+    {
+      return;
+    }
+  if (m_file == 0)
+    {
+      m_file = std::fopen (m_fileName.c_str (), "wb");
+      NS_ABORT_MSG_IF (m_file == 0, "cannot open trace file " << m_fileName);
+      ClusterTraceFileHeader header;
+      std::memcpy (header.magic, "CTEV", 4);
+      header.version = VERSION;
+      header.recordSize = sizeof (ClusterTraceRecord);
+      std::fwrite (&header, sizeof (header), 1, m_file);
+    }
+  // 环里最老的一条在 m_next - m_pending，可能绕回到开头，分两段写
+  uint32_t first = (m_next + m_ring.size () - m_pending) % m_ring.size ();
+  uint32_t head = std::min<uint32_t> (m_pending, m_ring.size () - first);
+  std::fwrite (&m_ring[first], sizeof (ClusterTraceRecord), head, m_file);
+  std::fwrite (&m_ring[0], sizeof (ClusterTraceRecord), m_pending - head, m_file);
+  m_pending = 0;
+}
+
+void
+ClusterEventTracer::Close (void)
+{
+  Flush ();
+  if (m_file != 0)
+    {
+      std::fclose (m_file);
+      m_file = 0;
+    }
+}
+
+void
+ClusterEventTracer::GetRecords (std::vector<ClusterTraceRecord> &records) const
+{
+  records.clear ();
+  uint32_t first = (m_next + m_ring.size () - m_pending) % m_ring.size ();
+  for (uint32_t i = 0; i < m_pending; ++i)
+    {
+      records.push_back (m_ring[(first + i) % m_ring.size ()]);
+    }
+}
+
+uint64_t
+ClusterEventTracer::GetNRecords (void) const
+{
+  return m_total;
+}
+
+}
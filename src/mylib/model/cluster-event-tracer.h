@@ -0,0 +1,189 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_EVENT_TRACER_H
+#define CLUSTER_EVENT_TRACER_H
+
+#include <ns3/object.h>
+#include <ns3/nstime.h>
+#include <ns3/simulator.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/// What a ClusterTraceRecord describes.
+enum ClusterTraceEvent
+{
+  CLUSTER_TRACE_TX = 1,         //!< frame handed to the MAC, peer NO_NODE for broadcast
+  CLUSTER_TRACE_RX = 2,         //!< frame accepted by the receive filter
+  CLUSTER_TRACE_RX_WEAK = 3,    //!< frame below RxSensitivity, dropped; type 0 if dropped by ClusterTreePhy
+  CLUSTER_TRACE_TX_FAILED = 4,  //!< MCPS-DATA.confirm not a success, type holds the status
+  CLUSTER_TRACE_JOIN = 5,       //!< node joined, peer is the father, type the cluster id
+  CLUSTER_TRACE_DATA = 6,       //!< reading delivered to the coordinator, peer is the originator
+  CLUSTER_TRACE_DUPLICATE = 7   //!< relayed message already handled, dropped
+};
+
+/**
+ * One binary trace record, written to the file in host byte order.
+ */
+struct ClusterTraceRecord
+{
+  int64_t time;      //!< simulation time in ns
+  uint32_t node;     //!< index of the recording node
+  uint32_t peer;     //!< index of the other node, ClusterTreeNetwork::NO_NODE if none
+  float rxPowerDbm;  //!< receive power, RX and RX_WEAK only
+  uint16_t type;     //!< ClusterHeaderType, or per-event value
+  uint8_t event;     //!< ClusterTraceEvent
+  uint8_t reserved;  //!< zero
+};
+
+/**
+ * Start of a trace file, followed by ClusterTraceRecord entries up to
+ * the end of the file.
+ */
+struct ClusterTraceFileHeader
+{
+  char magic[4];        //!< "CTEV"
+  uint16_t version;     //!< ClusterEventTracer::VERSION
+  uint16_t recordSize;  //!< sizeof (ClusterTraceRecord)
+};
+
+/**
+ * \ingroup mylib
+ *
+ * Binary event trace of the cluster tree protocols of one run.
+ *
+ * Record only stores a fixed-size ClusterTraceRecord in a ring buffer of
+ * Capacity records allocated up front, so tracing a frame costs no
+ * formatting and no allocation.  With a FileName the buffer is written
+ * out in one block whenever it fills and on Flush / dispose; without one
+ * it keeps the last Capacity records for GetRecords.  scratch/
+ * cluster-trace-decode turns a trace file into text or CSV.
+ *
+ * Tracing is switched at run time by giving the network a tracer (see
+ * ClusterTreeHelper::EnableEventTracer) and compiled out entirely with
+ * NS3_CLUSTER_TRACE_DISABLE.
+ */
+class ClusterEventTracer : public Object
+{
+public:
+  /// Trace file format version.
+  static const uint16_t VERSION = 1;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterEventTracer ();
+  virtual ~ClusterEventTracer ();
+
+  /**
+   * Store one record.
+   * \param event the ClusterTraceEvent
+   * \param node index of the recording node
+   * \param peer index of the other node
+   * \param type header type or per-event value
+   * \param rxPowerDbm receive power, 0 when not applicable
+   */
+  void Record (uint8_t event, uint32_t node, uint32_t peer, uint16_t type, float rxPowerDbm = 0);
+  /**
+   * Write the buffered records to FileName, if set.
+   */
+  void Flush (void);
+  /**
+   * \param records receives the records not written out yet (the last
+   * Capacity ones without a FileName), oldest first; cleared first
+   */
+  void GetRecords (std::vector<ClusterTraceRecord> &records) const;
+  /**
+   * \return the number of records stored since creation
+   */
+  uint64_t GetNRecords (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \param capacity the ring buffer size in records
+   */
+  void SetCapacity (uint32_t capacity);
+  /**
+   * \return the ring buffer size in records
+   */
+  uint32_t GetCapacity (void) const;
+  /**
+   * Flush and close the trace file.
+   */
+  void Close (void);
+
+  std::string m_fileName;                   //!< trace file, empty to keep records in memory
+  std::FILE *m_file;                        //!< open trace file, null until the first flush
+  std::vector<ClusterTraceRecord> m_ring;   //!< preallocated records
+  uint32_t m_next;                          //!< slot of the next record
+  uint32_t m_pending;                       //!< records not yet written out
+  uint64_t m_total;                         //!< records stored since creation
+};
+
+inline void
+ClusterEventTracer::Record (uint8_t event, uint32_t node, uint32_t peer, uint16_t type, float rxPowerDbm)
+{
+  ClusterTraceRecord &r = m_ring[m_next];
+  r.time = Simulator::Now ().GetNanoSeconds ();
+  r.node = node;
+  r.peer = peer;
+  r.rxPowerDbm = rxPowerDbm;
+  r.type = type;
+  r.event = event;
+  r.reserved = 0;
+  m_total++;
+  if (++m_next == m_ring.size ())
+    {
+      m_next = 0;
+    }
+  if (m_pending < m_ring.size ())
+    {
+      m_pending++;
+    }
+  if (m_pending == m_ring.size () && !m_fileName.empty ())
+    {
+      Flush ();
+    }
+}
+
+}
+
+/**
+ * Record an event on a tracer that may be null; compiled out with
+ * NS3_CLUSTER_TRACE_DISABLE.
+ */
+#ifdef NS3_CLUSTER_TRACE_DISABLE
+#define CLUSTER_EVENT_TRACE(tracer, ...)
+#else
+#define CLUSTER_EVENT_TRACE(tracer, ...)      \
+  do                                          \
+    {                                         \
+      if (tracer != 0)                        \
+        {                                     \
+          tracer->Record (__VA_ARGS__);       \
+        }                                     \
+    }                                         \
+  while (false)
+#endif
+
+#endif /* CLUSTER_EVENT_TRACER_H */
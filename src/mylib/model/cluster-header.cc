@@ -1,18 +1,86 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 #include <ns3/ptr.h>
 #include <ns3/header.h>
+#include <ns3/log.h>
 #include "ns3/cluster-header.h"
+#include <algorithm>
 
 using namespace ns3;
 
-/**
- * \ingroup network
- * A simple example of an Header implementation
+/*
+ * 节点以下标保存，发送时写成它的MAC地址：短地址2字节(下标+1)，
+ * 扩展地址8字节(低32位为下标+1)。按地址宽度各一份，编译期选好
  */
-ClusterHeader::ClusterHeader ()
+namespace {
+
+struct ShortNodeAddress
+{
+  static const uint32_t SIZE = 2;
+  static void Write (Buffer::Iterator &i, uint32_t node)
+  {
+    i.WriteHtonU16 (node + 1);
+  }
+  static uint32_t Read (Buffer::Iterator &i)
+  {
+    return i.ReadNtohU16 () - 1;
+  }
+};
+
+struct ExtendedNodeAddress
+{
+  static const uint32_t SIZE = 8;
+  static void Write (Buffer::Iterator &i, uint32_t node)
+  {
+    i.WriteHtonU64 (uint64_t (node) + 1);
+  }
+  static uint32_t Read (Buffer::Iterator &i)
+  {
+    return i.ReadNtohU64 () - 1;
+  }
+};
+
+/// 地址0读出来的节点，即ClusterTreeNetwork::NO_NODE
+const uint32_t UNKNOWN_NODE = 0xffffffff;
+
+}
+
+static void
+WriteNodeAddress (Buffer::Iterator &i, uint32_t node, bool extended)
+{
+  if (extended)
+    {
+      ExtendedNodeAddress::Write (i, node);
+    }
+  else
+    {
+      ShortNodeAddress::Write (i, node);
+    }
+}
+static uint32_t
+ReadNodeAddress (Buffer::Iterator &i, bool extended)
+{
+  if (extended)
+    {
+      return ExtendedNodeAddress::Read (i);
+    }
+  return ShortNodeAddress::Read (i);
+}
+
+/* 公共头：版本、两个地址标志、类型、序号、簇ID打包成一个32位字 */
+static const uint32_t CLUSTER_HEADER_ORIGINATOR = 1u << 29;
+static const uint32_t CLUSTER_HEADER_TARGET = 1u << 28;
+
+ClusterHeader::ClusterHeader (bool extended)
+  : m_extended (extended),
+    m_version (VERSION),
+    m_type (0),
+    m_sequence (0),
+    m_clusterId (0),
+    m_hasOriginator (false),
+    m_hasTarget (false),
+    m_originator (0),
+    m_target (0)
 {
-  // we must provide a public default constructor, 
-  // implicit or explicit, but never private.
 }
 ClusterHeader::~ClusterHeader ()
 {
@@ -36,43 +104,641 @@ ClusterHeader::GetInstanceTypeId (void) const
 void
 ClusterHeader::Print (std::ostream &os) const
 {
-  // This method is invoked by the packet printing
-  // routines to print the content of my header.
-  //os << "data=" << m_data << std::endl;
-  os << "data=" << m_data;
+  os << "type=" << m_type << " version=" << uint32_t (m_version)
+     << " seq=" << uint32_t (m_sequence) << " cluster=" << m_clusterId;
+  if (m_hasOriginator)
+    {
+      os << " originator=" << m_originator;
+    }
+  if (m_hasTarget)
+    {
+      os << " target=" << m_target;
+    }
 }
 uint32_t
 ClusterHeader::GetSerializedSize (void) const
 {
-  // we reserve 2 bytes for our header.
-  return 2;
+  uint32_t addressSize = m_extended ? uint32_t (ExtendedNodeAddress::SIZE) : uint32_t (ShortNodeAddress::SIZE);
+  return 4 + (m_hasOriginator ? addressSize : 0) + (m_hasTarget ? addressSize : 0);
+}
+
+template <typename Codec>
+void
+ClusterHeader::SerializeAddresses (Buffer::Iterator &i) const
+{
+  if (m_hasOriginator)
+    {
+      Codec::Write (i, m_originator);
+    }
+  if (m_hasTarget)
+    {
+      Codec::Write (i, m_target);
+    }
 }
+template <typename Codec>
+void
+ClusterHeader::DeserializeAddresses (Buffer::Iterator &i)
+{
+  if (m_hasOriginator)
+    {
+      m_originator = Codec::Read (i);
+    }
+  if (m_hasTarget)
+    {
+      m_target = Codec::Read (i);
+    }
+}
+
 void
 ClusterHeader::Serialize (Buffer::Iterator start) const
 {
-  // we can serialize two bytes at the start of the buffer.
-  // we write them in network byte order.
-  start.WriteHtonU16 (m_data);
+  uint32_t word = uint32_t (VERSION) << 30 | uint32_t (m_type & 0x0f) << 24
+    | uint32_t (m_sequence) << 16 | m_clusterId;
+  if (m_hasOriginator)
+    {
+      word |= CLUSTER_HEADER_ORIGINATOR;
+    }
+  if (m_hasTarget)
+    {
+      word |= CLUSTER_HEADER_TARGET;
+    }
+  start.WriteHtonU32 (word);
+  if (m_extended)
+    {
+      SerializeAddresses<ExtendedNodeAddress> (start);
+    }
+  else
+    {
+      SerializeAddresses<ShortNodeAddress> (start);
+    }
 }
 uint32_t
 ClusterHeader::Deserialize (Buffer::Iterator start)
 {
-  // we can deserialize two bytes from the start of the buffer.
-  // we read them in network byte order and store them
-  // in host byte order.
-  m_data = start.ReadNtohU16 ();
+  m_hasOriginator = false;
+  m_hasTarget = false;
+  if (start.GetRemainingSize () < 4)
+    {
+      // 帧太短，连公共字都没有，当成不认识的版本丢掉，一个字节也不读
+      m_version = 0;
+      return 0;
+    }
+  uint32_t word = start.ReadNtohU32 ();
+  m_version = word >> 30;
+  if (m_version != VERSION)
+    {
+      // 不认识的版本，后面的字段不能信，只交代读了4字节
+      return 4;
+    }
+  m_hasOriginator = (word & CLUSTER_HEADER_ORIGINATOR) != 0;
+  m_hasTarget = (word & CLUSTER_HEADER_TARGET) != 0;
+  if (start.GetRemainingSize () < GetSerializedSize () - 4)
+    {
+      // 标志说有地址，但字节不够
+      m_hasOriginator = false;
+      m_hasTarget = false;
+      m_version = 0;
+      return 4;
+    }
+  m_type = (word >> 24) & 0x0f;
+  m_sequence = (word >> 16) & 0xff;
+  m_clusterId = word & 0xffff;
+  if (m_extended)
+    {
+      DeserializeAddresses<ExtendedNodeAddress> (start);
+    }
+  else
+    {
+      DeserializeAddresses<ShortNodeAddress> (start);
+    }
+  return GetSerializedSize ();
+}
+
+void
+ClusterHeader::SetType (uint16_t type)
+{
+  NS_ASSERT (type <= 0x0f);
+  m_type = type;
+}
+uint16_t
+ClusterHeader::GetType (void) const
+{
+  return m_type;
+}
+uint8_t
+ClusterHeader::GetVersion (void) const
+{
+  return m_version;
+}
+void
+ClusterHeader::SetSequence (uint8_t sequence)
+{
+  m_sequence = sequence;
+}
+uint8_t
+ClusterHeader::GetSequence (void) const
+{
+  return m_sequence;
+}
+void
+ClusterHeader::SetClusterId (uint16_t clusterId)
+{
+  m_clusterId = clusterId;
+}
+uint16_t
+ClusterHeader::GetClusterId (void) const
+{
+  return m_clusterId;
+}
+void
+ClusterHeader::SetOriginator (uint32_t originator)
+{
+  m_originator = originator;
+  m_hasOriginator = true;
+}
+bool
+ClusterHeader::HasOriginator (void) const
+{
+  return m_hasOriginator;
+}
+uint32_t
+ClusterHeader::GetOriginator (void) const
+{
+  return m_originator;
+}
+void
+ClusterHeader::SetTarget (uint32_t target)
+{
+  m_target = target;
+  m_hasTarget = true;
+}
+bool
+ClusterHeader::HasTarget (void) const
+{
+  return m_hasTarget;
+}
+uint32_t
+ClusterHeader::GetTarget (void) const
+{
+  return m_target;
+}
+
+/* 认子回复：分配的簇ID，分块接纳时还有树地址 */
+ClusterGrantHeader::ClusterGrantHeader (bool delegated)
+  : m_delegated (delegated),
+    m_clusterId (0),
+    m_treeAddress (0)
+{
+}
+ClusterGrantHeader::~ClusterGrantHeader ()
+{
+}
+
+TypeId
+ClusterGrantHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterGrantHeader")
+    .SetParent<Header> ()
+    .AddConstructor<ClusterGrantHeader> ()
+  ;
+  return tid;
+}
+TypeId
+ClusterGrantHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
 
-  // we return the number of bytes effectively read.
+void
+ClusterGrantHeader::Print (std::ostream &os) const
+{
+  os << "cluster=" << m_clusterId;
+  if (m_delegated)
+    {
+      os << " treeAddress=" << m_treeAddress;
+    }
+}
+uint32_t
+ClusterGrantHeader::GetSerializedSize (void) const
+{
+  return m_delegated ? 6 : 2;
+}
+void
+ClusterGrantHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteHtonU16 (m_clusterId);
+  if (m_delegated)
+    {
+      start.WriteHtonU32 (m_treeAddress);
+    }
+}
+uint32_t
+ClusterGrantHeader::Deserialize (Buffer::Iterator start)
+{
+  if (start.GetRemainingSize () < GetSerializedSize ())
+    {
+      // 帧被截短了，一个字节也不读
+      m_clusterId = 0;
+      m_treeAddress = 0;
+      return 0;
+    }
+  m_clusterId = start.ReadNtohU16 ();
+  if (m_delegated)
+    {
+      m_treeAddress = start.ReadNtohU32 ();
+    }
+  return GetSerializedSize ();
+}
+
+void
+ClusterGrantHeader::SetClusterId (uint16_t clusterId)
+{
+  m_clusterId = clusterId;
+}
+uint16_t
+ClusterGrantHeader::GetClusterId (void) const
+{
+  return m_clusterId;
+}
+void
+ClusterGrantHeader::SetTreeAddress (uint32_t treeAddress)
+{
+  m_treeAddress = treeAddress;
+}
+uint32_t
+ClusterGrantHeader::GetTreeAddress (void) const
+{
+  return m_treeAddress;
+}
+
+/* 向Coor请求生孩子：父亲和准儿子的地址 */
+ClusterJoinHeader::ClusterJoinHeader (bool extended)
+  : m_extended (extended),
+    m_father (0),
+    m_child (0),
+    m_subtree (false)
+{
+}
+ClusterJoinHeader::~ClusterJoinHeader ()
+{
+}
+
+TypeId
+ClusterJoinHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterJoinHeader")
+    .SetParent<Header> ()
+    .AddConstructor<ClusterJoinHeader> ()
+  ;
+  return tid;
+}
+TypeId
+ClusterJoinHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+ClusterJoinHeader::Print (std::ostream &os) const
+{
+  os << "father=" << m_father << " child=" << m_child << " subtree=" << m_subtree;
+}
+uint32_t
+ClusterJoinHeader::GetSerializedSize (void) const
+{
+  return m_extended ? 17 : 5;
+}
+void
+ClusterJoinHeader::Serialize (Buffer::Iterator start) const
+{
+  WriteNodeAddress (start, m_father, m_extended);
+  WriteNodeAddress (start, m_child, m_extended);
+  start.WriteU8 (m_subtree ? 1 : 0);
+}
+uint32_t
+ClusterJoinHeader::Deserialize (Buffer::Iterator start)
+{
+  if (start.GetRemainingSize () < GetSerializedSize ())
+    {
+      // 两个地址加标志不全，当成谁也不是
+      m_father = UNKNOWN_NODE;
+      m_child = UNKNOWN_NODE;
+      m_subtree = false;
+      return 0;
+    }
+  m_father = ReadNodeAddress (start, m_extended);
+  m_child = ReadNodeAddress (start, m_extended);
+  m_subtree = start.ReadU8 () != 0;
+  return GetSerializedSize ();
+}
+
+void
+ClusterJoinHeader::SetFather (uint32_t father)
+{
+  m_father = father;
+}
+uint32_t
+ClusterJoinHeader::GetFather (void) const
+{
+  return m_father;
+}
+void
+ClusterJoinHeader::SetChild (uint32_t child)
+{
+  m_child = child;
+}
+uint32_t
+ClusterJoinHeader::GetChild (void) const
+{
+  return m_child;
+}
+void
+ClusterJoinHeader::SetSubtree (bool subtree)
+{
+  m_subtree = subtree;
+}
+bool
+ClusterJoinHeader::HasSubtree (void) const
+{
+  return m_subtree;
+}
+
+/* Coor不批准时建议的父亲，没有就是NO_NODE（写出来是地址0） */
+ClusterRedirectHeader::ClusterRedirectHeader (bool extended)
+  : m_extended (extended),
+    m_father (0)
+{
+}
+ClusterRedirectHeader::~ClusterRedirectHeader ()
+{
+}
+
+TypeId
+ClusterRedirectHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterRedirectHeader")
+    .SetParent<Header> ()
+    .AddConstructor<ClusterRedirectHeader> ()
+  ;
+  return tid;
+}
+TypeId
+ClusterRedirectHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+ClusterRedirectHeader::Print (std::ostream &os) const
+{
+  os << "father=" << m_father;
+}
+uint32_t
+ClusterRedirectHeader::GetSerializedSize (void) const
+{
+  return m_extended ? uint32_t (ExtendedNodeAddress::SIZE) : uint32_t (ShortNodeAddress::SIZE);
+}
+void
+ClusterRedirectHeader::Serialize (Buffer::Iterator start) const
+{
+  WriteNodeAddress (start, m_father, m_extended);
+}
+uint32_t
+ClusterRedirectHeader::Deserialize (Buffer::Iterator start)
+{
+  if (start.GetRemainingSize () < GetSerializedSize ())
+    {
+      m_father = UNKNOWN_NODE;
+      return 0;
+    }
+  m_father = ReadNodeAddress (start, m_extended);
+  return GetSerializedSize ();
+}
+
+void
+ClusterRedirectHeader::SetFather (uint32_t father)
+{
+  m_father = father;
+}
+uint32_t
+ClusterRedirectHeader::GetFather (void) const
+{
+  return m_father;
+}
+
+/* 信标：发送者的儿子数，簇ID在公共头里 */
+ClusterBeaconHeader::ClusterBeaconHeader ()
+  : m_nChildren (0),
+    m_energy (255)
+{
+}
+ClusterBeaconHeader::~ClusterBeaconHeader ()
+{
+}
+
+TypeId
+ClusterBeaconHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterBeaconHeader")
+    .SetParent<Header> ()
+    .AddConstructor<ClusterBeaconHeader> ()
+  ;
+  return tid;
+}
+TypeId
+ClusterBeaconHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+ClusterBeaconHeader::Print (std::ostream &os) const
+{
+  os << "children=" << uint32_t (m_nChildren) << " energy=" << uint32_t (m_energy);
+}
+uint32_t
+ClusterBeaconHeader::GetSerializedSize (void) const
+{
   return 2;
 }
+void
+ClusterBeaconHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteU8 (m_nChildren);
+  start.WriteU8 (m_energy);
+}
+uint32_t
+ClusterBeaconHeader::Deserialize (Buffer::Iterator start)
+{
+  if (start.GetRemainingSize () < GetSerializedSize ())
+    {
+      // 没电、没空位的父亲，不会被选上
+      m_nChildren = 255;
+      m_energy = 0;
+      return 0;
+    }
+  m_nChildren = start.ReadU8 ();
+  m_energy = start.ReadU8 ();
+  return GetSerializedSize ();
+}
+
+void
+ClusterBeaconHeader::SetNChildren (uint32_t nChildren)
+{
+  m_nChildren = std::min<uint32_t> (nChildren, 255);
+}
+uint8_t
+ClusterBeaconHeader::GetNChildren (void) const
+{
+  return m_nChildren;
+}
+void
+ClusterBeaconHeader::SetEnergy (uint8_t energy)
+{
+  m_energy = energy;
+}
+uint8_t
+ClusterBeaconHeader::GetEnergy (void) const
+{
+  return m_energy;
+}
 
-void 
-ClusterHeader::SetData (uint16_t data)
+/* 发给Coor的数据：产生数据的节点 */
+ClusterDataHeader::ClusterDataHeader (bool extended)
+  : m_extended (extended),
+    m_originator (0)
 {
-  m_data = data;
 }
-uint16_t 
-ClusterHeader::GetData (void) const
+ClusterDataHeader::~ClusterDataHeader ()
 {
-  return m_data;
-}
\ No newline at end of file
+}
+
+TypeId
+ClusterDataHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterDataHeader")
+    .SetParent<Header> ()
+    .AddConstructor<ClusterDataHeader> ()
+  ;
+  return tid;
+}
+TypeId
+ClusterDataHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+ClusterDataHeader::Print (std::ostream &os) const
+{
+  os << "originator=" << m_originator;
+}
+uint32_t
+ClusterDataHeader::GetSerializedSize (void) const
+{
+  return m_extended ? 8 : 2;
+}
+void
+ClusterDataHeader::Serialize (Buffer::Iterator start) const
+{
+  WriteNodeAddress (start, m_originator, m_extended);
+}
+uint32_t
+ClusterDataHeader::Deserialize (Buffer::Iterator start)
+{
+  if (start.GetRemainingSize () < GetSerializedSize ())
+    {
+      m_originator = UNKNOWN_NODE;
+      return 0;
+    }
+  m_originator = ReadNodeAddress (start, m_extended);
+  return GetSerializedSize ();
+}
+
+void
+ClusterDataHeader::SetOriginator (uint32_t originator)
+{
+  m_originator = originator;
+}
+uint32_t
+ClusterDataHeader::GetOriginator (void) const
+{
+  return m_originator;
+}
+
+/* 打包数据里的一条：产生数据的节点和数据长度 */
+ClusterRecordHeader::ClusterRecordHeader (bool extended)
+  : m_extended (extended),
+    m_originator (0),
+    m_size (0)
+{
+}
+ClusterRecordHeader::~ClusterRecordHeader ()
+{
+}
+
+TypeId
+ClusterRecordHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterRecordHeader")
+    .SetParent<Header> ()
+    .AddConstructor<ClusterRecordHeader> ()
+  ;
+  return tid;
+}
+TypeId
+ClusterRecordHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+ClusterRecordHeader::Print (std::ostream &os) const
+{
+  os << "originator=" << m_originator << " size=" << uint32_t (m_size);
+}
+uint32_t
+ClusterRecordHeader::GetSerializedSize (void) const
+{
+  return m_extended ? 9 : 3;
+}
+void
+ClusterRecordHeader::Serialize (Buffer::Iterator start) const
+{
+  WriteNodeAddress (start, m_originator, m_extended);
+  start.WriteU8 (m_size);
+}
+uint32_t
+ClusterRecordHeader::Deserialize (Buffer::Iterator start)
+{
+  if (start.GetRemainingSize () < GetSerializedSize ())
+    {
+      m_originator = UNKNOWN_NODE;
+      m_size = 0;
+      return 0;
+    }
+  m_originator = ReadNodeAddress (start, m_extended);
+  m_size = start.ReadU8 ();
+  return GetSerializedSize ();
+}
+
+void
+ClusterRecordHeader::SetOriginator (uint32_t originator)
+{
+  m_originator = originator;
+}
+uint32_t
+ClusterRecordHeader::GetOriginator (void) const
+{
+  return m_originator;
+}
+void
+ClusterRecordHeader::SetSize (uint8_t size)
+{
+  m_size = size;
+}
+uint8_t
+ClusterRecordHeader::GetSize (void) const
+{
+  return m_size;
+}
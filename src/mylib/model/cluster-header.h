@@ -29,22 +29,416 @@
  * A simple example of an Header implementation
  */
 namespace ns3 {
+
+/**
+ * Message types carried in ClusterHeader::GetType.
+ */
+enum ClusterHeaderType
+{
+  HEADER_REQUEST_FATHER = 0x0001,             //!< 请求父亲收留
+  HEADER_ACCEPT_CHILD = 0x0002,               //!< 父亲批准
+  HEADER_REQUEST_CLUSTER_FOR_CHILD = 0x0003,  //!< 向Coor请求生孩子
+  HEADER_RETURN_CLUSTER_FOR_CHILD = 0x0004,   //!< Coor批准
+  HEADER_BEACON = 0x0005,                     //!< 广播领养信息
+  HEADER_SEND_DATA_TO_COORDINATOR = 0x0006,   //!< 发给Coor的数据
+  HEADER_SEND_AGGREGATE_TO_COORDINATOR = 0x0007, //!< 簇头打包的多条数据
+  HEADER_REPAIR_REQUEST = 0x0008,              //!< 丢了父亲，请周围的节点回信标
+  HEADER_REJECT_CHILD = 0x0009,                //!< Coor不批准，指个别的父亲
+  HEADER_RELEASE_CHILD = 0x000A                //!< 父子关系解除：父亲退下来，儿子另投别处，或向Coor报走掉的儿子
+};
+
+/**
+ * \ingroup mylib
+ * Common header of every cluster tree frame, bit-packed into one 32-bit
+ * word read and written in a single access:
+ *
+ *   version:2 | originator:1 | target:1 | type:4 | sequence:8 | cluster id:16
+ *
+ * followed by the originator and target addresses when their flag is
+ * set, in the addressing of ClusterJoinHeader.  The sequence number
+ * counts the frames of the sender and the cluster id is the sender's
+ * depth.  A frame whose version is not VERSION must be dropped; its
+ * other fields are not meaningful.  A frame too short for the header its
+ * flags announce deserializes with version 0, without reading past its
+ * end.
+ */
 class ClusterHeader : public Header
 {
 public:
-  ClusterHeader ();
+  /// Format version written by Serialize.
+  static const uint8_t VERSION = 1;
+
+  /**
+   * \param extended true when the tree uses extended addresses
+   */
+  ClusterHeader (bool extended = false);
   virtual ~ClusterHeader ();
 
   /**
-   * Set the header data.
-   * \param data The data.
+   * \param type the ClusterHeaderType, at most 15
+   */
+  void SetType (uint16_t type);
+  /**
+   * \return the ClusterHeaderType
+   */
+  uint16_t GetType (void) const;
+  /**
+   * \return the format version of a deserialized header
+   */
+  uint8_t GetVersion (void) const;
+  /**
+   * \param sequence frame sequence number of the sender
+   */
+  void SetSequence (uint8_t sequence);
+  /**
+   * \return frame sequence number of the sender
+   */
+  uint8_t GetSequence (void) const;
+  /**
+   * \param clusterId cluster id (depth) of the sender
+   */
+  void SetClusterId (uint16_t clusterId);
+  /**
+   * \return cluster id (depth) of the sender
+   */
+  uint16_t GetClusterId (void) const;
+  /**
+   * Carry the node a forwarded message started from.
+   * \param originator node index
+   */
+  void SetOriginator (uint32_t originator);
+  /**
+   * \return true if the header carries an originator
+   */
+  bool HasOriginator (void) const;
+  /**
+   * \return the originator, valid if HasOriginator
+   */
+  uint32_t GetOriginator (void) const;
+  /**
+   * Carry the node a forwarded message is for.
+   * \param target node index
+   */
+  void SetTarget (uint32_t target);
+  /**
+   * \return true if the header carries a target
+   */
+  bool HasTarget (void) const;
+  /**
+   * \return the target, valid if HasTarget
+   */
+  uint32_t GetTarget (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+private:
+  /**
+   * Write the optional addresses with a fixed address width.
+   * \param i where to write
+   */
+  template <typename Codec>
+  void SerializeAddresses (Buffer::Iterator &i) const;
+  /**
+   * Read the optional addresses with a fixed address width.
+   * \param i where to read
+   */
+  template <typename Codec>
+  void DeserializeAddresses (Buffer::Iterator &i);
+
+  bool m_extended;        //!< 8-byte instead of 2-byte addresses
+  uint8_t m_version;      //!< format version
+  uint16_t m_type;        //!< ClusterHeaderType
+  uint8_t m_sequence;     //!< frame sequence number of the sender
+  uint16_t m_clusterId;   //!< depth of the sender
+  bool m_hasOriginator;   //!< m_originator is carried
+  bool m_hasTarget;       //!< m_target is carried
+  uint32_t m_originator;  //!< node the message started from
+  uint32_t m_target;      //!< node the message is for
+};
+
+/**
+ * \ingroup mylib
+ * Payload of HEADER_ACCEPT_CHILD: the cluster id granted to the child
+ * and, with delegated admission, the first address of the tree address
+ * block the child owns.  A truncated grant deserializes to 0 bytes and
+ * cluster id 0.
+ */
+class ClusterGrantHeader : public Header
+{
+public:
+  /**
+   * \param delegated true when the tree uses delegated admission
+   */
+  ClusterGrantHeader (bool delegated = false);
+  virtual ~ClusterGrantHeader ();
+
+  /**
+   * \param clusterId the granted cluster id
+   */
+  void SetClusterId (uint16_t clusterId);
+  /**
+   * \return the granted cluster id
+   */
+  uint16_t GetClusterId (void) const;
+  /**
+   * \param treeAddress the child's tree address, delegated admission only
+   */
+  void SetTreeAddress (uint32_t treeAddress);
+  /**
+   * \return the child's tree address, delegated admission only
+   */
+  uint32_t GetTreeAddress (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+private:
+  bool m_delegated;       //!< carries a tree address
+  uint16_t m_clusterId;   //!< granted cluster id
+  uint32_t m_treeAddress; //!< first address of the child's block
+};
+
+/**
+ * \ingroup mylib
+ * Payload of HEADER_REQUEST_FATHER, HEADER_REQUEST_CLUSTER_FOR_CHILD and
+ * HEADER_RETURN_CLUSTER_FOR_CHILD: a node asking a father to adopt it,
+ * and that father asking the coordinator for permission, forwarded
+ * unchanged up and down the tree.  The subtree flag marks a child that
+ * rejoins after losing its father and brings its descendants along.
+ *
+ * Nodes are given by index and carried as their MAC address: 2 bytes in
+ * short addressing, 8 bytes in extended addressing (see
+ * ClusterTreeNetwork).  The receiver must construct the header with the
+ * same addressing mode as the sender.
+ *
+ * Like ClusterHeader, the payload headers never read past the end of the
+ * buffer: one that is too short deserializes to 0 bytes, leaving node
+ * fields at NO_NODE, and the receiver drops the frame.
+ */
+class ClusterJoinHeader : public Header
+{
+public:
+  /**
+   * \param extended true when the tree uses extended addresses
+   */
+  ClusterJoinHeader (bool extended = false);
+  virtual ~ClusterJoinHeader ();
+
+  /**
+   * \param father index of the node that wants to adopt
+   */
+  void SetFather (uint32_t father);
+  /**
+   * \return index of the node that wants to adopt
+   */
+  uint32_t GetFather (void) const;
+  /**
+   * \param child index of the node asking to be adopted
+   */
+  void SetChild (uint32_t child);
+  /**
+   * \return index of the node asking to be adopted
+   */
+  uint32_t GetChild (void) const;
+  /**
+   * \param subtree true if the child brings descendants
+   */
+  void SetSubtree (bool subtree);
+  /**
+   * \return true if the child brings descendants
+   */
+  bool HasSubtree (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+private:
+  bool m_extended;     //!< 8-byte instead of 2-byte addresses
+  uint32_t m_father;   //!< adopting node
+  uint32_t m_child;    //!< adopted node
+  bool m_subtree;      //!< the child rejoins with its descendants
+};
+
+/**
+ * \ingroup mylib
+ * Tail of HEADER_REJECT_CHILD: the father the coordinator suggests to
+ * the rejected child instead, ClusterTreeNetwork::NO_NODE for none.  On
+ * its way down to the refused father it follows a ClusterJoinHeader; the
+ * father strips that and passes the rest on to the child.  Addressed
+ * like ClusterJoinHeader.
+ */
+class ClusterRedirectHeader : public Header
+{
+public:
+  /**
+   * \param extended true when the tree uses extended addresses
+   */
+  ClusterRedirectHeader (bool extended = false);
+  virtual ~ClusterRedirectHeader ();
+
+  /**
+   * \param father index of the suggested father, NO_NODE for none
+   */
+  void SetFather (uint32_t father);
+  /**
+   * \return index of the suggested father, NO_NODE for none
+   */
+  uint32_t GetFather (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+private:
+  bool m_extended;     //!< 8-byte instead of 2-byte addresses
+  uint32_t m_father;   //!< suggested father
+};
+
+/**
+ * \ingroup mylib
+ * Payload of HEADER_BEACON: how many children the sender has and how
+ * much energy it has left.  The sender's cluster id (depth) is in its
+ * ClusterHeader; orphans score candidate fathers on all three.  A
+ * truncated beacon deserializes to 0 bytes as a full, empty sender.
+ */
+class ClusterBeaconHeader : public Header
+{
+public:
+  ClusterBeaconHeader ();
+  virtual ~ClusterBeaconHeader ();
+
+  /**
+   * \param nChildren children of the sender, saturated at 255
+   */
+  void SetNChildren (uint32_t nChildren);
+  /**
+   * \return children of the sender
+   */
+  uint8_t GetNChildren (void) const;
+  /**
+   * \param energy residual energy of the sender, 0 (empty) to 255 (full
+   * or no energy model)
+   */
+  void SetEnergy (uint8_t energy);
+  /**
+   * \return residual energy of the sender, 0 (empty) to 255 (full)
+   */
+  uint8_t GetEnergy (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+private:
+  uint8_t m_nChildren;   //!< children of the sender
+  uint8_t m_energy;      //!< residual energy of the sender
+};
+
+/**
+ * \ingroup mylib
+ * Prefix of HEADER_SEND_DATA_TO_COORDINATOR payloads: the node that
+ * produced the reading, which relays leave untouched.  Addressing as in
+ * ClusterJoinHeader.
+ */
+class ClusterDataHeader : public Header
+{
+public:
+  /**
+   * \param extended true when the tree uses extended addresses
+   */
+  ClusterDataHeader (bool extended = false);
+  virtual ~ClusterDataHeader ();
+
+  /**
+   * \param originator index of the node that produced the reading
+   */
+  void SetOriginator (uint32_t originator);
+  /**
+   * \return index of the node that produced the reading
+   */
+  uint32_t GetOriginator (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+private:
+  bool m_extended;        //!< 8-byte instead of 2-byte addresses
+  uint32_t m_originator;  //!< node that produced the reading
+};
+
+/**
+ * \ingroup mylib
+ * One reading inside a HEADER_SEND_AGGREGATE_TO_COORDINATOR frame: the
+ * node that produced it and its size, followed by the reading itself.
+ * An aggregate payload is a plain sequence of such records.  Addressing
+ * as in ClusterJoinHeader.
+ */
+class ClusterRecordHeader : public Header
+{
+public:
+  /**
+   * \param extended true when the tree uses extended addresses
+   */
+  ClusterRecordHeader (bool extended = false);
+  virtual ~ClusterRecordHeader ();
+
+  /**
+   * \param originator index of the node that produced the reading
+   */
+  void SetOriginator (uint32_t originator);
+  /**
+   * \return index of the node that produced the reading
+   */
+  uint32_t GetOriginator (void) const;
+  /**
+   * \param size reading size in bytes, at most 255
    */
-  void SetData (uint16_t data);
+  void SetSize (uint8_t size);
   /**
-   * Get the header data.
-   * \return The data.
+   * \return reading size in bytes
    */
-  uint16_t GetData (void) const;
+  uint8_t GetSize (void) const;
 
   /**
    * \brief Get the type ID.
@@ -57,7 +451,9 @@ public:
   virtual uint32_t Deserialize (Buffer::Iterator start);
   virtual uint32_t GetSerializedSize (void) const;
 private:
-  uint16_t m_data;  //!< Header data
+  bool m_extended;        //!< 8-byte instead of 2-byte addresses
+  uint32_t m_originator;  //!< node that produced the reading
+  uint8_t m_size;         //!< reading size
 };
 
 }
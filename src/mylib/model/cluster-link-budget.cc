@@ -0,0 +1,339 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/double.h>
+#include <ns3/enum.h>
+#include <ns3/mobility-model.h>
+#include <ns3/propagation-loss-model.h>
+#include "ns3/cluster-link-budget.h"
+#include "ns3/cluster-spatial-index.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterLinkBudget");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterLinkBudget);
+
+TypeId
+ClusterLinkBudget::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterLinkBudget")
+    .SetParent<Object> ()
+    .AddConstructor<ClusterLinkBudget> ()
+    .AddAttribute ("Mode",
+                   "How link gains are stored.",
+                   EnumValue (ClusterLinkBudget::SPARSE),
+                   MakeEnumAccessor (&ClusterLinkBudget::m_mode),
+                   MakeEnumChecker (ClusterLinkBudget::DENSE, "Dense",
+                                    ClusterLinkBudget::SPARSE, "Sparse"))
+    .AddAttribute ("Floor",
+                   "In Sparse mode, links whose gain (dBm received for 0 dBm sent) is below this are not stored. "
+                   "Keep it at or below the receivers' RxSensitivity minus TxPower.",
+                   DoubleValue (-90.0),
+                   MakeDoubleAccessor (&ClusterLinkBudget::m_floorDbm),
+                   MakeDoubleChecker<double> ())
+  ;
+  return tid;
+}
+
+ClusterLinkBudget::ClusterLinkBudget ()
+  : m_mode (SPARSE),
+    m_floorDbm (-90.0),
+    m_range (0.0),
+    m_denseN (0),
+    m_entries (16),
+    m_used (0)
+{
+}
+
+ClusterLinkBudget::~ClusterLinkBudget ()
+{
+}
+
+void
+ClusterLinkBudget::DoDispose (void)
+{
+  m_loss = 0;
+  m_spatialIndex = 0;
+  m_mobility.clear ();
+  m_dense.clear ();
+  m_entries.clear ();
+  m_rowComplete.clear ();
+  Object::DoDispose ();
+}
+
+void
+ClusterLinkBudget::SetPropagationLossModel (Ptr<PropagationLossModel> loss)
+{
+  m_loss = loss;
+  InvalidateAll ();
+}
+
+void
+ClusterLinkBudget::SetSpatialIndex (Ptr<ClusterSpatialIndex> index, double range)
+{
+  m_spatialIndex = index;
+  m_range = range;
+  InvalidateAll ();
+}
+
+double
+ClusterLinkBudget::GetFloor (void) const
+{
+  return m_floorDbm;
+}
+
+uint32_t
+ClusterLinkBudget::AddNode (Ptr<MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << mobility);
+  uint32_t index = m_mobility.size ();
+  m_mobility.push_back (mobility);
+  m_rowComplete.push_back (0);
+  // 用context告诉回调是哪个节点动了
+  std::ostringstream context;
+  context << index;
+  mobility->TraceConnect ("CourseChange", context.str (),
+                          MakeCallback (&ClusterLinkBudget::CourseChanged, this));
+  // 算好的行里没有新节点，哪怕这一行一条链路都没存（孤立节点）也要重算
+  if (m_mode == SPARSE
+      && std::find (m_rowComplete.begin (), m_rowComplete.end (), 1) != m_rowComplete.end ())
+    {
+      InvalidateAll ();
+    }
+  return index;
+}
+
+uint32_t
+ClusterLinkBudget::GetN (void) const
+{
+  return m_mobility.size ();
+}
+
+double
+ClusterLinkBudget::Compute (uint32_t src, uint32_t dst) const
+{
+  return m_loss->CalcRxPower (0.0, m_mobility[src], m_mobility[dst]);
+}
+
+double
+ClusterLinkBudget::GetGainDb (uint32_t src, uint32_t dst)
+{
+  NS_ASSERT (src < m_mobility.size () && dst < m_mobility.size ());
+  if (m_mode == DENSE)
+    {
+      EnsureDense ();
+      float &gain = m_dense[uint64_t (src) * m_denseN + dst];
+      if (std::isnan (gain))
+        {
+          gain = Compute (src, dst);
+        }
+      return gain;
+    }
+
+  if (!m_rowComplete[src])
+    {
+      BuildRow (src);
+    }
+  uint64_t key = 1 + (uint64_t (src) << 32 | dst);
+  const Entry &entry = m_entries[FindSlot (key)];
+  if (entry.key == key)
+    {
+      return entry.gain;
+    }
+  return -std::numeric_limits<double>::infinity ();
+}
+
+double
+ClusterLinkBudget::GetRxPowerDbm (uint32_t src, uint32_t dst, double txPowerDbm)
+{
+  return txPowerDbm + GetGainDb (src, dst);
+}
+
+void
+ClusterLinkBudget::Precompute (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t n = m_mobility.size ();
+  for (uint32_t src = 0; src < n; ++src)
+    {
+      if (m_mode == DENSE)
+        {
+          for (uint32_t dst = 0; dst < n; ++dst)
+            {
+              GetGainDb (src, dst);
+            }
+        }
+      else if (!m_rowComplete[src])
+        {
+          BuildRow (src);
+        }
+    }
+}
+
+void
+ClusterLinkBudget::Invalidate (uint32_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+  if (m_mode == SPARSE)
+    {
+      InvalidateAll ();
+      return;
+    }
+  if (m_denseN == 0 || index >= m_denseN)
+    {
+      return;
+    }
+  float unknown = std::numeric_limits<float>::quiet_NaN ();
+  for (uint32_t k = 0; k < m_denseN; ++k)
+    {
+      m_dense[uint64_t (index) * m_denseN + k] = unknown;
+      m_dense[uint64_t (k) * m_denseN + index] = unknown;
+    }
+}
+
+void
+ClusterLinkBudget::InvalidateAll (void)
+{
+  m_dense.clear ();
+  m_denseN = 0;
+  m_entries.assign (16, Entry ());
+  m_used = 0;
+  m_rowComplete.assign (m_mobility.size (), 0);
+}
+
+void
+ClusterLinkBudget::CourseChanged (std::string context, Ptr<const MobilityModel> mobility)
+{
+  uint32_t index = std::stoul (context);
+  NS_LOG_LOGIC ("node " << index << " moved, dropping its link gains");
+  Invalidate (index);
+}
+
+void
+ClusterLinkBudget::EnsureDense (void)
+{
+  uint32_t n = m_mobility.size ();
+  if (m_denseN != n)
+    {
+      m_dense.assign (uint64_t (n) * n, std::numeric_limits<float>::quiet_NaN ());
+      m_denseN = n;
+    }
+}
+
+void
+ClusterLinkBudget::BuildRow (uint32_t src)
+{
+  if (m_spatialIndex != 0 && m_spatialIndex->GetN () == m_mobility.size ())
+    {
+      // 只算范围内的候选节点，范围外的增益一定低于Floor
+      std::vector<uint32_t> candidates;
+      m_spatialIndex->GetNeighbors (src, m_range, candidates);
+      for (std::vector<uint32_t>::const_iterator i = candidates.begin (); i != candidates.end (); ++i)
+        {
+          StoreIfUsable (src, *i);
+        }
+    }
+  else
+    {
+      uint32_t n = m_mobility.size ();
+      for (uint32_t dst = 0; dst < n; ++dst)
+        {
+          if (dst != src)
+            {
+              StoreIfUsable (src, dst);
+            }
+        }
+    }
+  m_rowComplete[src] = 1;
+}
+
+void
+ClusterLinkBudget::StoreIfUsable (uint32_t src, uint32_t dst)
+{
+  double gain = Compute (src, dst);
+  if (gain >= m_floorDbm)
+    {
+      Insert (1 + (uint64_t (src) << 32 | dst), gain);
+    }
+}
+
+uint64_t
+ClusterLinkBudget::FindSlot (uint64_t key) const
+{
+  uint64_t mask = m_entries.size () - 1;
+  uint64_t hash = key * 0x9e3779b97f4a7c15ULL;
+  uint64_t slot = (hash ^ (hash >> 32)) & mask;
+  while (m_entries[slot].key != 0 && m_entries[slot].key != key)
+    {
+      slot = (slot + 1) & mask;
+    }
+  return slot;
+}
+
+void
+ClusterLinkBudget::Insert (uint64_t key, float gain)
+{
+  if ((m_used + 1) * 2 > m_entries.size ())
+    {
+      std::vector<Entry> old;
+      old.swap (m_entries);
+      m_entries.resize (old.size () * 2);
+      for (std::vector<Entry>::const_iterator i = old.begin (); i != old.end (); ++i)
+        {
+          if (i->key != 0)
+            {
+              m_entries[FindSlot (i->key)] = *i;
+            }
+        }
+    }
+  Entry &entry = m_entries[FindSlot (key)];
+  if (entry.key == 0)
+    {
+      m_used++;
+    }
+  entry.key = key;
+  entry.gain = gain;
+}
+
+uint64_t
+ClusterLinkBudget::GetNLinks (void) const
+{
+  if (m_mode == SPARSE)
+    {
+      return m_used;
+    }
+  uint64_t links = 0;
+  for (std::vector<float>::const_iterator i = m_dense.begin (); i != m_dense.end (); ++i)
+    {
+      links += !std::isnan (*i);
+    }
+  return links;
+}
+
+uint64_t
+ClusterLinkBudget::GetMemoryUsage (void) const
+{
+  return m_dense.capacity () * sizeof (float)
+         + m_entries.capacity () * sizeof (Entry)
+         + m_rowComplete.capacity ();
+}
+
+}
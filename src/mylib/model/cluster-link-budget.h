@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_LINK_BUDGET_H
+#define CLUSTER_LINK_BUDGET_H
+
+#include <ns3/object.h>
+#include <vector>
+#include <string>
+
+namespace ns3 {
+
+class MobilityModel;
+class PropagationLossModel;
+class ClusterSpatialIndex;
+
+/**
+ * \ingroup mylib
+ *
+ * Cache of the link gain (received power in dBm for a 0 dBm transmitter)
+ * between every pair of nodes of a cluster tree, keyed by node index.
+ *
+ * Gains are computed with the tree's PropagationLossModel the first time
+ * a pair is queried and reused until the MobilityModel of either end
+ * fires CourseChange.  The loss model must therefore be deterministic.
+ *
+ * Two storage modes are available:
+ *  - DENSE keeps an N x N float matrix, filled lazily per pair;
+ *  - SPARSE evaluates the row of a transmitter on first use, against
+ *    every node or only the candidates of a ClusterSpatialIndex, and
+ *    keeps only links whose gain reaches the Floor attribute, in one
+ *    open-addressing hash table, so memory follows the number of usable
+ *    links instead of N^2.  Links below the floor read as -infinity.
+ */
+class ClusterLinkBudget : public Object
+{
+public:
+  /// How link gains are stored.
+  enum StorageMode
+  {
+    DENSE,
+    SPARSE
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterLinkBudget ();
+  virtual ~ClusterLinkBudget ();
+
+  /**
+   * \param loss the loss model of the tree's channel
+   */
+  void SetPropagationLossModel (Ptr<PropagationLossModel> loss);
+  /**
+   * Restrict SPARSE row evaluation to the nodes index returns within
+   * range, instead of every node.  range must cover every link whose gain
+   * reaches Floor.
+   * \param index spatial index over the same node indices
+   * \param range distance at which the gain falls below Floor
+   */
+  void SetSpatialIndex (Ptr<ClusterSpatialIndex> index, double range);
+  /**
+   * \return the gain under which SPARSE links are not stored
+   */
+  double GetFloor (void) const;
+  /**
+   * Register the next node and watch its CourseChange trace.
+   * \param mobility the node's mobility model
+   * \return the node index
+   */
+  uint32_t AddNode (Ptr<MobilityModel> mobility);
+  /**
+   * \return the number of registered nodes
+   */
+  uint32_t GetN (void) const;
+
+  /**
+   * \param src transmitter index
+   * \param dst receiver index
+   * \return the link gain in dB, -infinity if below Floor in SPARSE mode
+   */
+  double GetGainDb (uint32_t src, uint32_t dst);
+  /**
+   * \param src transmitter index
+   * \param dst receiver index
+   * \param txPowerDbm transmit power
+   * \return the received power in dBm
+   */
+  double GetRxPowerDbm (uint32_t src, uint32_t dst, double txPowerDbm);
+
+  /**
+   * Evaluate every pair now instead of on first use.
+   */
+  void Precompute (void);
+  /**
+   * Forget the gains of every link that has index as an end.  SPARSE
+   * entries are not indexed by receiver, so that mode drops the whole
+   * table and re-evaluates rows on demand.
+   * \param index node index
+   */
+  void Invalidate (uint32_t index);
+  /**
+   * Forget every cached gain.
+   */
+  void InvalidateAll (void);
+
+  /**
+   * \return the number of stored link gains
+   */
+  uint64_t GetNLinks (void) const;
+  /**
+   * \return the bytes used by the gain storage
+   */
+  uint64_t GetMemoryUsage (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// One SPARSE table slot; key 0 marks an empty slot.
+  struct Entry
+  {
+    uint64_t key;  //!< 1 + (src << 32 | dst)
+    float gain;    //!< link gain in dB
+  };
+
+  /**
+   * CourseChange trace sink.
+   * \param context the node index
+   * \param mobility the mobility model that moved
+   */
+  void CourseChanged (std::string context, Ptr<const MobilityModel> mobility);
+  /**
+   * \param src transmitter index
+   * \param dst receiver index
+   * \return the gain given by the loss model
+   */
+  double Compute (uint32_t src, uint32_t dst) const;
+  /**
+   * Evaluate the row of src and store the links above Floor.
+   * \param src transmitter index
+   */
+  void BuildRow (uint32_t src);
+  /**
+   * Compute one link and store it if it reaches Floor.
+   * \param src transmitter index
+   * \param dst receiver index
+   */
+  void StoreIfUsable (uint32_t src, uint32_t dst);
+  /**
+   * Size the DENSE matrix for the current node count.
+   */
+  void EnsureDense (void);
+  /**
+   * \param key SPARSE key
+   * \return the slot holding key, or the empty slot ending its probe chain
+   */
+  uint64_t FindSlot (uint64_t key) const;
+  /**
+   * Store a SPARSE link.
+   * \param key SPARSE key
+   * \param gain link gain in dB
+   */
+  void Insert (uint64_t key, float gain);
+
+  StorageMode m_mode;                           //!< storage mode
+  double m_floorDbm;                            //!< SPARSE keeps links at or above this gain
+  Ptr<PropagationLossModel> m_loss;             //!< loss model
+  Ptr<ClusterSpatialIndex> m_spatialIndex;      //!< candidate receivers for BuildRow, may be null
+  double m_range;                               //!< query radius of m_spatialIndex
+  std::vector<Ptr<MobilityModel> > m_mobility;  //!< mobility per node index
+
+  std::vector<float> m_dense;          //!< DENSE matrix, NaN when not computed
+  uint32_t m_denseN;                   //!< node count m_dense is sized for
+  std::vector<Entry> m_entries;        //!< SPARSE open-addressing table
+  uint64_t m_used;                     //!< occupied SPARSE slots
+  std::vector<uint8_t> m_rowComplete;  //!< SPARSE rows already evaluated
+};
+
+}
+#endif /* CLUSTER_LINK_BUDGET_H */
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include "ns3/cluster-packet-pool.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterPacketPool");
+
+const uint32_t ClusterPacketPool::MAX_PROBES;
+
+ClusterPacketPool::ClusterPacketPool ()
+  : m_capacity (0),
+    m_next (0),
+    m_allocated (0),
+    m_recycled (0)
+{
+}
+
+void
+ClusterPacketPool::SetCapacity (uint32_t capacity)
+{
+  m_capacity = capacity;
+  if (m_packets.size () > capacity)
+    {
+      m_packets.resize (capacity);
+      m_next = 0;
+    }
+}
+
+uint32_t
+ClusterPacketPool::GetCapacity (void) const
+{
+  return m_capacity;
+}
+
+Ptr<Packet>
+ClusterPacketPool::Allocate (uint32_t payloadSize)
+{
+  // 从上次停下的地方往后找，确认大体按发送顺序回来，通常第一个就是空闲的
+  uint32_t probes = std::min<uint32_t> (m_packets.size (), MAX_PROBES);
+  for (uint32_t n = 0; n < probes; ++n)
+    {
+      Ptr<Packet> p = m_packets[m_next];
+      m_next = m_next + 1 == m_packets.size () ? 0 : m_next + 1;
+      // 局部变量 p 也占一个引用，只剩池子和它时就没人在用了
+      if (p->GetReferenceCount () == 2)
+        {
+          p->RemoveAtStart (p->GetSize ());
+          p->RemoveAllPacketTags ();
+          p->RemoveAllByteTags ();
+          if (payloadSize != 0)
+            {
+              p->AddPaddingAtEnd (payloadSize);
+            }
+          m_recycled++;
+          return p;
+        }
+    }
+  Ptr<Packet> p = Create<Packet> (payloadSize);
+  m_allocated++;
+  if (m_packets.size () < m_capacity)
+    {
+      m_packets.push_back (p);
+    }
+  return p;
+}
+
+uint64_t
+ClusterPacketPool::GetNAllocated (void) const
+{
+  return m_allocated;
+}
+
+uint64_t
+ClusterPacketPool::GetNRecycled (void) const
+{
+  return m_recycled;
+}
+
+void
+ClusterPacketPool::Clear (void)
+{
+  m_packets.clear ();
+  m_next = 0;
+}
+
+}
@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_PACKET_POOL_H
+#define CLUSTER_PACKET_POOL_H
+
+#include <ns3/packet.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mylib
+ *
+ * Recycles the Packets of cluster tree control frames.
+ *
+ * Up to Capacity packets are owned by the pool.  A pooled packet whose
+ * only reference is the pool's (the MAC, the PHYs and the scheduler are
+ * done with it) is emptied and handed out again instead of allocating a
+ * new Packet; its Buffer keeps its storage, so the header bytes are
+ * written in place.  Free packets are looked for round-robin, which
+ * matches the order frames are confirmed, at most MAX_PROBES per call.  Payloads are zero padding and
+ * take no storage.
+ *
+ * A recycled packet keeps its uid, so packets of different frames may
+ * share one.  With Capacity 0 every Allocate is a plain Create<Packet>.
+ */
+class ClusterPacketPool
+{
+public:
+  /// Pooled packets checked per Allocate before creating a new one.
+  static const uint32_t MAX_PROBES = 16;
+
+  ClusterPacketPool ();
+
+  /**
+   * Set how many packets the pool may own; extra ones are released.
+   * \param capacity the pool size
+   */
+  void SetCapacity (uint32_t capacity);
+  /**
+   * \return how many packets the pool may own
+   */
+  uint32_t GetCapacity (void) const;
+
+  /**
+   * \param payloadSize zero bytes in the packet
+   * \return an empty packet with payloadSize bytes of padding and no tags
+   */
+  Ptr<Packet> Allocate (uint32_t payloadSize);
+  /**
+   * \return packets created since construction
+   */
+  uint64_t GetNAllocated (void) const;
+  /**
+   * \return packets handed out again since construction
+   */
+  uint64_t GetNRecycled (void) const;
+  /**
+   * Release every pooled packet.
+   */
+  void Clear (void);
+
+private:
+  std::vector<Ptr<Packet> > m_packets; //!< pooled packets
+  uint32_t m_capacity;                 //!< largest pool size
+  uint32_t m_next;                     //!< where the next free packet is looked for
+  uint64_t m_allocated;                //!< packets created
+  uint64_t m_recycled;                 //!< packets reused
+};
+
+}
+#endif /* CLUSTER_PACKET_POOL_H */
@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/double.h>
+#include <ns3/enum.h>
+#include "ns3/cluster-parent-selector.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterParentSelector");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterParentSelector);
+NS_OBJECT_ENSURE_REGISTERED (ClusterWeightedParentSelector);
+
+ClusterParentCandidate::ClusterParentCandidate ()
+  : node (0),
+    clusterId (0),
+    nChildren (0),
+    linkMarginDb (0.0),
+    lqi (0),
+    energy (255)
+{
+}
+
+TypeId
+ClusterParentSelector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterParentSelector")
+    .SetParent<Object> ()
+  ;
+  return tid;
+}
+
+ClusterParentSelector::ClusterParentSelector ()
+{
+}
+
+ClusterParentSelector::~ClusterParentSelector ()
+{
+}
+
+TypeId
+ClusterWeightedParentSelector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterWeightedParentSelector")
+    .SetParent<ClusterParentSelector> ()
+    .AddConstructor<ClusterWeightedParentSelector> ()
+    .AddAttribute ("LinkMetric",
+                   "Link quality indicator that is scored.",
+                   EnumValue (ClusterWeightedParentSelector::LINK_RSSI),
+                   MakeEnumAccessor (&ClusterWeightedParentSelector::m_linkMetric),
+                   MakeEnumChecker (ClusterWeightedParentSelector::LINK_RSSI, "Rssi",
+                                    ClusterWeightedParentSelector::LINK_LQI, "Lqi"))
+    .AddAttribute ("GoodLink",
+                   "Link quality in dB above RxSensitivity beyond which every link scores the same.",
+                   DoubleValue (10.0),
+                   MakeDoubleAccessor (&ClusterWeightedParentSelector::m_goodLink),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("LinkWeight",
+                   "Score per dB of link quality.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&ClusterWeightedParentSelector::m_linkWeight),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("DepthWeight",
+                   "Score lost per level of depth of the candidate.",
+                   DoubleValue (5.0),
+                   MakeDoubleAccessor (&ClusterWeightedParentSelector::m_depthWeight),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("ChildWeight",
+                   "Score lost per child the candidate already has.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&ClusterWeightedParentSelector::m_childWeight),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("EnergyWeight",
+                   "Score lost by a candidate whose battery is empty, in proportion to the energy it has used; "
+                   "0 ignores residual energy.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&ClusterWeightedParentSelector::m_energyWeight),
+                   MakeDoubleChecker<double> ())
+  ;
+  return tid;
+}
+
+ClusterWeightedParentSelector::ClusterWeightedParentSelector ()
+  : m_linkMetric (LINK_RSSI),
+    m_goodLink (10.0),
+    m_linkWeight (1.0),
+    m_depthWeight (5.0),
+    m_childWeight (1.0),
+    m_energyWeight (0.0)
+{
+}
+
+ClusterWeightedParentSelector::~ClusterWeightedParentSelector ()
+{
+}
+
+double
+ClusterWeightedParentSelector::Score (const ClusterParentCandidate &candidate) const
+{
+  double link = candidate.linkMarginDb;
+  if (m_linkMetric == LINK_LQI)
+    {
+      link = candidate.lqi * m_goodLink / 255.0;
+    }
+  // 信号够好就不再加分，这时候浅的、儿子少的优先
+  link = std::min (link, m_goodLink);
+  return m_linkWeight * link - m_depthWeight * candidate.clusterId - m_childWeight * candidate.nChildren
+         - m_energyWeight * (255 - candidate.energy) / 255.0;
+}
+
+}
@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_PARENT_SELECTOR_H
+#define CLUSTER_PARENT_SELECTOR_H
+
+#include <ns3/object.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup mylib
+ * A father an orphan heard during its collection window: what the beacon
+ * advertised and how well it was received.
+ */
+struct ClusterParentCandidate
+{
+  /// A candidate heard at RxSensitivity advertising nothing, with a full battery.
+  ClusterParentCandidate ();
+
+  uint32_t node;          //!< index of the candidate
+  uint16_t clusterId;     //!< advertised cluster id (depth)
+  uint8_t nChildren;      //!< advertised child count
+  double linkMarginDb;    //!< received power above RxSensitivity
+  uint8_t lqi;            //!< LQI the MAC reported for the beacon
+  uint8_t energy;         //!< advertised residual energy, 255 when full
+};
+
+/**
+ * \ingroup mylib
+ *
+ * Ranks the candidate fathers of an orphan.  The orphan asks the best
+ * scored candidate first and falls back on the others in score order.
+ * Subclass to plug another metric into ClusterTreeHelper.
+ */
+class ClusterParentSelector : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterParentSelector ();
+  virtual ~ClusterParentSelector ();
+
+  /**
+   * \param candidate a father heard by the orphan
+   * \return its score, higher is better
+   */
+  virtual double Score (const ClusterParentCandidate &candidate) const = 0;
+};
+
+/**
+ * \ingroup mylib
+ *
+ * Default selector: a weighted sum of the link quality, capped at
+ * GoodLink, minus the depth and the child count of the candidate.
+ * Links better than GoodLink are all equally good, so the shallowest and
+ * least loaded of them wins; below it a hop is traded for DepthWeight /
+ * LinkWeight dB of margin.  A non-zero EnergyWeight also takes off up to
+ * that much for a candidate whose battery is empty, in proportion to the
+ * energy it has used, so drained fathers are avoided.
+ */
+class ClusterWeightedParentSelector : public ClusterParentSelector
+{
+public:
+  /// Which link quality indicator is scored.
+  enum LinkMetric
+  {
+    LINK_RSSI,  //!< received power above RxSensitivity, in dB
+    LINK_LQI    //!< MAC LQI, scaled so that 255 reads as GoodLink
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterWeightedParentSelector ();
+  virtual ~ClusterWeightedParentSelector ();
+
+  virtual double Score (const ClusterParentCandidate &candidate) const;
+
+private:
+  LinkMetric m_linkMetric;  //!< scored link indicator
+  double m_goodLink;        //!< link quality, in dB, beyond which links score the same
+  double m_linkWeight;      //!< score per dB of link quality
+  double m_depthWeight;     //!< score lost per level of depth
+  double m_childWeight;     //!< score lost per child of the candidate
+  double m_energyWeight;    //!< score lost by a candidate with an empty battery
+};
+
+}
+#endif /* CLUSTER_PARENT_SELECTOR_H */
@@ -0,0 +1,241 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/double.h>
+#include <ns3/simulator.h>
+#include "ns3/cluster-radio-energy-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterRadioEnergyModel");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterRadioEnergyModel);
+
+TypeId
+ClusterRadioEnergyModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterRadioEnergyModel")
+    .SetParent<DeviceEnergyModel> ()
+    .AddConstructor<ClusterRadioEnergyModel> ()
+    .AddAttribute ("TxCurrentA",
+                   "Current (A) while transmitting.",
+                   DoubleValue (0.0174),
+                   MakeDoubleAccessor (&ClusterRadioEnergyModel::m_txCurrentA),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("RxCurrentA",
+                   "Current (A) while receiving a frame.",
+                   DoubleValue (0.0197),
+                   MakeDoubleAccessor (&ClusterRadioEnergyModel::m_rxCurrentA),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("ListenCurrentA",
+                   "Current (A) while the receiver is on without a frame; "
+                   "lower it to approximate a duty-cycled MAC.",
+                   DoubleValue (0.0197),
+                   MakeDoubleAccessor (&ClusterRadioEnergyModel::m_listenCurrentA),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("IdleCurrentA",
+                   "Current (A) while the transceiver is on but neither transmitting nor listening.",
+                   DoubleValue (0.000426),
+                   MakeDoubleAccessor (&ClusterRadioEnergyModel::m_idleCurrentA),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("SleepCurrentA",
+                   "Current (A) while the transceiver is off.",
+                   DoubleValue (0.00002),
+                   MakeDoubleAccessor (&ClusterRadioEnergyModel::m_sleepCurrentA),
+                   MakeDoubleChecker<double> (0))
+    .AddTraceSource ("TotalEnergyConsumption",
+                     "Energy (J) the radio has drawn, updated on every state change.",
+                     MakeTraceSourceAccessor (&ClusterRadioEnergyModel::m_totalEnergyConsumption),
+                     "ns3::TracedValueCallback::Double")
+  ;
+  return tid;
+}
+
+ClusterRadioEnergyModel::ClusterRadioEnergyModel ()
+  : m_txCurrentA (0.0174),
+    m_rxCurrentA (0.0197),
+    m_listenCurrentA (0.0197),
+    m_idleCurrentA (0.000426),
+    m_sleepCurrentA (0.00002),
+    m_state (RADIO_SLEEP),
+    m_totalEnergyConsumption (0),
+    m_depleted (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ClusterRadioEnergyModel::~ClusterRadioEnergyModel ()
+{
+}
+
+void
+ClusterRadioEnergyModel::DoDispose (void)
+{
+  m_source = 0;
+  m_phy = 0;
+  m_depletionCallback.Nullify ();
+  DeviceEnergyModel::DoDispose ();
+}
+
+void
+ClusterRadioEnergyModel::AttachPhy (Ptr<LrWpanPhy> phy)
+{
+  m_phy = phy;
+  m_lastUpdate = Simulator::Now ();
+  phy->TraceConnectWithoutContext ("TrxState", MakeCallback (&ClusterRadioEnergyModel::TrxStateChanged, this));
+}
+
+void
+ClusterRadioEnergyModel::SetEnergyDepletionCallback (Callback<void> callback)
+{
+  m_depletionCallback = callback;
+}
+
+void
+ClusterRadioEnergyModel::SetEnergySource (Ptr<EnergySource> source)
+{
+  m_source = source;
+}
+
+double
+ClusterRadioEnergyModel::GetStateCurrentA (RadioState state) const
+{
+  switch (state)
+    {
+    case RADIO_TX:
+      return m_txCurrentA;
+    case RADIO_RX:
+      return m_rxCurrentA;
+    case RADIO_LISTEN:
+      return m_listenCurrentA;
+    case RADIO_IDLE:
+      return m_idleCurrentA;
+    default:
+      return m_sleepCurrentA;
+    }
+}
+
+double
+ClusterRadioEnergyModel::DoGetCurrentA (void) const
+{
+  return GetStateCurrentA (m_state);
+}
+
+double
+ClusterRadioEnergyModel::GetTotalEnergyConsumption (void) const
+{
+  // 加上当前状态里还没记账的那一段
+  double voltage = m_source != 0 ? m_source->GetSupplyVoltage () : 0;
+  double pending = (Simulator::Now () - m_lastUpdate).GetSeconds () * GetStateCurrentA (m_state) * voltage;
+  return m_totalEnergyConsumption + pending;
+}
+
+void
+ClusterRadioEnergyModel::TrxStateChanged (Time now, LrWpanPhyEnumeration oldState, LrWpanPhyEnumeration newState)
+{
+  RadioState state = RADIO_IDLE;
+  switch (newState)
+    {
+    case IEEE_802_15_4_PHY_BUSY_TX:
+      state = RADIO_TX;
+      break;
+    case IEEE_802_15_4_PHY_BUSY_RX:
+      state = RADIO_RX;
+      break;
+    case IEEE_802_15_4_PHY_RX_ON:
+      state = RADIO_LISTEN;
+      break;
+    case IEEE_802_15_4_PHY_TRX_OFF:
+    case IEEE_802_15_4_PHY_FORCE_TRX_OFF:
+      state = RADIO_SLEEP;
+      break;
+    default:
+      break;
+    }
+  ChangeState (state);
+}
+
+void
+ClusterRadioEnergyModel::ChangeState (int newState)
+{
+  NS_LOG_FUNCTION (this << newState);
+  // 先按旧状态的电流记账并更新电池，再换状态
+  Time now = Simulator::Now ();
+  Time duration = now - m_lastUpdate;
+  if (m_source != 0)
+    {
+      m_totalEnergyConsumption += duration.GetSeconds () * GetStateCurrentA (m_state) * m_source->GetSupplyVoltage ();
+    }
+  m_timeInState[m_state] += duration;
+  m_lastUpdate = now;
+  if (m_source != 0)
+    {
+      m_source->UpdateEnergySource ();
+    }
+  m_state = RadioState (newState);
+}
+
+void
+ClusterRadioEnergyModel::HandleEnergyDepletion (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_depleted)
+    {
+      return;
+    }
+  m_depleted = true;
+  // 电池更新还没返回，关机放到下一个事件里，免得在这里又改状态
+  Simulator::ScheduleNow (&ClusterRadioEnergyModel::NotifyDepletion, this);
+}
+
+void
+ClusterRadioEnergyModel::NotifyDepletion (void)
+{
+  if (!m_depletionCallback.IsNull ())
+    {
+      m_depletionCallback ();
+    }
+}
+
+void
+ClusterRadioEnergyModel::HandleEnergyRecharged (void)
+{
+  m_depleted = false;
+}
+
+void
+ClusterRadioEnergyModel::HandleEnergyChanged (void)
+{
+}
+
+ClusterRadioEnergyModel::RadioState
+ClusterRadioEnergyModel::GetState (void) const
+{
+  return m_state;
+}
+
+Time
+ClusterRadioEnergyModel::GetTimeInState (RadioState state) const
+{
+  Time time = m_timeInState[state];
+  if (state == m_state)
+    {
+      time += Simulator::Now () - m_lastUpdate;
+    }
+  return time;
+}
+
+}
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_RADIO_ENERGY_MODEL_H
+#define CLUSTER_RADIO_ENERGY_MODEL_H
+
+#include <ns3/device-energy-model.h>
+#include <ns3/energy-source.h>
+#include <ns3/nstime.h>
+#include <ns3/traced-value.h>
+#include <ns3/callback.h>
+#include <ns3/lr-wpan-phy.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup mylib
+ *
+ * Current drawn by an IEEE 802.15.4 radio, following the transceiver
+ * state of one LrWpanPhy.
+ *
+ * The states are those the PHY reports through its TrxState trace:
+ * transmitting (BUSY_TX), receiving a frame (BUSY_RX), listening for one
+ * (RX_ON), switched off (TRX_OFF and FORCE_TRX_OFF) and idle otherwise.
+ * The default currents are the CC2420 datasheet figures at 0 dBm.  The
+ * MAC keeps the receiver on between frames, so listening dominates; a
+ * duty-cycled MAC can be approximated by a lower ListenCurrent.
+ *
+ * When the source runs out, the depletion callback is called once, e.g.
+ * to switch the node off.
+ */
+class ClusterRadioEnergyModel : public DeviceEnergyModel
+{
+public:
+  /// Radio states with their own current.
+  enum RadioState
+  {
+    RADIO_SLEEP,   //!< transceiver off
+    RADIO_IDLE,    //!< on, neither transmitting nor listening
+    RADIO_LISTEN,  //!< receiver on, no frame
+    RADIO_RX,      //!< receiving a frame
+    RADIO_TX       //!< transmitting a frame
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterRadioEnergyModel ();
+  virtual ~ClusterRadioEnergyModel ();
+
+  /**
+   * Follow the transceiver state of phy.
+   * \param phy the radio
+   */
+  void AttachPhy (Ptr<LrWpanPhy> phy);
+  /**
+   * \param callback called once when the source is depleted
+   */
+  void SetEnergyDepletionCallback (Callback<void> callback);
+
+  virtual void SetEnergySource (Ptr<EnergySource> source);
+  virtual double GetTotalEnergyConsumption (void) const;
+  virtual void ChangeState (int newState);
+  virtual void HandleEnergyDepletion (void);
+  virtual void HandleEnergyRecharged (void);
+  virtual void HandleEnergyChanged (void);
+
+  /**
+   * \return the current RadioState
+   */
+  RadioState GetState (void) const;
+  /**
+   * \param state a RadioState
+   * \return the time spent in it so far
+   */
+  Time GetTimeInState (RadioState state) const;
+
+private:
+  virtual void DoDispose (void);
+  virtual double DoGetCurrentA (void) const;
+
+  /**
+   * \param state a RadioState
+   * \return its current in A
+   */
+  double GetStateCurrentA (RadioState state) const;
+  /**
+   * LrWpanPhy TrxState sink.
+   * \param now time of the change
+   * \param oldState state before
+   * \param newState state after
+   */
+  void TrxStateChanged (Time now, LrWpanPhyEnumeration oldState, LrWpanPhyEnumeration newState);
+  /**
+   * Call the depletion callback, outside of the source update.
+   */
+  void NotifyDepletion (void);
+
+  Ptr<EnergySource> m_source;   //!< battery of the node
+  Ptr<LrWpanPhy> m_phy;         //!< followed radio
+  double m_txCurrentA;          //!< BUSY_TX
+  double m_rxCurrentA;          //!< BUSY_RX
+  double m_listenCurrentA;      //!< RX_ON
+  double m_idleCurrentA;        //!< other on states
+  double m_sleepCurrentA;       //!< TRX_OFF
+  RadioState m_state;           //!< current state
+  Time m_lastUpdate;            //!< when m_state was entered or last accounted
+  Time m_timeInState[RADIO_TX + 1]; //!< accounted time per state
+  TracedValue<double> m_totalEnergyConsumption; //!< J drawn so far, up to m_lastUpdate
+  Callback<void> m_depletionCallback; //!< called on depletion
+  bool m_depleted;              //!< the callback ran
+};
+
+}
+#endif /* CLUSTER_RADIO_ENERGY_MODEL_H */
@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/simulator.h>
+#include <ns3/uinteger.h>
+#include <ns3/lr-wpan-phy.h>
+#include <ns3/lr-wpan-net-device.h>
+#include "ns3/cluster-tree-network.h"
+#include "ns3/cluster-slotted-mac.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterSlottedMac");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterSlottedMac);
+
+TypeId
+ClusterSlottedMac::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterSlottedMac")
+    .SetParent<Object> ()
+    .AddConstructor<ClusterSlottedMac> ()
+    .AddAttribute ("SlotDuration",
+                   "Length of a cell: CCA, one frame and its acknowledgement.",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&ClusterSlottedMac::m_slotDuration),
+                   MakeTimeChecker ())
+    .AddAttribute ("ControlChannel",
+                   "IEEE 802.15.4 channel used outside cells.",
+                   UintegerValue (11),
+                   MakeUintegerAccessor (&ClusterSlottedMac::m_controlChannel),
+                   MakeUintegerChecker<uint8_t> (11, 26))
+    .AddAttribute ("Channels",
+                   "Data channels hopped over, right above ControlChannel; 1 keeps every cell on ControlChannel.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&ClusterSlottedMac::m_channels),
+                   MakeUintegerChecker<uint8_t> (1, 15))
+    .AddAttribute ("QueueSize",
+                   "Frames waiting for a transmit cell at most.",
+                   UintegerValue (32),
+                   MakeUintegerAccessor (&ClusterSlottedMac::m_queueSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddTraceSource ("QueueDrop",
+                     "A frame was dropped because the queue was full.",
+                     MakeTraceSourceAccessor (&ClusterSlottedMac::m_queueDropTrace),
+                     "ns3::ClusterSlottedMac::QueueDropTracedCallback")
+  ;
+  return tid;
+}
+
+ClusterSlottedMac::ClusterSlottedMac ()
+  : m_macBacklog (0),
+    m_cellTx (false),
+    m_savedMinBe (0),
+    m_savedMaxBackoffs (0),
+    m_savedMaxRetries (0),
+    m_index (0),
+    m_controlChannel (11),
+    m_channels (1),
+    m_queueSize (32),
+    m_father (ClusterTreeNetwork::NO_NODE),
+    m_slotframe (0),
+    m_nextCell (0),
+    m_frame (0)
+{
+}
+
+ClusterSlottedMac::~ClusterSlottedMac ()
+{
+}
+
+void
+ClusterSlottedMac::DoDispose (void)
+{
+  m_cellEvent.Cancel ();
+  m_queue.clear ();
+  m_mac = 0;
+  m_phy = 0;
+  m_csmaCa = 0;
+  Object::DoDispose ();
+}
+
+void
+ClusterSlottedMac::Setup (Ptr<LrWpanNetDevice> device, uint32_t index)
+{
+  m_mac = device->GetMac ();
+  m_phy = device->GetPhy ();
+  m_csmaCa = device->GetCsmaCa ();
+  m_index = index;
+  // 数一数MAC里还压着几帧，格子开始时MAC要空着才把数据交下去
+  m_mac->TraceConnectWithoutContext ("MacTxEnqueue", MakeCallback (&ClusterSlottedMac::MacTxEnqueue, this));
+  m_mac->TraceConnectWithoutContext ("MacTxDequeue", MakeCallback (&ClusterSlottedMac::MacTxDequeue, this));
+  NS_ABORT_MSG_IF (m_channels > 1 && m_controlChannel + m_channels > 26,
+                   "data channels run past channel 26");
+}
+
+uint8_t
+ClusterSlottedMac::GetNChannels (void) const
+{
+  return m_channels;
+}
+
+Time
+ClusterSlottedMac::GetSlotDuration (void) const
+{
+  return m_slotDuration;
+}
+
+void
+ClusterSlottedMac::Start (const ClusterConvergecastSchedule &schedule, Time epoch)
+{
+  Stop ();
+  schedule.GetNodeCells (m_index, m_cells);
+  m_slotframe = schedule.GetSlotframeLength ();
+  m_epoch = epoch;
+  m_father = ClusterTreeNetwork::NO_NODE;
+  for (std::vector<ClusterCell>::iterator i = m_cells.begin (); i != m_cells.end (); ++i)
+    {
+      if (i->tx == m_index)
+        {
+          m_father = i->rx;
+        }
+    }
+  if (m_cells.empty ())
+    {
+      return;
+    }
+  // 找到现在之后的第一个格子
+  int64_t elapsed = std::max<int64_t> ((Simulator::Now () - epoch).GetTimeStep (), 0);
+  uint64_t asn = (elapsed + m_slotDuration.GetTimeStep () - 1) / m_slotDuration.GetTimeStep ();
+  m_frame = asn / m_slotframe;
+  m_nextCell = 0;
+  while (m_nextCell < m_cells.size () && m_cells[m_nextCell].slot < asn % m_slotframe)
+    {
+      m_nextCell++;
+    }
+  if (m_nextCell == m_cells.size ())
+    {
+      m_nextCell = 0;
+      m_frame++;
+    }
+  ScheduleNextCell ();
+}
+
+void
+ClusterSlottedMac::Stop (void)
+{
+  m_cellEvent.Cancel ();
+  m_queue.clear ();
+  m_cells.clear ();
+  m_father = ClusterTreeNetwork::NO_NODE;
+  if (m_phy != 0 && m_channels > 1)
+    {
+      SetChannel (m_controlChannel);
+    }
+}
+
+bool
+ClusterSlottedMac::Enqueue (uint32_t dst, McpsDataRequestParams params, Ptr<Packet> p)
+{
+  // 换了父亲的话旧的格子就不对了，让上层直接用CSMA发
+  if (dst != m_father)
+    {
+      return false;
+    }
+  if (m_queue.size () >= m_queueSize)
+    {
+      NS_LOG_LOGIC ("node " << m_index << " slot queue full");
+      m_queueDropTrace (p);
+      return true;
+    }
+  Pending pending;
+  pending.params = params;
+  pending.packet = p;
+  m_queue.push_back (pending);
+  return true;
+}
+
+void
+ClusterSlottedMac::ScheduleNextCell (void)
+{
+  uint64_t asn = m_frame * m_slotframe + m_cells[m_nextCell].slot;
+  Time start = m_epoch + TimeStep (m_slotDuration.GetTimeStep () * asn);
+  m_cellEvent = Simulator::Schedule (start - Simulator::Now (), &ClusterSlottedMac::StartCell, this);
+}
+
+void
+ClusterSlottedMac::StartCell (void)
+{
+  const ClusterCell &cell = m_cells[m_nextCell];
+  if (m_channels > 1)
+    {
+      uint64_t asn = m_frame * m_slotframe + cell.slot;
+      SetChannel (m_controlChannel + 1 + (asn + cell.channelOffset) % m_channels);
+    }
+  if (cell.tx == m_index && !m_queue.empty ())
+    {
+      if (m_macBacklog == 0)
+        {
+          TransmitInCell ();
+        }
+      else
+        {
+          // MAC还在发控制帧，这一格赶不上了，等下一格，不在格子外面发
+          NS_LOG_LOGIC ("node " << m_index << " MAC busy, frame waits for the next cell");
+        }
+    }
+  m_cellEvent = Simulator::Schedule (m_slotDuration, &ClusterSlottedMac::EndCell, this);
+}
+
+void
+ClusterSlottedMac::EndCell (void)
+{
+  if (m_channels > 1)
+    {
+      SetChannel (m_controlChannel);
+    }
+  if (++m_nextCell == m_cells.size ())
+    {
+      m_nextCell = 0;
+      m_frame++;
+    }
+  ScheduleNextCell ();
+}
+
+void
+ClusterSlottedMac::TransmitInCell (void)
+{
+  Pending pending = m_queue.front ();
+  m_queue.pop_front ();
+  // 不退避、不重传，一次CCA就发，格子结束前一定有结果
+  m_savedMinBe = m_csmaCa->GetMacMinBE ();
+  m_savedMaxBackoffs = m_csmaCa->GetMacMaxCSMABackoffs ();
+  m_savedMaxRetries = m_mac->GetMacMaxFrameRetries ();
+  m_csmaCa->SetMacMinBE (0);
+  m_csmaCa->SetMacMaxCSMABackoffs (0);
+  m_mac->SetMacMaxFrameRetries (0);
+  m_cellTx = true;
+  m_mac->McpsDataRequest (pending.params, pending.packet);
+}
+
+void
+ClusterSlottedMac::MacTxEnqueue (Ptr<const Packet> p)
+{
+  m_macBacklog++;
+}
+
+void
+ClusterSlottedMac::MacTxDequeue (Ptr<const Packet> p)
+{
+  m_macBacklog--;
+  if (m_cellTx)
+    {
+      // 交下去时MAC是空的，第一个出来的就是格子里的这一帧
+      m_cellTx = false;
+      m_csmaCa->SetMacMinBE (m_savedMinBe);
+      m_csmaCa->SetMacMaxCSMABackoffs (m_savedMaxBackoffs);
+      m_mac->SetMacMaxFrameRetries (m_savedMaxRetries);
+    }
+}
+
+void
+ClusterSlottedMac::SetChannel (uint8_t channel)
+{
+  LrWpanPhyPibAttributes attribute;
+  attribute.phyCurrentChannel = channel;
+  m_phy->PlmeSetAttributeRequest (phyCurrentChannel, &attribute);
+}
+
+}
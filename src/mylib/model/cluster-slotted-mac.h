@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_SLOTTED_MAC_H
+#define CLUSTER_SLOTTED_MAC_H
+
+#include <ns3/object.h>
+#include <ns3/packet.h>
+#include <ns3/nstime.h>
+#include <ns3/event-id.h>
+#include <ns3/traced-callback.h>
+#include <ns3/lr-wpan-mac.h>
+#include <ns3/lr-wpan-csmaca.h>
+#include "ns3/cluster-convergecast-schedule.h"
+#include <deque>
+#include <vector>
+
+namespace ns3 {
+
+class LrWpanNetDevice;
+
+/**
+ * \ingroup mylib
+ *
+ * Slotted transmission layer over LrWpanMac, in the manner of TSCH.
+ * Frames to the scheduled father wait in a queue and one is handed to
+ * the MAC at the start of each own transmit cell.  During every cell of
+ * the node, as sender or receiver, the radio sits on the cell's channel:
+ * ControlChannel + 1 + (ASN + channel offset) mod Channels, ASN being the
+ * absolute slot number since the schedule epoch.  Outside its cells the
+ * radio stays on ControlChannel, where the CSMA-CA control traffic goes.
+ * With one channel the radio never leaves ControlChannel.
+ *
+ * Slots are aligned on the simulator clock, so nodes are perfectly
+ * synchronised.  A frame only leaves the queue at the start of a
+ * transmit cell in which the MAC has nothing else outstanding, and goes
+ * out with a single CCA, no backoff and no retransmission, so it is over
+ * before the cell ends; SlotDuration must hold the CCA, the frame and its
+ * acknowledgement.  A frame whose cell finds the MAC busy with control
+ * traffic waits for the next cell.  The MAC's CSMA-CA settings are put
+ * back as soon as the frame leaves the MAC.
+ *
+ * Cells hand frames to the MAC and retune the PHY directly, bypassing
+ * the channel queue of ClusterTreeProtocol, so a ClusterChannelPlan
+ * cannot be used on the same devices.
+ */
+class ClusterSlottedMac : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterSlottedMac ();
+  virtual ~ClusterSlottedMac ();
+
+  /**
+   * \param device the device whose MAC, CSMA-CA and PHY are driven
+   * \param index index of the node
+   */
+  void Setup (Ptr<LrWpanNetDevice> device, uint32_t index);
+  /**
+   * \return channel offsets per slot, for ClusterConvergecastSchedule
+   */
+  uint8_t GetNChannels (void) const;
+  /**
+   * \return the slot length
+   */
+  Time GetSlotDuration (void) const;
+
+  /**
+   * Follow the cells of this node, repeated every slotframe from epoch.
+   * \param schedule the schedule of the whole tree
+   * \param epoch start of slotframe 0, ASN 0
+   */
+  void Start (const ClusterConvergecastSchedule &schedule, Time epoch);
+  /**
+   * Leave the schedule: go back to ControlChannel and drop the queue.
+   */
+  void Stop (void);
+
+  /**
+   * Queue a frame for the next transmit cell.
+   * \param dst index of the receiver
+   * \param params MCPS parameters of the frame
+   * \param p the frame
+   * \return false if no cell goes to dst; the caller sends the frame itself
+   */
+  bool Enqueue (uint32_t dst, McpsDataRequestParams params, Ptr<Packet> p);
+
+  /**
+   * TracedCallback signature for a frame dropped on a full queue.
+   * \param packet the frame
+   */
+  typedef void (* QueueDropTracedCallback)(Ptr<const Packet> packet);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// A queued frame.
+  struct Pending
+  {
+    McpsDataRequestParams params;  //!< MCPS parameters
+    Ptr<Packet> packet;            //!< the frame
+  };
+
+  /**
+   * Schedule the next own cell at or after now.
+   */
+  void ScheduleNextCell (void);
+  /**
+   * Start of own cell m_nextCell.
+   */
+  void StartCell (void);
+  /**
+   * End of the current cell.
+   */
+  void EndCell (void);
+  /**
+   * Hand the head of the queue to the MAC with backoff and
+   * retransmissions turned off.
+   */
+  void TransmitInCell (void);
+  /**
+   * \param p a frame the MAC queued
+   */
+  void MacTxEnqueue (Ptr<const Packet> p);
+  /**
+   * \param p a frame the MAC is done with, sent or not
+   */
+  void MacTxDequeue (Ptr<const Packet> p);
+  /**
+   * \param channel IEEE 802.15.4 channel to tune the PHY to
+   */
+  void SetChannel (uint8_t channel);
+
+  Ptr<LrWpanMac> m_mac;               //!< driven MAC
+  Ptr<LrWpanPhy> m_phy;               //!< its PHY
+  Ptr<LrWpanCsmaCa> m_csmaCa;         //!< its CSMA-CA
+  uint32_t m_macBacklog;              //!< frames queued in the MAC
+  bool m_cellTx;                      //!< a cell frame is with the MAC
+  uint8_t m_savedMinBe;               //!< macMinBE while m_cellTx
+  uint8_t m_savedMaxBackoffs;         //!< macMaxCSMABackoffs while m_cellTx
+  uint8_t m_savedMaxRetries;          //!< macMaxFrameRetries while m_cellTx
+  uint32_t m_index;                   //!< index of this node
+  Time m_slotDuration;                //!< slot length
+  uint8_t m_controlChannel;           //!< channel outside cells
+  uint8_t m_channels;                 //!< data channels hopped over
+  uint32_t m_queueSize;               //!< frames queued at most
+  std::vector<ClusterCell> m_cells;   //!< own cells, by slot
+  uint32_t m_father;                  //!< receiver of the transmit cells
+  uint32_t m_slotframe;               //!< slots per slotframe
+  Time m_epoch;                       //!< start of ASN 0
+  uint32_t m_nextCell;                //!< index of the next cell in m_cells
+  uint64_t m_frame;                   //!< slotframe of the next cell
+  EventId m_cellEvent;                //!< start or end of the current cell
+  std::deque<Pending> m_queue;        //!< frames waiting for a cell
+  TracedCallback<Ptr<const Packet> > m_queueDropTrace;  //!< full queue
+};
+
+}
+#endif /* CLUSTER_SLOTTED_MAC_H */
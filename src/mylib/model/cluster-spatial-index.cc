@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/double.h>
+#include <ns3/mobility-model.h>
+#include "ns3/cluster-spatial-index.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterSpatialIndex");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterSpatialIndex);
+
+TypeId
+ClusterSpatialIndex::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterSpatialIndex")
+    .SetParent<Object> ()
+    .AddConstructor<ClusterSpatialIndex> ()
+    .AddAttribute ("CellSize",
+                   "Side of a grid cell in meters, best close to the query radius.",
+                   DoubleValue (50.0),
+                   MakeDoubleAccessor (&ClusterSpatialIndex::SetCellSize,
+                                       &ClusterSpatialIndex::GetCellSize),
+                   MakeDoubleChecker<double> (std::numeric_limits<double>::min ()))
+  ;
+  return tid;
+}
+
+ClusterSpatialIndex::ClusterSpatialIndex ()
+  : m_cellSize (50.0)
+{
+}
+
+ClusterSpatialIndex::~ClusterSpatialIndex ()
+{
+}
+
+void
+ClusterSpatialIndex::DoDispose (void)
+{
+  m_position.clear ();
+  m_cellOf.clear ();
+  m_cells.clear ();
+  Object::DoDispose ();
+}
+
+uint32_t
+ClusterSpatialIndex::AddNode (Ptr<MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << mobility);
+  uint32_t index = m_position.size ();
+  m_position.push_back (mobility->GetPosition ());
+  m_cellOf.push_back (0);
+  Insert (index);
+  std::ostringstream context;
+  context << index;
+  mobility->TraceConnect ("CourseChange", context.str (),
+                          MakeCallback (&ClusterSpatialIndex::CourseChanged, this));
+  return index;
+}
+
+uint32_t
+ClusterSpatialIndex::GetN (void) const
+{
+  return m_position.size ();
+}
+
+void
+ClusterSpatialIndex::SetCellSize (double cellSize)
+{
+  NS_LOG_FUNCTION (this << cellSize);
+  NS_ASSERT (cellSize > 0);
+  m_cellSize = cellSize;
+  m_cells.clear ();
+  for (uint32_t i = 0; i < m_position.size (); ++i)
+    {
+      Insert (i);
+    }
+}
+
+double
+ClusterSpatialIndex::GetCellSize (void) const
+{
+  return m_cellSize;
+}
+
+uint64_t
+ClusterSpatialIndex::GetCellKey (const Vector &position) const
+{
+  int32_t cx = std::floor (position.x / m_cellSize);
+  int32_t cy = std::floor (position.y / m_cellSize);
+  return uint64_t (uint32_t (cx)) << 32 | uint32_t (cy);
+}
+
+void
+ClusterSpatialIndex::Insert (uint32_t index)
+{
+  uint64_t key = GetCellKey (m_position[index]);
+  m_cellOf[index] = key;
+  m_cells[key].push_back (index);
+}
+
+void
+ClusterSpatialIndex::Remove (uint32_t index)
+{
+  std::unordered_map<uint64_t, std::vector<uint32_t> >::iterator cell = m_cells.find (m_cellOf[index]);
+  NS_ASSERT (cell != m_cells.end ());
+  std::vector<uint32_t> &members = cell->second;
+  std::vector<uint32_t>::iterator i = std::find (members.begin (), members.end (), index);
+  NS_ASSERT (i != members.end ());
+  // 顺序无所谓，用最后一个填空位
+  *i = members.back ();
+  members.pop_back ();
+  if (members.empty ())
+    {
+      m_cells.erase (cell);
+    }
+}
+
+void
+ClusterSpatialIndex::CourseChanged (std::string context, Ptr<const MobilityModel> mobility)
+{
+  uint32_t index = std::stoul (context);
+  Vector position = mobility->GetPosition ();
+  m_position[index] = position;
+  if (GetCellKey (position) != m_cellOf[index])
+    {
+      Remove (index);
+      Insert (index);
+    }
+}
+
+void
+ClusterSpatialIndex::GetNeighbors (uint32_t index, double range, std::vector<uint32_t> &neighbors) const
+{
+  NS_ASSERT (index < m_position.size ());
+  Query (m_position[index], range, index, neighbors);
+}
+
+void
+ClusterSpatialIndex::GetNodesWithin (const Vector &center, double range, std::vector<uint32_t> &nodes) const
+{
+  Query (center, range, std::numeric_limits<uint32_t>::max (), nodes);
+}
+
+void
+ClusterSpatialIndex::Query (const Vector &center, double range, uint32_t skip, std::vector<uint32_t> &nodes) const
+{
+  nodes.clear ();
+  int32_t xMin = std::floor ((center.x - range) / m_cellSize);
+  int32_t xMax = std::floor ((center.x + range) / m_cellSize);
+  int32_t yMin = std::floor ((center.y - range) / m_cellSize);
+  int32_t yMax = std::floor ((center.y + range) / m_cellSize);
+  double range2 = range * range;
+  for (int32_t cx = xMin; cx <= xMax; ++cx)
+    {
+      for (int32_t cy = yMin; cy <= yMax; ++cy)
+        {
+          std::unordered_map<uint64_t, std::vector<uint32_t> >::const_iterator cell =
+            m_cells.find (uint64_t (uint32_t (cx)) << 32 | uint32_t (cy));
+          if (cell == m_cells.end ())
+            {
+              continue;
+            }
+          for (std::vector<uint32_t>::const_iterator i = cell->second.begin (); i != cell->second.end (); ++i)
+            {
+              const Vector &p = m_position[*i];
+              double dx = p.x - center.x;
+              double dy = p.y - center.y;
+              double dz = p.z - center.z;
+              if (*i != skip && dx * dx + dy * dy + dz * dz <= range2)
+                {
+                  nodes.push_back (*i);
+                }
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_SPATIAL_INDEX_H
+#define CLUSTER_SPATIAL_INDEX_H
+
+#include <ns3/object.h>
+#include <ns3/vector.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+class MobilityModel;
+
+/**
+ * \ingroup mylib
+ *
+ * Uniform grid over the x/y positions of the nodes of a cluster tree,
+ * keyed by node index.
+ *
+ * Each node sits in the square cell of side CellSize holding its
+ * position; only occupied cells are stored.  A range query visits the
+ * cells overlapping the query square and checks the exact (3D) distance,
+ * so with CellSize close to the radio range it costs O(neighbours)
+ * instead of O(N).  Positions follow the CourseChange trace of each
+ * registered MobilityModel.
+ */
+class ClusterSpatialIndex : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterSpatialIndex ();
+  virtual ~ClusterSpatialIndex ();
+
+  /**
+   * Register the next node and watch its CourseChange trace.
+   * \param mobility the node's mobility model
+   * \return the node index
+   */
+  uint32_t AddNode (Ptr<MobilityModel> mobility);
+  /**
+   * \return the number of registered nodes
+   */
+  uint32_t GetN (void) const;
+  /**
+   * Change the cell side and rebuild the grid.
+   * \param cellSize cell side in meters
+   */
+  void SetCellSize (double cellSize);
+  /**
+   * \return the cell side in meters
+   */
+  double GetCellSize (void) const;
+
+  /**
+   * \param index node index
+   * \param range query radius in meters
+   * \param neighbors receives the indices of the other nodes within range,
+   *        in no particular order; cleared first
+   */
+  void GetNeighbors (uint32_t index, double range, std::vector<uint32_t> &neighbors) const;
+  /**
+   * \param center query center
+   * \param range query radius in meters
+   * \param nodes receives the indices of the nodes within range; cleared first
+   */
+  void GetNodesWithin (const Vector &center, double range, std::vector<uint32_t> &nodes) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * CourseChange trace sink.
+   * \param context the node index
+   * \param mobility the mobility model that moved
+   */
+  void CourseChanged (std::string context, Ptr<const MobilityModel> mobility);
+  /**
+   * \param position a position
+   * \return the key of the cell holding it
+   */
+  uint64_t GetCellKey (const Vector &position) const;
+  /**
+   * Put a node in the cell of its stored position.
+   * \param index node index
+   */
+  void Insert (uint32_t index);
+  /**
+   * Take a node out of its current cell.
+   * \param index node index
+   */
+  void Remove (uint32_t index);
+  /**
+   * Collect the nodes within range of center.
+   * \param center query center
+   * \param range query radius
+   * \param skip index left out of the result
+   * \param nodes the result
+   */
+  void Query (const Vector &center, double range, uint32_t skip, std::vector<uint32_t> &nodes) const;
+
+  double m_cellSize;                           //!< cell side in meters
+  std::vector<Vector> m_position;              //!< last known position per node index
+  std::vector<uint64_t> m_cellOf;              //!< cell key per node index
+  std::unordered_map<uint64_t, std::vector<uint32_t> > m_cells; //!< occupied cells
+};
+
+}
+#endif /* CLUSTER_SPATIAL_INDEX_H */
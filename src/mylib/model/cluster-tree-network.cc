@@ -0,0 +1,360 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/boolean.h>
+#include <ns3/uinteger.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/mobility-model.h>
+#include <ns3/constant-position-mobility-model.h>
+#include "ns3/cluster-tree-network.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterTreeNetwork");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterTreeNetwork);
+
+const uint32_t ClusterTreeNetwork::MAX_SHORT_NODES;
+const uint32_t ClusterTreeNetwork::MAX_EXTENDED_NODES;
+const uint32_t ClusterTreeNetwork::NO_NODE;
+const uint32_t ClusterTreeNetwork::COORDINATOR_INDEX;
+
+TypeId
+ClusterTreeNetwork::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterTreeNetwork")
+    .SetParent<Object> ()
+    .AddConstructor<ClusterTreeNetwork> ()
+    .AddAttribute ("ExtendedAddressing",
+                   "Address nodes by their 64-bit extended address instead of the short address.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&ClusterTreeNetwork::m_extended),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PacketPoolSize",
+                   "Control frame packets recycled by the protocols, 0 to allocate every one.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&ClusterTreeNetwork::SetPacketPoolSize,
+                                         &ClusterTreeNetwork::GetPacketPoolSize),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+ClusterTreeNetwork::ClusterTreeNetwork ()
+  : m_extended (false)
+{
+  m_linkBudget = CreateObject<ClusterLinkBudget> ();
+  m_spatialIndex = CreateObject<ClusterSpatialIndex> ();
+}
+
+ClusterTreeNetwork::~ClusterTreeNetwork ()
+{
+}
+
+void
+ClusterTreeNetwork::DoDispose (void)
+{
+  m_nodes.clear ();
+  m_macs.clear ();
+  m_loss = 0;
+  if (m_linkBudget != 0)
+    {
+      m_linkBudget->Dispose ();
+      m_linkBudget = 0;
+    }
+  if (m_spatialIndex != 0)
+    {
+      m_spatialIndex->Dispose ();
+      m_spatialIndex = 0;
+    }
+  if (m_tracer != 0)
+    {
+      m_tracer->Dispose ();
+      m_tracer = 0;
+    }
+  m_channelPlan = 0;
+  m_packetPool.Clear ();
+  Object::DoDispose ();
+}
+
+uint32_t
+ClusterTreeNetwork::AddNode (Ptr<Node> node, Ptr<LrWpanMac> mac)
+{
+  NS_LOG_FUNCTION (this << node << mac);
+  NS_ABORT_MSG_IF (m_nodes.size () >= GetMaxNodes (),
+                   "this cluster tree holds at most " << GetMaxNodes () << " nodes");
+  m_nodes.push_back (node);
+  m_macs.push_back (mac);
+  Ptr<MobilityModel> mobility = node->GetObject<MobilityModel> ();
+  if (mobility != 0)
+    {
+      uint32_t budgetIndex = m_linkBudget->AddNode (mobility);
+      uint32_t spatialIndex = m_spatialIndex->AddNode (mobility);
+      NS_ASSERT (budgetIndex == m_nodes.size () - 1 && spatialIndex == budgetIndex);
+    }
+  return m_nodes.size () - 1;
+}
+
+Ptr<Node>
+ClusterTreeNetwork::GetNode (uint32_t index) const
+{
+  NS_ASSERT (index < m_nodes.size ());
+  return m_nodes[index];
+}
+
+uint32_t
+ClusterTreeNetwork::GetN (void) const
+{
+  return m_nodes.size ();
+}
+
+Ptr<LrWpanMac>
+ClusterTreeNetwork::GetMac (uint32_t index) const
+{
+  NS_ASSERT (index < m_macs.size ());
+  return m_macs[index];
+}
+
+bool
+ClusterTreeNetwork::IsExtendedAddressing (void) const
+{
+  return m_extended;
+}
+
+uint32_t
+ClusterTreeNetwork::GetMaxNodes (void) const
+{
+  return m_extended ? MAX_EXTENDED_NODES : MAX_SHORT_NODES;
+}
+
+uint32_t
+ClusterTreeNetwork::GetSourceIndex (const McpsDataIndicationParams &params) const
+{
+  if (params.m_srcAddrMode == EXT_ADDR)
+    {
+      return ExtendedAddressToIndex (params.m_srcExtAddr);
+    }
+  return AddressToIndex (params.m_srcAddr);
+}
+
+uint32_t
+ClusterTreeNetwork::GetMacIndex (Ptr<LrWpanMac> mac) const
+{
+  if (m_extended)
+    {
+      return ExtendedAddressToIndex (mac->GetExtendedAddress ());
+    }
+  return AddressToIndex (mac->GetShortAddress ());
+}
+
+void
+ClusterTreeNetwork::SetPropagationLossModel (Ptr<PropagationLossModel> loss)
+{
+  m_loss = loss;
+  m_linkBudget->SetPropagationLossModel (loss);
+  ConnectSpatialIndex ();
+}
+
+Ptr<PropagationLossModel>
+ClusterTreeNetwork::GetPropagationLossModel (void) const
+{
+  return m_loss;
+}
+
+void
+ClusterTreeNetwork::SetLinkBudget (Ptr<ClusterLinkBudget> budget)
+{
+  NS_ABORT_MSG_IF (!m_nodes.empty (), "the link budget must be set before adding nodes");
+  m_linkBudget = budget;
+  m_linkBudget->SetPropagationLossModel (m_loss);
+  ConnectSpatialIndex ();
+}
+
+Ptr<ClusterLinkBudget>
+ClusterTreeNetwork::GetLinkBudget (void) const
+{
+  return m_linkBudget;
+}
+
+double
+ClusterTreeNetwork::GetRxPowerDbm (uint32_t src, uint32_t dst, double txPowerDbm) const
+{
+  return m_linkBudget->GetRxPowerDbm (src, dst, txPowerDbm);
+}
+
+Ptr<ClusterSpatialIndex>
+ClusterTreeNetwork::GetSpatialIndex (void) const
+{
+  return m_spatialIndex;
+}
+
+void
+ClusterTreeNetwork::SetEventTracer (Ptr<ClusterEventTracer> tracer)
+{
+  NS_ABORT_MSG_UNLESS (m_nodes.empty (), "set the event tracer before adding nodes");
+  m_tracer = tracer;
+}
+
+Ptr<ClusterEventTracer>
+ClusterTreeNetwork::GetEventTracer (void) const
+{
+  return m_tracer;
+}
+
+void
+ClusterTreeNetwork::SetChannelPlan (Ptr<ClusterChannelPlan> plan)
+{
+  m_channelPlan = plan;
+}
+
+Ptr<ClusterChannelPlan>
+ClusterTreeNetwork::GetChannelPlan (void) const
+{
+  return m_channelPlan;
+}
+
+ClusterPacketPool &
+ClusterTreeNetwork::GetPacketPool (void)
+{
+  return m_packetPool;
+}
+
+void
+ClusterTreeNetwork::SetPacketPoolSize (uint32_t size)
+{
+  m_packetPool.SetCapacity (size);
+}
+
+uint32_t
+ClusterTreeNetwork::GetPacketPoolSize (void) const
+{
+  return m_packetPool.GetCapacity ();
+}
+
+double
+ClusterTreeNetwork::GetRange (double txPowerDbm, double rxSensitivityDbm) const
+{
+  NS_ASSERT (m_loss != 0);
+  return FindRange (m_loss, txPowerDbm, rxSensitivityDbm);
+}
+
+double
+ClusterTreeNetwork::FindRange (Ptr<PropagationLossModel> loss, double txPowerDbm, double rxSensitivityDbm)
+{
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0, 0, 0));
+  // 先倍增找到收不到的距离，再二分到毫米
+  double lo = 0;
+  double hi = 1;
+  b->SetPosition (Vector (hi, 0, 0));
+  while (loss->CalcRxPower (txPowerDbm, a, b) >= rxSensitivityDbm)
+    {
+      lo = hi;
+      hi *= 2;
+      NS_ABORT_MSG_IF (hi > 1e7, "the loss model never drops below " << rxSensitivityDbm << " dBm");
+      b->SetPosition (Vector (hi, 0, 0));
+    }
+  while (hi - lo > 1e-3)
+    {
+      double mid = (lo + hi) / 2;
+      b->SetPosition (Vector (mid, 0, 0));
+      if (loss->CalcRxPower (txPowerDbm, a, b) >= rxSensitivityDbm)
+        {
+          lo = mid;
+        }
+      else
+        {
+          hi = mid;
+        }
+    }
+  return hi;
+}
+
+void
+ClusterTreeNetwork::GetNeighbors (uint32_t index, double range, std::vector<uint32_t> &neighbors) const
+{
+  m_spatialIndex->GetNeighbors (index, range, neighbors);
+}
+
+void
+ClusterTreeNetwork::ConnectSpatialIndex (void)
+{
+  if (m_loss == 0)
+    {
+      return;
+    }
+  double range = GetRange (0.0, m_linkBudget->GetFloor ());
+  NS_LOG_LOGIC ("link budget floor range " << range << " m");
+  m_spatialIndex->SetCellSize (range);
+  m_linkBudget->SetSpatialIndex (m_spatialIndex, range);
+}
+
+Mac16Address
+ClusterTreeNetwork::IndexToAddress (uint32_t index)
+{
+  NS_ASSERT (index < MAX_SHORT_NODES);
+  uint16_t addr16 = index + 1;
+  uint8_t addr8[2];
+  // Mac16Address keeps the high byte first
+  addr8[0] = addr16 >> 8;
+  addr8[1] = addr16 & 0xff;
+  Mac16Address address;
+  address.CopyFrom (addr8);
+  return address;
+}
+
+uint32_t
+ClusterTreeNetwork::AddressToIndex (Mac16Address address)
+{
+  uint8_t addr8[2];
+  address.CopyTo (addr8);
+  uint16_t addr16 = addr8[1] | addr8[0] << 8;
+  NS_ASSERT (addr16 != 0);
+  return addr16 - 1;
+}
+
+Mac64Address
+ClusterTreeNetwork::IndexToExtendedAddress (uint32_t index)
+{
+  NS_ASSERT (index < MAX_EXTENDED_NODES);
+  uint64_t addr64 = uint64_t (index) + 1;
+  uint8_t addr8[8];
+  for (int i = 7; i >= 0; --i)
+    {
+      addr8[i] = addr64 & 0xff;
+      addr64 >>= 8;
+    }
+  Mac64Address address;
+  address.CopyFrom (addr8);
+  return address;
+}
+
+uint32_t
+ClusterTreeNetwork::ExtendedAddressToIndex (Mac64Address address)
+{
+  uint8_t addr8[8];
+  address.CopyTo (addr8);
+  uint64_t addr64 = 0;
+  for (int i = 0; i < 8; ++i)
+    {
+      addr64 = addr64 << 8 | addr8[i];
+    }
+  NS_ASSERT (addr64 != 0 && addr64 <= MAX_EXTENDED_NODES);
+  return addr64 - 1;
+}
+
+}
@@ -0,0 +1,247 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_TREE_NETWORK_H
+#define CLUSTER_TREE_NETWORK_H
+
+#include <ns3/object.h>
+#include <ns3/node.h>
+#include <ns3/mac16-address.h>
+#include <ns3/mac64-address.h>
+#include <ns3/lr-wpan-mac.h>
+#include "ns3/cluster-link-budget.h"
+#include "ns3/cluster-spatial-index.h"
+#include "ns3/cluster-event-tracer.h"
+#include "ns3/cluster-channel-plan.h"
+#include "ns3/cluster-packet-pool.h"
+#include <vector>
+
+namespace ns3 {
+
+class PropagationLossModel;
+
+/**
+ * \ingroup mylib
+ *
+ * Deployment-wide state shared by every ClusterTreeProtocol of one
+ * cluster tree: the nodes in address order, the propagation loss
+ * model the receive filter evaluates, the ClusterLinkBudget caching
+ * its results per node pair and a ClusterSpatialIndex of the node
+ * positions for neighbour queries.
+ *
+ * Node index i (0-based) owns the short address i+1, index 0 is the
+ * PAN coordinator.  00:00 is kept as the "no address" marker and
+ * ff:fe / ff:ff are reserved by IEEE 802.15.4, so a short-addressed
+ * tree holds at most MAX_SHORT_NODES nodes.
+ *
+ * With the ExtendedAddressing attribute every node instead sends and
+ * receives with its 64-bit address, whose low 32 bits hold index+1, and
+ * the tree grows up to MAX_EXTENDED_NODES.  Either way the protocol
+ * identifies nodes by index and the MAC of every node is resolved once,
+ * in AddNode.
+ */
+class ClusterTreeNetwork : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterTreeNetwork ();
+  virtual ~ClusterTreeNetwork ();
+
+  /// Largest node count that fits in the short address space.
+  static const uint32_t MAX_SHORT_NODES = 0xfffd;
+  /// Largest node count with extended addressing.
+  static const uint32_t MAX_EXTENDED_NODES = 0xfffffffe;
+  /// Node index meaning "no node", e.g. the father of an orphan.
+  static const uint32_t NO_NODE = 0xffffffff;
+  /// Index of the PAN coordinator.
+  static const uint32_t COORDINATOR_INDEX = 0;
+
+  /**
+   * Append a node; its index is the current node count.  The node's
+   * MobilityModel, if any, is registered with the link budget and the
+   * spatial index.
+   * \param node the node
+   * \param mac the MAC of the node's cluster tree device
+   * \return the index assigned to the node
+   */
+  uint32_t AddNode (Ptr<Node> node, Ptr<LrWpanMac> mac);
+  /**
+   * \param index node index
+   * \return the node with that index
+   */
+  Ptr<Node> GetNode (uint32_t index) const;
+  /**
+   * \return the number of nodes in the tree
+   */
+  uint32_t GetN (void) const;
+  /**
+   * \param index node index
+   * \return the MAC of that node
+   */
+  Ptr<LrWpanMac> GetMac (uint32_t index) const;
+
+  /**
+   * \return true if nodes use their extended address
+   */
+  bool IsExtendedAddressing (void) const;
+  /**
+   * \return the largest node count of the addressing mode
+   */
+  uint32_t GetMaxNodes (void) const;
+  /**
+   * \param params an MCPS-DATA.indication from a tree node
+   * \return the index of the sender
+   */
+  uint32_t GetSourceIndex (const McpsDataIndicationParams &params) const;
+  /**
+   * \param mac the MAC of a tree node
+   * \return the index of that node
+   */
+  uint32_t GetMacIndex (Ptr<LrWpanMac> mac) const;
+
+  /**
+   * Set the loss model the channel uses, so the protocol can evaluate
+   * link budgets with the same model.
+   * \param loss the propagation loss model
+   */
+  void SetPropagationLossModel (Ptr<PropagationLossModel> loss);
+  /**
+   * \return the propagation loss model
+   */
+  Ptr<PropagationLossModel> GetPropagationLossModel (void) const;
+
+  /**
+   * Replace the link budget cache.  Must be called before AddNode.
+   * \param budget the cache
+   */
+  void SetLinkBudget (Ptr<ClusterLinkBudget> budget);
+  /**
+   * \return the link budget cache
+   */
+  Ptr<ClusterLinkBudget> GetLinkBudget (void) const;
+  /**
+   * \param src transmitter index
+   * \param dst receiver index
+   * \param txPowerDbm transmit power
+   * \return the power dst receives from src, through the link budget cache
+   */
+  double GetRxPowerDbm (uint32_t src, uint32_t dst, double txPowerDbm) const;
+
+  /**
+   * \return the spatial index over the node positions
+   */
+  Ptr<ClusterSpatialIndex> GetSpatialIndex (void) const;
+  /**
+   * Trace the protocols into tracer.  Protocols pick the tracer up in
+   * Setup, so set it before the first one is installed.
+   * \param tracer the tracer, null disables tracing
+   */
+  void SetEventTracer (Ptr<ClusterEventTracer> tracer);
+  /**
+   * \return the event tracer, null when tracing is disabled
+   */
+  Ptr<ClusterEventTracer> GetEventTracer (void) const;
+  /**
+   * \param plan channels of the clusters, consulted on every send
+   */
+  void SetChannelPlan (Ptr<ClusterChannelPlan> plan);
+  /**
+   * \return the channel plan, null when every node shares one channel
+   */
+  Ptr<ClusterChannelPlan> GetChannelPlan (void) const;
+  /**
+   * \return the pool the protocols take control frame packets from
+   */
+  ClusterPacketPool &GetPacketPool (void);
+  /**
+   * Distance at which the received power falls below rxSensitivityDbm,
+   * found by bisection on the loss model, which must be deterministic
+   * and decreasing with distance.
+   * \param txPowerDbm transmit power
+   * \param rxSensitivityDbm weakest usable received power
+   * \return the radio range in meters
+   */
+  double GetRange (double txPowerDbm, double rxSensitivityDbm) const;
+  /**
+   * GetRange for any loss model.
+   * \param loss a deterministic loss model, decreasing with distance
+   * \param txPowerDbm transmit power
+   * \param rxSensitivityDbm weakest usable received power
+   * \return the distance in meters at which the power falls below rxSensitivityDbm
+   */
+  static double FindRange (Ptr<PropagationLossModel> loss, double txPowerDbm, double rxSensitivityDbm);
+  /**
+   * \param index node index
+   * \param range radius in meters, typically from GetRange
+   * \param neighbors receives the other nodes within range; cleared first
+   */
+  void GetNeighbors (uint32_t index, double range, std::vector<uint32_t> &neighbors) const;
+
+  /**
+   * \param index node index
+   * \return the short address owned by that node
+   */
+  static Mac16Address IndexToAddress (uint32_t index);
+  /**
+   * \param address a short address produced by IndexToAddress
+   * \return the index of the node owning it
+   */
+  static uint32_t AddressToIndex (Mac16Address address);
+  /**
+   * \param index node index
+   * \return the extended address owned by that node
+   */
+  static Mac64Address IndexToExtendedAddress (uint32_t index);
+  /**
+   * \param address an extended address produced by IndexToExtendedAddress
+   * \return the index of the node owning it
+   */
+  static uint32_t ExtendedAddressToIndex (Mac64Address address);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * Size the spatial index cells to the link budget floor range and let
+   * the link budget use the index.
+   */
+  void ConnectSpatialIndex (void);
+  /**
+   * \param size packets the control frame pool may keep
+   */
+  void SetPacketPoolSize (uint32_t size);
+  /**
+   * \return packets the control frame pool may keep
+   */
+  uint32_t GetPacketPoolSize (void) const;
+
+  bool m_extended;                  //!< extended addressing
+  std::vector<Ptr<Node> > m_nodes;  //!< nodes, in index order
+  std::vector<Ptr<LrWpanMac> > m_macs; //!< MAC of every node, in index order
+  Ptr<PropagationLossModel> m_loss; //!< loss model of the shared channel
+  Ptr<ClusterLinkBudget> m_linkBudget; //!< cached link gains
+  Ptr<ClusterSpatialIndex> m_spatialIndex; //!< node positions
+  Ptr<ClusterEventTracer> m_tracer;  //!< binary event trace, may be null
+  Ptr<ClusterChannelPlan> m_channelPlan; //!< channels of the clusters, may be null
+  ClusterPacketPool m_packetPool;    //!< control frame packets
+};
+
+}
+#endif /* CLUSTER_TREE_NETWORK_H */
@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/double.h>
+#include <ns3/spectrum-value.h>
+#include <ns3/lr-wpan-spectrum-value-helper.h>
+#include <ns3/lr-wpan-spectrum-signal-parameters.h>
+#include "ns3/cluster-tree-phy.h"
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterTreePhy");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterTreePhy);
+
+TypeId
+ClusterTreePhy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterTreePhy")
+    .SetParent<LrWpanPhy> ()
+    .AddConstructor<ClusterTreePhy> ()
+    .AddAttribute ("RxSensitivity",
+                   "Frames received below this power (dBm) are only interference.",
+                   DoubleValue (-90.0),
+                   MakeDoubleAccessor (&ClusterTreePhy::SetRxSensitivity,
+                                       &ClusterTreePhy::GetRxSensitivity),
+                   MakeDoubleChecker<double> ())
+    .AddTraceSource ("RxBelowSensitivity",
+                     "A frame was ignored because it was received below RxSensitivity.",
+                     MakeTraceSourceAccessor (&ClusterTreePhy::m_rxBelowSensitivityTrace),
+                     "ns3::ClusterTreePhy::RxBelowSensitivityTracedCallback")
+  ;
+  return tid;
+}
+
+ClusterTreePhy::ClusterTreePhy ()
+  : m_rxSensitivityDbm (-90.0),
+    m_nRxBelowSensitivity (0)
+{
+  // 发射功率谱的积分不一定正好是发射功率，用 0 dBm 的谱做基准
+  LrWpanSpectrumValueHelper psdHelper;
+  m_referenceW = Integral (*psdHelper.CreateTxPowerSpectralDensity (0, 11));
+}
+
+ClusterTreePhy::~ClusterTreePhy ()
+{
+}
+
+void
+ClusterTreePhy::SetRxSensitivity (double rxSensitivityDbm)
+{
+  m_rxSensitivityDbm = rxSensitivityDbm;
+}
+
+double
+ClusterTreePhy::GetRxSensitivity (void) const
+{
+  return m_rxSensitivityDbm;
+}
+
+uint64_t
+ClusterTreePhy::GetNRxBelowSensitivity (void) const
+{
+  return m_nRxBelowSensitivity;
+}
+
+void
+ClusterTreePhy::StartRx (Ptr<SpectrumSignalParameters> params)
+{
+  Ptr<LrWpanSpectrumSignalParameters> lrWpanParams = DynamicCast<LrWpanSpectrumSignalParameters> (params);
+  if (lrWpanParams != 0)
+    {
+      double rxPowerDbm = 10 * std::log10 (Integral (*params->psd) / m_referenceW);
+      if (rxPowerDbm < m_rxSensitivityDbm)
+        {
+          m_nRxBelowSensitivity++;
+          m_rxBelowSensitivityTrace (params, rxPowerDbm);
+          // 去掉 LR-WPAN 的身份，基类只把它当干扰，不同步、不解码、不回ACK
+          Ptr<SpectrumSignalParameters> noise = Create<SpectrumSignalParameters> ();
+          noise->duration = params->duration;
+          noise->psd = params->psd;
+          noise->txPhy = params->txPhy;
+          noise->txAntenna = params->txAntenna;
+          LrWpanPhy::StartRx (noise);
+          return;
+        }
+    }
+  LrWpanPhy::StartRx (params);
+}
+
+}
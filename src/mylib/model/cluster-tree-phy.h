@@ -0,0 +1,79 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_TREE_PHY_H
+#define CLUSTER_TREE_PHY_H
+
+#include <ns3/lr-wpan-phy.h>
+#include <ns3/traced-callback.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup mylib
+ *
+ * LrWpanPhy that does not synchronise on frames received below
+ * RxSensitivity.
+ *
+ * Such a frame is handed to LrWpanPhy as a plain SpectrumSignalParameters,
+ * so it only adds to the interference of other receptions and to energy
+ * detection: it is never decoded, acknowledged or indicated to the MAC,
+ * and does not keep the receiver busy.  The received power is measured
+ * on the signal itself, relative to the spectral density LrWpanPhy sends
+ * at 0 dBm, so a frame sent at P dBm over a link of gain G dB arrives at
+ * P + G dBm.
+ */
+class ClusterTreePhy : public LrWpanPhy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterTreePhy ();
+  virtual ~ClusterTreePhy ();
+
+  virtual void StartRx (Ptr<SpectrumSignalParameters> params);
+
+  /**
+   * \param rxSensitivityDbm weakest frame, in dBm, still received
+   */
+  void SetRxSensitivity (double rxSensitivityDbm);
+  /**
+   * \return the weakest frame, in dBm, still received
+   */
+  double GetRxSensitivity (void) const;
+  /**
+   * \return frames ignored because they were below RxSensitivity
+   */
+  uint64_t GetNRxBelowSensitivity (void) const;
+
+  /**
+   * TracedCallback signature for a frame below RxSensitivity.
+   * \param params the signal
+   * \param rxPowerDbm its received power
+   */
+  typedef void (* RxBelowSensitivityTracedCallback)(Ptr<const SpectrumSignalParameters> params, double rxPowerDbm);
+
+private:
+  double m_rxSensitivityDbm;      //!< weakest received frame
+  double m_referenceW;            //!< integral of the 0 dBm transmit spectral density
+  uint64_t m_nRxBelowSensitivity; //!< frames ignored
+  TracedCallback<Ptr<const SpectrumSignalParameters>, double> m_rxBelowSensitivityTrace; //!< frame ignored
+};
+
+}
+#endif /* CLUSTER_TREE_PHY_H */
@@ -0,0 +1,1708 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/double.h>
+#include <ns3/uinteger.h>
+#include <ns3/enum.h>
+#include <ns3/simulator.h>
+#include <ns3/node.h>
+#include <ns3/lr-wpan-net-device.h>
+#include <ns3/lr-wpan-phy.h>
+#include <ns3/lr-wpan-lqi-tag.h>
+#include <ns3/spectrum-signal-parameters.h>
+#include "ns3/cluster-header.h"
+#include "ns3/cluster-tree-network.h"
+#include "ns3/cluster-tree-protocol.h"
+#include "ns3/cluster-tree-phy.h"
+#include <algorithm>
+
+#define BROADCAST_16_ADDR_STR   "ff:ff"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterTreeProtocol");
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterTreeProtocol);
+
+TypeId
+ClusterTreeProtocol::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClusterTreeProtocol")
+    .SetParent<Object> ()
+    .AddConstructor<ClusterTreeProtocol> ()
+    .AddAttribute ("TxPower",
+                   "Transmit power (dBm) assumed when evaluating the link budget of a received frame.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&ClusterTreeProtocol::m_txPowerDbm),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("RxSensitivity",
+                   "Frames whose link budget is below this power (dBm) are treated as not received.",
+                   DoubleValue (-90.0),
+                   MakeDoubleAccessor (&ClusterTreeProtocol::m_rxSensitivityDbm),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("DummyPayloadSize",
+                   "Payload size (bytes) of control frames that carry no data.",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&ClusterTreeProtocol::m_dummyPayloadSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ChildWaitTimeout",
+                   "How long a child waits for the coordinator's permission before its request is forgotten.",
+                   TimeValue (Seconds (2)),
+                   MakeTimeAccessor (&ClusterTreeProtocol::m_childWaitTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("ChildTimeout",
+                   "A father forgets a child it has not heard any frame from, beacons included, for "
+                   "between one and two of this, and reports the departure to the coordinator.  Set it "
+                   "above the reading interval; zero keeps children until they rejoin elsewhere.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&ClusterTreeProtocol::m_childTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("DuplicateCacheSize",
+                   "Slots of the direct-mapped cache of relayed join requests and permissions, "
+                   "used to forward each of them once; 0 handles every copy.",
+                   UintegerValue (32),
+                   MakeUintegerAccessor (&ClusterTreeProtocol::m_duplicateCacheSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DuplicateLifetime",
+                   "How long a relayed message is remembered as handled; keep it below the time a node "
+                   "takes to send 256 frames.",
+                   TimeValue (Seconds (2)),
+                   MakeTimeAccessor (&ClusterTreeProtocol::m_duplicateLifetime),
+                   MakeTimeChecker ())
+    .AddAttribute ("DescendantFilterBits",
+                   "Bits of the Bloom filter kept for the descendants of each child, "
+                   "used to route the coordinator's permission down one branch; 0 floods it to every child.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&ClusterTreeProtocol::m_descendantFilterBits),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Admission",
+                   "Who admits a new child: the coordinator, or the father within its delegated address block.",
+                   EnumValue (ClusterTreeProtocol::ADMISSION_COORDINATOR),
+                   MakeEnumAccessor (&ClusterTreeProtocol::m_admission),
+                   MakeEnumChecker (ClusterTreeProtocol::ADMISSION_COORDINATOR, "Coordinator",
+                                    ClusterTreeProtocol::ADMISSION_DELEGATED, "Delegated"))
+    .AddAttribute ("MaxChildren",
+                   "Children a node may admit with delegated admission (Cm).",
+                   UintegerValue (6),
+                   MakeUintegerAccessor (&ClusterTreeProtocol::m_maxChildren),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxDepth",
+                   "Deepest cluster id with delegated admission (Lm).",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&ClusterTreeProtocol::m_maxDepth),
+                   MakeUintegerChecker<uint16_t> (1))
+    .AddAttribute ("JoinBackoff",
+                   "Backoff window, per neighbour of the node, before answering a beacon or sending one after joining.",
+                   TimeValue (MilliSeconds (3)),
+                   MakeTimeAccessor (&ClusterTreeProtocol::m_joinBackoff),
+                   MakeTimeChecker ())
+    .AddAttribute ("JoinSlot",
+                   "Slot length of the join backoff; zero draws it from a continuous window.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&ClusterTreeProtocol::m_joinSlot),
+                   MakeTimeChecker ())
+    .AddAttribute ("ParentSelectionWindow",
+                   "How long an orphan collects beacons after the first one before asking the best "
+                   "scored sender; zero asks the first sender heard.",
+                   TimeValue (MilliSeconds (50)),
+                   MakeTimeAccessor (&ClusterTreeProtocol::m_selectionWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("BeaconImin",
+                   "Smallest interval of the Trickle timer that repeats HEADER_BEACON while joined; "
+                   "zero only sends the beacon after joining.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&ClusterTreeProtocol::m_beaconImin),
+                   MakeTimeChecker ())
+    .AddAttribute ("BeaconDoublings",
+                   "Times the beacon interval doubles while the neighbourhood is stable, Imax = Imin * 2^doublings.",
+                   UintegerValue (6),
+                   MakeUintegerAccessor (&ClusterTreeProtocol::m_beaconDoublings),
+                   MakeUintegerChecker<uint32_t> (0, 30))
+    .AddAttribute ("BeaconRedundancy",
+                   "Beacons heard in an interval after which the own one is suppressed (Trickle k); "
+                   "0 never suppresses.",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&ClusterTreeProtocol::m_beaconRedundancy),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ParentLossThreshold",
+                   "Consecutive failed confirms of frames to the father after which it is considered lost "
+                   "and the node reattaches locally; 0 never gives up on the father.",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&ClusterTreeProtocol::m_parentLossThreshold),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RepairAttempts",
+                   "HEADER_REPAIR_REQUEST broadcasts, ChildWaitTimeout apart, before a node that lost "
+                   "its father waits for ordinary beacons.",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&ClusterTreeProtocol::m_repairAttempts),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AggregationWindow",
+                   "How long a node holds readings to pack them into one frame towards the coordinator. "
+                   "Zero sends every reading in its own frame.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&ClusterTreeProtocol::m_aggregationWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("RotationThreshold",
+                   "Residual energy fraction below which a cluster head releases its children and "
+                   "stops adopting; 0 never retires.  Needs an energy source.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&ClusterTreeProtocol::m_rotationThreshold),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddTraceSource ("DataRx",
+                     "Data reached the coordinator.",
+                     MakeTraceSourceAccessor (&ClusterTreeProtocol::m_dataRxTrace),
+                     "ns3::ClusterTreeProtocol::DataRxTracedCallback")
+    .AddTraceSource ("Join",
+                     "This node was adopted by a father.",
+                     MakeTraceSourceAccessor (&ClusterTreeProtocol::m_joinTrace),
+                     "ns3::ClusterTreeProtocol::JoinTracedCallback")
+    .AddTraceSource ("Tx",
+                     "A protocol frame was handed to the MAC.",
+                     MakeTraceSourceAccessor (&ClusterTreeProtocol::m_txTrace),
+                     "ns3::ClusterTreeProtocol::TxTracedCallback")
+    .AddTraceSource ("TxFailed",
+                     "The MAC confirmed a frame with a status other than success.",
+                     MakeTraceSourceAccessor (&ClusterTreeProtocol::m_txFailedTrace),
+                     "ns3::ClusterTreeProtocol::TxFailedTracedCallback")
+    .AddTraceSource ("ParentLost",
+                     "The father stopped acknowledging and local repair started.",
+                     MakeTraceSourceAccessor (&ClusterTreeProtocol::m_parentLostTrace),
+                     "ns3::ClusterTreeProtocol::ParentLostTracedCallback")
+    .AddTraceSource ("EnergyDepleted",
+                     "The battery of this node ran out and the node switched off.",
+                     MakeTraceSourceAccessor (&ClusterTreeProtocol::m_energyDepletedTrace),
+                     "ns3::ClusterTreeProtocol::EnergyDepletedTracedCallback")
+  ;
+  return tid;
+}
+
+ClusterTreeProtocol::ClusterTreeProtocol ()
+  : m_index (0),
+    m_extended (false),
+    m_broadcast (BROADCAST_16_ADDR_STR),
+    m_clusterId (0),
+    m_joined (false),
+    m_father (ClusterTreeNetwork::NO_NODE),
+    m_lostFather (ClusterTreeNetwork::NO_NODE),
+    m_descendantFilterBits (4096),
+    m_duplicateCacheSize (32),
+    m_admission (ADMISSION_COORDINATOR),
+    m_nRejected (0),
+    m_rotationThreshold (0.0),
+    m_retired (false),
+    m_depleted (false),
+    m_maxChildren (6),
+    m_maxDepth (8),
+    m_treeAddress (0),
+    m_nextChild (0),
+    m_beaconDoublings (6),
+    m_beaconRedundancy (2),
+    m_nNeighbors (-1),
+    m_parentLossThreshold (3),
+    m_fatherFailures (0),
+    m_repairDepth (0),
+    m_repairAttempts (3),
+    m_repairsLeft (0),
+    m_nextHandle (0),
+    m_sequence (0),
+    m_handleDst (256, ClusterTreeNetwork::NO_NODE),
+    m_channelTxPending (false),
+    m_currentChannel (11),
+    m_aggregateRecords (0),
+    m_range (-1.0)
+{
+  NS_LOG_FUNCTION (this);
+  m_jitter = CreateObject<UniformRandomVariable> ();
+}
+
+ClusterTreeProtocol::~ClusterTreeProtocol ()
+{
+}
+
+void
+ClusterTreeProtocol::DoDispose (void)
+{
+  m_device = 0;
+  m_mac = 0;
+  m_network = 0;
+  m_tracer = 0;
+  m_childTable.Clear ();
+  m_descendants.Clear ();
+  m_aggregateEvent.Cancel ();
+  m_aggregate = 0;
+  m_joinEvent.Cancel ();
+  m_beaconEvent.Cancel ();
+  m_beaconTimer.Stop ();
+  m_selectEvent.Cancel ();
+  m_childCheckEvent.Cancel ();
+  m_candidates.clear ();
+  m_selector = 0;
+  m_slotted = 0;
+  m_policy = 0;
+  m_energySource = 0;
+  m_channelQueue.clear ();
+  m_channelTxPending = false;
+  m_jitter = 0;
+  Object::DoDispose ();
+}
+
+void
+ClusterTreeProtocol::Setup (Ptr<LrWpanNetDevice> device, Ptr<ClusterTreeNetwork> network, uint32_t index)
+{
+  NS_LOG_FUNCTION (this << device << index);
+  m_device = device;
+  m_mac = device->GetMac ();
+  m_network = network;
+  m_index = index;
+  m_extended = network->IsExtendedAddressing ();
+  m_tracer = network->GetEventTracer ();
+  m_descendants.SetSize (m_descendantFilterBits);
+  m_duplicates.SetSize (m_duplicateCacheSize);
+  m_duplicates.SetLifetime (m_duplicateLifetime);
+
+  m_mac->SetMcpsDataIndicationCallback (MakeCallback (&ClusterTreeProtocol::DataIndication, this));
+  m_mac->SetMcpsDataConfirmCallback (MakeCallback (&ClusterTreeProtocol::DataConfirm, this));
+  if (m_tracer != 0 && DynamicCast<ClusterTreePhy> (device->GetPhy ()) != 0)
+    {
+      device->GetPhy ()->TraceConnectWithoutContext ("RxBelowSensitivity",
+                                                     MakeCallback (&ClusterTreeProtocol::RxBelowSensitivity, this));
+    }
+  m_beaconTimer.SetParameters (m_beaconImin, m_beaconDoublings, m_beaconRedundancy);
+  m_beaconTimer.SetFunction (MakeCallback (&ClusterTreeProtocol::SendTrickleBeacon, this));
+  m_beaconTimer.SetRandomVariable (m_jitter);
+  if (m_selector == 0)
+    {
+      m_selector = CreateObject<ClusterWeightedParentSelector> ();
+    }
+
+  if (IsCoordinator ())
+    {
+      m_clusterId = 0;  // PAN Cluster ID = 0
+      m_joined = true;
+      m_treeAddress = 0;
+    }
+  if (m_admission == ADMISSION_DELEGATED)
+    {
+      NS_ABORT_MSG_IF (GetCskip (0) == 0, "MaxChildren^MaxDepth address blocks overflow 32 bits");
+    }
+}
+
+void
+ClusterTreeProtocol::SetParentSelector (Ptr<ClusterParentSelector> selector)
+{
+  m_selector = selector;
+}
+
+void
+ClusterTreeProtocol::SetSlottedMac (Ptr<ClusterSlottedMac> slotted)
+{
+  m_slotted = slotted;
+}
+
+void
+ClusterTreeProtocol::SetAdmissionPolicy (Ptr<ClusterAdmissionPolicy> policy)
+{
+  m_policy = policy;
+}
+
+void
+ClusterTreeProtocol::SetEnergySource (Ptr<EnergySource> source)
+{
+  m_energySource = source;
+}
+
+void
+ClusterTreeProtocol::EnergyDepleted (void)
+{
+  if (m_depleted)
+    {
+      return;
+    }
+  NS_LOG_INFO ("node " << m_index << " ran out of energy");
+  Reset ();
+  m_joined = false;
+  m_depleted = true;
+  m_energyDepletedTrace (m_index);
+  // 电池没了，收发机关掉，MAC空闲时也别再打开
+  m_mac->SetRxOnWhenIdle (false);
+  m_device->GetPhy ()->PlmeSetTRXStateRequest (IEEE_802_15_4_PHY_TRX_OFF);
+}
+
+double
+ClusterTreeProtocol::GetEnergyFraction (void) const
+{
+  if (m_energySource == 0)
+    {
+      return 1.0;
+    }
+  return m_energySource->GetEnergyFraction ();
+}
+
+bool
+ClusterTreeProtocol::IsRetired (void) const
+{
+  return m_retired;
+}
+
+bool
+ClusterTreeProtocol::IsDepleted (void) const
+{
+  return m_depleted;
+}
+
+void
+ClusterTreeProtocol::CheckEnergy (void)
+{
+  if (m_retired || m_rotationThreshold <= 0 || IsCoordinator () || GetEnergyFraction () >= m_rotationThreshold)
+    {
+      return;
+    }
+  // 电量不够了就不当簇头：通知儿子们另找父亲，自己以后只当叶子
+  NS_LOG_INFO ("node " << m_index << " retires with " << m_childTable.GetNChildren () << " children");
+  m_retired = true;
+  m_beaconEvent.Cancel ();
+  m_beaconTimer.Stop ();
+  if (m_childTable.GetNChildren () != 0)
+    {
+      ClusterHeader header (m_extended);
+      header.SetType (HEADER_RELEASE_CHILD);
+      header.SetSequence (m_sequence++);
+      FloodToChildren (header, m_network->GetPacketPool ().Allocate (m_dummyPayloadSize));
+    }
+  // 和RemoveChild一样，Coor批准的儿子要让Coor也减掉
+  if (m_admission == ADMISSION_COORDINATOR)
+    {
+      const std::vector<uint32_t> &children = m_childTable.GetChildren ();
+      for (uint32_t i = 0; i < children.size (); ++i)
+        {
+          ReportDeparture (m_index, children[i]);
+        }
+    }
+  m_childTable.Clear ();
+  m_descendants.Clear ();
+  m_nextChild = 0;
+}
+
+void
+ClusterTreeProtocol::ApplyChannelPlan (void)
+{
+  Ptr<ClusterChannelPlan> plan = m_network->GetChannelPlan ();
+  if (plan != 0 && plan->IsActive () && !m_channelTxPending)
+    {
+      TuneTo (plan->GetListenChannel (m_index));
+    }
+}
+
+void
+ClusterTreeProtocol::TuneTo (uint8_t channel)
+{
+  if (channel == m_currentChannel)
+    {
+      return;
+    }
+  LrWpanPhyPibAttributes attribute;
+  attribute.phyCurrentChannel = channel;
+  m_device->GetPhy ()->PlmeSetAttributeRequest (phyCurrentChannel, &attribute);
+  m_currentChannel = channel;
+}
+
+uint32_t
+ClusterTreeProtocol::GetCskip (uint16_t depth) const
+{
+  // 每个儿子占一块地址：自己加上它下面最多MaxDepth-depth-1层，即 1 + Cm + ... + Cm^(Lm-d-1)
+  if (depth >= m_maxDepth)
+    {
+      return 0;
+    }
+  uint64_t block = 0;
+  uint64_t level = 1;
+  for (uint16_t k = 0; k + depth < m_maxDepth; ++k)
+    {
+      block += level;
+      level *= m_maxChildren;
+      if (block * m_maxChildren + 1 > 0xffffffffULL)
+        {
+          return 0;
+        }
+    }
+  return block;
+}
+
+bool
+ClusterTreeProtocol::CanAdmit (void) const
+{
+  return m_joined && m_clusterId < m_maxDepth && m_nextChild < m_maxChildren;
+}
+
+uint32_t
+ClusterTreeProtocol::GetTreeAddress (void) const
+{
+  return m_treeAddress;
+}
+
+void
+ClusterTreeProtocol::GetNeighbors (std::vector<uint32_t> &neighbors)
+{
+  if (m_range < 0)
+    {
+      m_range = m_network->GetRange (m_txPowerDbm, m_rxSensitivityDbm);
+    }
+  m_network->GetNeighbors (m_index, m_range, neighbors);
+}
+
+bool
+ClusterTreeProtocol::IsCoordinator (void) const
+{
+  return m_index == ClusterTreeNetwork::COORDINATOR_INDEX;
+}
+
+bool
+ClusterTreeProtocol::IsJoined (void) const
+{
+  return m_joined;
+}
+
+uint16_t
+ClusterTreeProtocol::GetClusterId (void) const
+{
+  return m_clusterId;
+}
+
+uint32_t
+ClusterTreeProtocol::GetFather (void) const
+{
+  return m_father;
+}
+
+uint32_t
+ClusterTreeProtocol::GetNChildren (void) const
+{
+  return m_childTable.GetNChildren ();
+}
+
+Address
+ClusterTreeProtocol::GetAddress (void) const
+{
+  if (m_extended)
+    {
+      return m_mac->GetExtendedAddress ();
+    }
+  return m_mac->GetShortAddress ();
+}
+
+double
+ClusterTreeProtocol::GetTxPower (void) const
+{
+  return m_txPowerDbm;
+}
+
+double
+ClusterTreeProtocol::GetRxSensitivity (void) const
+{
+  return m_rxSensitivityDbm;
+}
+
+uint64_t
+ClusterTreeProtocol::GetNDuplicates (void) const
+{
+  return m_duplicates.GetNDuplicates ();
+}
+
+uint64_t
+ClusterTreeProtocol::GetNRejected (void) const
+{
+  return m_nRejected;
+}
+
+uint32_t
+ClusterTreeProtocol::GetIndex (void) const
+{
+  return m_index;
+}
+
+Ptr<LrWpanNetDevice>
+ClusterTreeProtocol::GetDevice (void) const
+{
+  return m_device;
+}
+
+void
+ClusterTreeProtocol::StartFormation (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (IsCoordinator (), "only the coordinator starts formation");
+  SendBroadcast (HEADER_BEACON, CreateBeaconPayload ());
+  if (m_beaconImin.IsStrictlyPositive ())
+    {
+      m_beaconTimer.Start ();
+    }
+  if (m_childTimeout.IsStrictlyPositive ())
+    {
+      m_childCheckEvent = Simulator::Schedule (m_childTimeout, &ClusterTreeProtocol::CheckChildren, this);
+    }
+}
+
+void
+ClusterTreeProtocol::Reset (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_childTable.Clear ();
+  m_descendants.Clear ();
+  m_duplicates.Clear ();
+  m_joinEvent.Cancel ();
+  m_beaconEvent.Cancel ();
+  m_beaconTimer.Stop ();
+  m_selectEvent.Cancel ();
+  m_childCheckEvent.Cancel ();
+  if (m_slotted != 0)
+    {
+      // 旧树的格子作废，重新装表前数据走CSMA
+      NS_LOG_INFO ("node " << m_index << " leaves its slotted schedule");
+      m_slotted->Stop ();
+      m_slotted = 0;
+    }
+  // 排队的帧和在途标志一起清，否则新树的帧可能一直等一个不会再来的确认
+  m_channelQueue.clear ();
+  m_channelTxPending = false;
+  m_aggregateEvent.Cancel ();
+  m_aggregate = 0;
+  m_candidates.clear ();
+  if (m_policy != 0)
+    {
+      m_policy->Reset ();
+    }
+  m_nextChild = 0;
+  m_fatherFailures = 0;
+  m_repairsLeft = 0;
+  m_retired = false;
+  m_father = ClusterTreeNetwork::NO_NODE;
+  m_lostFather = ClusterTreeNetwork::NO_NODE;
+  m_joined = IsCoordinator () && !m_depleted;
+  m_clusterId = 0;
+  m_treeAddress = 0;
+}
+
+void
+ClusterTreeProtocol::SendData (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  if (IsCoordinator () || !m_joined)
+    {
+      NS_LOG_LOGIC ("node " << m_index << " has no father yet, dropping data");
+      return;
+    }
+  if (!m_aggregationWindow.IsZero ())
+    {
+      Aggregate (m_index, p);
+      return;
+    }
+  ClusterDataHeader dataHeader (m_extended);
+  dataHeader.SetOriginator (m_index);
+  p->AddHeader (dataHeader);
+  SendP2p (m_father, HEADER_SEND_DATA_TO_COORDINATOR, p);
+}
+
+void
+ClusterTreeProtocol::SendP2p (uint32_t dst, uint16_t type, Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << dst << type);
+  if (p == 0)
+    {
+      // 没要求就发个5字节的空数据包意思一下。
+      p = m_network->GetPacketPool ().Allocate (m_dummyPayloadSize);
+    }
+
+  ClusterHeader header (m_extended);
+  header.SetType (type);
+  header.SetSequence (m_sequence++);
+  SendFrame (dst, header, p);
+}
+
+void
+ClusterTreeProtocol::SendFrame (uint32_t dst, ClusterHeader header, Ptr<Packet> p)
+{
+  uint16_t type = header.GetType ();
+  header.SetClusterId (m_clusterId);
+  p->AddHeader (header);
+
+  McpsDataRequestParams params;
+  params.m_dstPanId = 0;
+  if (m_extended)
+    {
+      params.m_srcAddrMode = EXT_ADDR;
+      params.m_dstAddrMode = EXT_ADDR;
+      params.m_dstExtAddr = ClusterTreeNetwork::IndexToExtendedAddress (dst);
+    }
+  else
+    {
+      params.m_srcAddrMode = SHORT_ADDR;
+      params.m_dstAddrMode = SHORT_ADDR;
+      params.m_dstAddr = ClusterTreeNetwork::IndexToAddress (dst);
+    }
+  // 记下每个handle发给了谁，确认回来时才知道是不是父亲没应答
+  params.m_msduHandle = m_nextHandle;
+  m_handleDst[m_nextHandle++] = dst;
+  params.m_txOptions = TX_OPTION_ACK;
+  m_txTrace (type, dst);
+  CLUSTER_EVENT_TRACE (m_tracer, CLUSTER_TRACE_TX, m_index, dst, type);
+  // 有时隙表的话数据等自己的格子再发，控制帧照旧
+  if (m_slotted != 0
+      && (type == HEADER_SEND_DATA_TO_COORDINATOR || type == HEADER_SEND_AGGREGATE_TO_COORDINATOR)
+      && m_slotted->Enqueue (dst, params, p))
+    {
+      return;
+    }
+  HandToMac (dst, params, p);
+}
+
+void
+ClusterTreeProtocol::HandToMac (uint32_t dst, McpsDataRequestParams params, Ptr<Packet> p)
+{
+  Ptr<ClusterChannelPlan> plan = m_network->GetChannelPlan ();
+  if (plan == 0 || !plan->IsActive ())
+    {
+      m_mac->McpsDataRequest (params, p);
+      return;
+    }
+  // 发给谁就切到谁监听的信道：上行用父亲簇的信道
+  if (dst != ClusterTreeNetwork::NO_NODE)
+    {
+      TransmitOn (plan->GetListenChannel (dst), params, p);
+      return;
+    }
+  // 广播：邻居各自守在自己簇的信道上，用到的每个信道发一份
+  std::vector<uint32_t> neighbors;
+  GetNeighbors (neighbors);
+  std::vector<uint8_t> channels (1, plan->GetListenChannel (m_index));
+  for (std::vector<uint32_t>::const_iterator i = neighbors.begin (); i != neighbors.end (); ++i)
+    {
+      uint8_t channel = plan->GetListenChannel (*i);
+      if (std::find (channels.begin (), channels.end (), channel) == channels.end ())
+        {
+          channels.push_back (channel);
+        }
+    }
+  for (uint32_t i = 0; i + 1 < channels.size (); ++i)
+    {
+      TransmitOn (channels[i], params, p->Copy ());
+    }
+  TransmitOn (channels.back (), params, p);
+}
+
+void
+ClusterTreeProtocol::TransmitOn (uint8_t channel, McpsDataRequestParams params, Ptr<Packet> p)
+{
+  // 一次只交给MAC一帧，信道要等确认回来才能换
+  if (m_channelTxPending)
+    {
+      ChannelTx tx;
+      tx.channel = channel;
+      tx.params = params;
+      tx.packet = p;
+      m_channelQueue.push_back (tx);
+      return;
+    }
+  m_channelTxPending = true;
+  TuneTo (channel);
+  m_mac->McpsDataRequest (params, p);
+}
+
+void
+ClusterTreeProtocol::SendBroadcast (uint16_t type, Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << type);
+  if (p == 0)
+    {
+      p = m_network->GetPacketPool ().Allocate (m_dummyPayloadSize);
+    }
+
+  ClusterHeader header (m_extended);
+  header.SetType (type);
+  header.SetSequence (m_sequence++);
+  header.SetClusterId (m_clusterId);
+  p->AddHeader (header);
+
+  McpsDataRequestParams params;
+  params.m_dstPanId = 0;
+  params.m_srcAddrMode = m_extended ? EXT_ADDR : SHORT_ADDR;
+  params.m_dstAddrMode = SHORT_ADDR;
+  params.m_dstAddr = m_broadcast;
+  params.m_msduHandle = m_nextHandle;
+  m_handleDst[m_nextHandle++] = ClusterTreeNetwork::NO_NODE;
+  // 广播不需要应答ACK
+  params.m_txOptions = TX_OPTION_NONE;
+  m_txTrace (type, ClusterTreeNetwork::NO_NODE);
+  CLUSTER_EVENT_TRACE (m_tracer, CLUSTER_TRACE_TX, m_index, ClusterTreeNetwork::NO_NODE, type);
+  HandToMac (ClusterTreeNetwork::NO_NODE, params, p);
+}
+
+void
+ClusterTreeProtocol::DataConfirm (McpsDataConfirmParams params)
+{
+  NS_LOG_FUNCTION (this << params.m_status);
+  NS_LOG_LOGIC ("node " << m_index << " LrWpanMcpsDataConfirmStatus = " << params.m_status);
+  uint32_t dst = m_handleDst[params.m_msduHandle];
+  if (m_channelTxPending)
+    {
+      m_channelTxPending = false;
+      if (!m_channelQueue.empty ())
+        {
+          ChannelTx tx = m_channelQueue.front ();
+          m_channelQueue.pop_front ();
+          TransmitOn (tx.channel, tx.params, tx.packet);
+        }
+      else
+        {
+          TuneTo (m_network->GetChannelPlan ()->GetListenChannel (m_index));
+        }
+    }
+  if (params.m_status != IEEE_802_15_4_SUCCESS)
+    {
+      m_txFailedTrace (params.m_status);
+      CLUSTER_EVENT_TRACE (m_tracer, CLUSTER_TRACE_TX_FAILED, m_index, dst, params.m_status);
+    }
+  if (!m_joined || IsCoordinator () || dst != m_father)
+    {
+      return;
+    }
+  // 每发一帧看一次电量，转发多的簇头耗得最快
+  CheckEnergy ();
+  // 连续几次父亲都不应答，就当他没了，自己带着子树就近找新父亲
+  if (params.m_status == IEEE_802_15_4_SUCCESS)
+    {
+      m_fatherFailures = 0;
+    }
+  else if (m_parentLossThreshold != 0 && ++m_fatherFailures >= m_parentLossThreshold)
+    {
+      LoseFather ();
+    }
+}
+
+void
+ClusterTreeProtocol::LoseFather (void)
+{
+  NS_LOG_INFO ("node " << m_index << " lost father " << m_father);
+  m_parentLostTrace (m_father);
+  m_joined = false;
+  m_lostFather = m_father;
+  m_father = ClusterTreeNetwork::NO_NODE;
+  m_fatherFailures = 0;
+  m_repairDepth = m_clusterId;
+  m_candidates.clear ();
+  m_beaconEvent.Cancel ();
+  m_beaconTimer.Stop ();
+  m_selectEvent.Cancel ();
+  m_repairsLeft = m_repairAttempts;
+  SendRepairRequest ();
+}
+
+void
+ClusterTreeProtocol::SendRepairRequest (void)
+{
+  if (m_repairsLeft == 0)
+    {
+      return;
+    }
+  m_repairsLeft--;
+  // 深度就是公共头里的簇ID，丢了父亲后不变，不用再带负载
+  SendBroadcast (HEADER_REPAIR_REQUEST, m_network->GetPacketPool ().Allocate (0));
+  m_joinEvent = Simulator::Schedule (m_childWaitTimeout, &ClusterTreeProtocol::JoinTimeout, this);
+}
+
+void
+ClusterTreeProtocol::ReceiveRepairRequest (uint32_t src, uint16_t clusterId)
+{
+  if (m_joined)
+    {
+      // 邻居里有节点掉了，信标间隔回到最短
+      m_beaconTimer.Reset ();
+    }
+  // 只有比他浅的节点才能当他的新父亲，这样不会接到他自己的子树上成环
+  if (!m_joined || m_retired || m_clusterId >= clusterId
+      || (m_admission == ADMISSION_DELEGATED && !CanAdmit ()))
+    {
+      return;
+    }
+  Simulator::Schedule (GetJoinBackoff (), &ClusterTreeProtocol::SendP2p, this, src, uint16_t (HEADER_BEACON),
+                       CreateBeaconPayload ());
+}
+
+bool
+ClusterTreeProtocol::CanAdoptFrom (uint16_t fatherClusterId) const
+{
+  return m_childTable.GetNChildren () == 0 || fatherClusterId < m_repairDepth;
+}
+
+Ptr<Packet>
+ClusterTreeProtocol::CreateBeaconPayload (void) const
+{
+  ClusterBeaconHeader beaconHeader;
+  beaconHeader.SetNChildren (m_childTable.GetNChildren ());
+  beaconHeader.SetEnergy (uint8_t (GetEnergyFraction () * 255 + 0.5));
+  Ptr<Packet> p = m_network->GetPacketPool ().Allocate (0);
+  p->AddHeader (beaconHeader);
+  return p;
+}
+
+void
+ClusterTreeProtocol::SendTrickleBeacon (void)
+{
+  // 地址块用完的节点不再招儿子，但计时器照走，有空位了再发
+  CheckEnergy ();
+  if (m_retired || (m_admission == ADMISSION_DELEGATED && !CanAdmit ()))
+    {
+      return;
+    }
+  SendBroadcast (HEADER_BEACON, CreateBeaconPayload ());
+}
+
+void
+ClusterTreeProtocol::DataIndication (McpsDataIndicationParams params, Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p->GetSize ());
+  if (m_depleted)
+    {
+      return;
+    }
+
+  ClusterHeader rcvHeader (m_extended);
+  p->RemoveHeader (rcvHeader);
+  if (rcvHeader.GetVersion () != ClusterHeader::VERSION)
+    {
+      NS_LOG_LOGIC ("node " << m_index << " dropped a version " << uint32_t (rcvHeader.GetVersion ()) << " frame");
+      return;
+    }
+  // the PHY tags every received frame; drop the tag so p can be forwarded as is
+  LrWpanLqiTag lqiTag;
+  p->RemovePacketTag (lqiTag);
+
+  // 链路增益查缓存，不再每帧调用CalcRxPower
+  uint32_t srcIndex = m_network->GetSourceIndex (params);
+  double rxPowerDbm = m_network->GetRxPowerDbm (srcIndex, m_index, m_txPowerDbm);
+  uint16_t type = rcvHeader.GetType ();
+  // 每帧都走这里，只记二进制事件，不再格式化日志
+  if (rxPowerDbm < m_rxSensitivityDbm)
+    {
+      // ClusterTreePhy 已经在物理层丢掉这些帧，这里只兜底普通的 LrWpanPhy
+      CLUSTER_EVENT_TRACE (m_tracer, CLUSTER_TRACE_RX_WEAK, m_index, srcIndex, type, rxPowerDbm);
+      return;
+    }
+  CLUSTER_EVENT_TRACE (m_tracer, CLUSTER_TRACE_RX, m_index, srcIndex, type, rxPowerDbm);
+  if (m_childTimeout.IsStrictlyPositive ())
+    {
+      m_childTable.MarkHeard (srcIndex);
+    }
+
+  if (params.m_dstAddrMode == SHORT_ADDR && params.m_dstAddr == m_broadcast)
+    {
+      // 若收到广播，只有求子广播需要处理
+      if (type == HEADER_BEACON)
+        {
+          ReceiveBeacon (srcIndex, rcvHeader.GetClusterId (), p, rxPowerDbm, params.m_mpduLinkQuality);
+        }
+      else if (type == HEADER_REPAIR_REQUEST)
+        {
+          ReceiveRepairRequest (srcIndex, rcvHeader.GetClusterId ());
+        }
+      return;
+    }
+
+  // 带发起者的是要转发的请示和批复，MAC重传或者绕回来的同一条只处理一次
+  if (rcvHeader.HasOriginator ()
+      && m_duplicates.IsDuplicate (type, rcvHeader.GetOriginator (), rcvHeader.GetSequence (), Simulator::Now ()))
+    {
+      CLUSTER_EVENT_TRACE (m_tracer, CLUSTER_TRACE_DUPLICATE, m_index, srcIndex, type);
+      return;
+    }
+
+  // 各类消息的内容都以自己的Header留在包里，由各自的处理函数读取，不再拷贝
+  switch (type)
+    {
+    case HEADER_BEACON:
+      // 修复时邻居单播回的信标
+      ReceiveBeacon (srcIndex, rcvHeader.GetClusterId (), p, rxPowerDbm, params.m_mpduLinkQuality);
+      break;
+    case HEADER_REQUEST_FATHER:
+      ReceiveRequestFather (srcIndex, p);
+      break;
+    case HEADER_REQUEST_CLUSTER_FOR_CHILD:
+      ReceiveRequestClusterForChild (srcIndex, rcvHeader, p);
+      break;
+    case HEADER_RETURN_CLUSTER_FOR_CHILD:
+      ReceiveReturnClusterForChild (srcIndex, rcvHeader, p);
+      break;
+    case HEADER_ACCEPT_CHILD:
+      ReceiveAcceptChild (srcIndex, p);
+      break;
+    case HEADER_REJECT_CHILD:
+      ReceiveRejectChild (srcIndex, rcvHeader, p);
+      break;
+    case HEADER_RELEASE_CHILD:
+      ReceiveReleaseChild (srcIndex, p);
+      break;
+    case HEADER_SEND_DATA_TO_COORDINATOR:
+      ReceiveData (srcIndex, p);
+      break;
+    case HEADER_SEND_AGGREGATE_TO_COORDINATOR:
+      ReceiveAggregate (srcIndex, p);
+      break;
+    default:
+      NS_LOG_LOGIC ("node " << m_index << " ignored header " << type);
+      break;
+    }
+}
+
+void
+ClusterTreeProtocol::RxBelowSensitivity (Ptr<const SpectrumSignalParameters> params, double rxPowerDbm)
+{
+  // 帧没有解码，不知道类型，记为0
+  Ptr<LrWpanNetDevice> txDevice = DynamicCast<LrWpanNetDevice> (params->txPhy->GetDevice ());
+  uint32_t src = txDevice != 0 ? m_network->GetMacIndex (txDevice->GetMac ()) : ClusterTreeNetwork::NO_NODE;
+  CLUSTER_EVENT_TRACE (m_tracer, CLUSTER_TRACE_RX_WEAK, m_index, src, 0, rxPowerDbm);
+}
+
+void
+ClusterTreeProtocol::ReceiveBeacon (uint32_t src, uint16_t clusterId, Ptr<Packet> p, double rxPowerDbm, uint8_t lqi)
+{
+  if (IsCoordinator () || m_joined)
+    {
+      // 邻居已经在发信标了，够k个自己这一轮就不发
+      m_beaconTimer.HearConsistent ();
+      return;
+    }
+  ClusterBeaconHeader beaconHeader;
+  if (p->PeekHeader (beaconHeader) == 0 || !CanAdoptFrom (clusterId))
+    {
+      return;
+    }
+  ClusterParentCandidate candidate;
+  candidate.node = src;
+  candidate.clusterId = clusterId;
+  candidate.nChildren = beaconHeader.GetNChildren ();
+  candidate.linkMarginDb = rxPowerDbm - m_rxSensitivityDbm;
+  candidate.lqi = lqi;
+  candidate.energy = beaconHeader.GetEnergy ();
+  // 正在等别人回复，先记下来，被拒或超时再找他
+  if (m_father != ClusterTreeNetwork::NO_NODE)
+    {
+      if (src != m_father)
+        {
+          AddCandidate (candidate);
+        }
+      return;
+    }
+  AddCandidate (candidate);
+  if (m_selectEvent.IsRunning ())
+    {
+      return;
+    }
+  // 第一个信标来了先别急，收一会再挑最好的；再退避一会，免得和邻居们挤在一起
+  m_selectEvent = Simulator::Schedule (m_selectionWindow + GetJoinBackoff (), &ClusterTreeProtocol::ChooseFather,
+                                       this);
+}
+
+void
+ClusterTreeProtocol::AddCandidate (const ClusterParentCandidate &candidate)
+{
+  for (std::vector<ClusterParentCandidate>::iterator i = m_candidates.begin (); i != m_candidates.end (); ++i)
+    {
+      if (i->node == candidate.node)
+        {
+          m_candidates.erase (i);
+          break;
+        }
+    }
+  double score = m_selector->Score (candidate);
+  std::vector<ClusterParentCandidate>::iterator pos = m_candidates.begin ();
+  while (pos != m_candidates.end () && m_selector->Score (*pos) >= score)
+    {
+      ++pos;
+    }
+  m_candidates.insert (pos, candidate);
+  if (m_candidates.size () > MAX_CANDIDATES)
+    {
+      m_candidates.pop_back ();
+    }
+}
+
+void
+ClusterTreeProtocol::ChooseFather (void)
+{
+  if (m_joined || m_father != ClusterTreeNetwork::NO_NODE || m_candidates.empty ())
+    {
+      return;
+    }
+  uint32_t best = m_candidates.front ().node;
+  m_candidates.erase (m_candidates.begin ());
+  RequestFather (best);
+}
+
+Time
+ClusterTreeProtocol::GetJoinBackoff (void)
+{
+  if (m_nNeighbors < 0)
+    {
+      std::vector<uint32_t> neighbors;
+      GetNeighbors (neighbors);
+      m_nNeighbors = neighbors.size ();
+    }
+  // 窗口按邻居数放大：邻居越多，同时回应的越多
+  int64_t window = m_joinBackoff.GetTimeStep () * std::max (m_nNeighbors, 1);
+  if (m_joinSlot.IsStrictlyPositive ())
+    {
+      uint32_t slots = std::max<int64_t> (window / m_joinSlot.GetTimeStep (), 1);
+      return TimeStep (m_joinSlot.GetTimeStep () * m_jitter->GetInteger (0, slots - 1));
+    }
+  return TimeStep (m_jitter->GetValue (0, window));
+}
+
+int64_t
+ClusterTreeProtocol::AssignStreams (int64_t stream)
+{
+  m_jitter->SetStream (stream);
+  return 1;
+}
+
+void
+ClusterTreeProtocol::RequestFather (uint32_t father)
+{
+  NS_LOG_INFO ("node " << m_index << " requests father " << father);
+  // 丢了父亲的簇头带着子树一起过去，告诉新父亲一声
+  ClusterJoinHeader joinHeader (m_extended);
+  joinHeader.SetFather (father);
+  joinHeader.SetChild (m_index);
+  joinHeader.SetSubtree (m_childTable.GetNChildren () != 0);
+  Ptr<Packet> request = m_network->GetPacketPool ().Allocate (0);
+  request->AddHeader (joinHeader);
+  SendP2p (father, HEADER_REQUEST_FATHER, request);
+  m_father = father;
+  m_joinEvent.Cancel ();
+  m_joinEvent = Simulator::Schedule (m_childWaitTimeout, &ClusterTreeProtocol::JoinTimeout, this);
+}
+
+void
+ClusterTreeProtocol::JoinTimeout (void)
+{
+  if (m_joined)
+    {
+      return;
+    }
+  NS_LOG_INFO ("node " << m_index << " got no answer from " << m_father);
+  m_father = ClusterTreeNetwork::NO_NODE;
+  if (!m_candidates.empty ())
+    {
+      uint32_t next = m_candidates.front ().node;
+      m_candidates.erase (m_candidates.begin ());
+      RequestFather (next);
+      return;
+    }
+  SendRepairRequest ();
+}
+
+void
+ClusterTreeProtocol::ReceiveRequestFather (uint32_t src, Ptr<Packet> p)
+{
+  if (!m_joined || m_retired)
+    {
+      return;
+    }
+  ClusterJoinHeader request (m_extended);
+  if (p->PeekHeader (request) == 0)
+    {
+      return;
+    }
+  bool subtree = request.HasSubtree ();
+  if (m_childTable.IsChild (src))
+    {
+      // 已经是儿子了，多半是批准丢了，再回一次；分块接纳的按记下的地址原样重发
+      SendP2p (src, HEADER_ACCEPT_CHILD, CreateChildClusterPayload (m_childTable.GetTreeAddress (src)));
+      return;
+    }
+  // 附近来了新的孤儿，可能还有别的没听到信标，间隔回到最短
+  m_beaconTimer.Reset ();
+
+  if (m_admission == ADMISSION_DELEGATED)
+    {
+      // 自己的地址块里还有空位就直接收下，不用问Coor
+      if (!CanAdmit ())
+        {
+          NS_LOG_LOGIC ("node " << m_index << " has no room for " << src);
+          return;
+        }
+      uint32_t childAddress = m_treeAddress + 1 + m_nextChild * GetCskip (m_clusterId);
+      m_nextChild++;
+      NS_LOG_INFO ("node " << m_index << " adopts " << src << " at tree address " << childAddress);
+      m_childTable.AddChild (src, childAddress);
+      if (subtree)
+        {
+          m_descendants.AddAll (src);
+        }
+      SendP2p (src, HEADER_ACCEPT_CHILD, CreateChildClusterPayload (childAddress));
+      return;
+    }
+
+  if (IsCoordinator ())
+    {
+      if (m_policy != 0 && !m_policy->CanAdmit (m_index, src))
+        {
+          NS_LOG_INFO ("coordinator refuses to adopt " << src);
+          m_nRejected++;
+          ClusterRedirectHeader redirect (m_extended);
+          redirect.SetFather (FindRedirect (src));
+          Ptr<Packet> reject = m_network->GetPacketPool ().Allocate (0);
+          reject->AddHeader (redirect);
+          SendP2p (src, HEADER_REJECT_CHILD, reject);
+          return;
+        }
+      if (m_policy != 0)
+        {
+          m_policy->Admit (m_index, src);
+        }
+      // 确立亲子关系：加入路由表，分配簇id
+      NS_LOG_INFO ("node " << m_index << " adopts " << src);
+      m_childTable.AddChild (src);
+      if (subtree)
+        {
+          m_descendants.AddAll (src);
+        }
+      SendP2p (src, HEADER_ACCEPT_CHILD, CreateChildClusterPayload ());
+      return;
+    }
+
+  if (m_childTable.IsPending (src, Simulator::Now ()))
+    {
+      return;
+    }
+  // 没这个儿子，就向Coor请示能不能要：把自己和请求节点的地址发给Coor
+  NS_LOG_INFO ("node " << m_index << " wants to be " << src << "'s father");
+  ClusterJoinHeader joinHeader (m_extended);
+  joinHeader.SetFather (m_index);
+  joinHeader.SetChild (src);
+  joinHeader.SetSubtree (subtree);
+  Ptr<Packet> forward = m_network->GetPacketPool ().Allocate (0);
+  forward->AddHeader (joinHeader);
+  // 自己是这条请示的发起者，一路转发和Coor的批复都带着自己的序号
+  ClusterHeader header (m_extended);
+  header.SetType (HEADER_REQUEST_CLUSTER_FOR_CHILD);
+  header.SetSequence (m_sequence++);
+  if (m_duplicates.IsEnabled ())
+    {
+      header.SetOriginator (m_index);
+    }
+  SendFrame (m_father, header, forward);
+  // 让这个准-儿子先等一等，超时就忘了他
+  m_childTable.AddPending (src, Simulator::Now () + m_childWaitTimeout);
+  Simulator::Schedule (m_childWaitTimeout, &ClusterTreeProtocol::ExpireWaitingChild, this, src);
+}
+
+void
+ClusterTreeProtocol::ExpireWaitingChild (uint32_t child)
+{
+  if (m_childTable.ExpirePending (child, Simulator::Now ()))
+    {
+      NS_LOG_INFO ("node " << m_index << " gave up waiting for permission to adopt " << child);
+    }
+}
+
+void
+ClusterTreeProtocol::ReceiveRequestClusterForChild (uint32_t src, const ClusterHeader &header, Ptr<Packet> p)
+{
+  // 包里存着这个曾...孙和准曾曾...孙的地址，记下准曾曾...孙在哪个儿子下面
+  ClusterJoinHeader joinHeader (m_extended);
+  if (p->PeekHeader (joinHeader) == 0)
+    {
+      return;
+    }
+  if (joinHeader.HasSubtree ())
+    {
+      // 带着子树回来的，里面有谁不知道，这一支以后都要转
+      m_descendants.AddAll (src);
+    }
+  else
+    {
+      m_descendants.Add (src, joinHeader.GetChild ());
+    }
+
+  if (!IsCoordinator ())
+    {
+      // 丢了父亲或者还在等新父亲批准时没有上行的路，请示丢掉，准父亲等不到会超时
+      if (!m_joined)
+        {
+          NS_LOG_LOGIC ("node " << m_index << " has no father, dropping a join request");
+          return;
+        }
+      // 原样转发给自己父亲，直到给Coordinator
+      SendFrame (m_father, header, p);
+      return;
+    }
+
+  uint32_t grandsonDad = joinHeader.GetFather ();
+  uint32_t grandson = joinHeader.GetChild ();
+  ClusterHeader reply = header;
+  if (m_policy != 0 && !m_policy->CanAdmit (grandsonDad, grandson))
+    {
+      // 不同意：在请示后面附上建议的父亲，沿原路送回去
+      NS_LOG_INFO ("coordinator refuses " << grandsonDad << " adopting " << grandson);
+      m_nRejected++;
+      ClusterRedirectHeader redirect (m_extended);
+      redirect.SetFather (FindRedirect (grandson));
+      p->RemoveHeader (joinHeader);
+      p->AddHeader (redirect);
+      p->AddHeader (joinHeader);
+      reply.SetType (HEADER_REJECT_CHILD);
+      SendToDescendant (grandsonDad, reply, p);
+      return;
+    }
+  if (m_policy != 0)
+    {
+      m_policy->Admit (grandsonDad, grandson);
+    }
+  // 同意就原样送回去，发起者和序号不变
+  NS_LOG_INFO ("coordinator agrees " << grandsonDad << " adopting " << grandson);
+  reply.SetType (HEADER_RETURN_CLUSTER_FOR_CHILD);
+  SendToDescendant (grandsonDad, reply, p);
+}
+
+void
+ClusterTreeProtocol::ReceiveReturnClusterForChild (uint32_t src, const ClusterHeader &header, Ptr<Packet> p)
+{
+  if (IsCoordinator ())
+    {
+      return;
+    }
+  ClusterJoinHeader joinHeader (m_extended);
+  if (p->PeekHeader (joinHeader) == 0)
+    {
+      return;
+    }
+  uint32_t son = joinHeader.GetChild ();
+
+  // 在留守区找人，找到了就将准-儿子改成儿子，并分配簇id
+  if (m_childTable.PromotePending (son, Simulator::Now ()))
+    {
+      NS_LOG_INFO ("node " << m_index << " gets son " << son << " under the coordinator's agreement");
+      if (joinHeader.HasSubtree ())
+        {
+          m_descendants.AddAll (son);
+        }
+      SendP2p (son, HEADER_ACCEPT_CHILD, CreateChildClusterPayload ());
+      return;
+    }
+  // 是给自己的但准-儿子已经等不及走了
+  if (joinHeader.GetFather () == m_index)
+    {
+      return;
+    }
+
+  // 不是自己的，就转发给可能有他的那个儿子
+  SendToDescendant (joinHeader.GetFather (), header, p);
+}
+
+void
+ClusterTreeProtocol::ReceiveRejectChild (uint32_t src, const ClusterHeader &header, Ptr<Packet> p)
+{
+  if (!m_joined)
+    {
+      // 被拒的孤儿：去问Coor建议的父亲，没有建议就问下一个候选
+      if (src != m_father)
+        {
+          return;
+        }
+      ClusterRedirectHeader redirect (m_extended);
+      if (p->PeekHeader (redirect) == 0)
+        {
+          return;
+        }
+      uint32_t next = redirect.GetFather ();
+      NS_LOG_INFO ("node " << m_index << " refused by " << m_father << ", redirected to " << next);
+      m_joinEvent.Cancel ();
+      if (next == ClusterTreeNetwork::NO_NODE || next == m_index || next == m_father)
+        {
+          JoinTimeout ();
+          return;
+        }
+      for (uint32_t i = 0; i < m_candidates.size (); ++i)
+        {
+          if (m_candidates[i].node == next)
+            {
+              m_candidates.erase (m_candidates.begin () + i);
+              break;
+            }
+        }
+      RequestFather (next);
+      return;
+    }
+
+  ClusterJoinHeader joinHeader (m_extended);
+  if (p->PeekHeader (joinHeader) == 0)
+    {
+      return;
+    }
+  if (joinHeader.GetFather () != m_index)
+    {
+      SendToDescendant (joinHeader.GetFather (), header, p);
+      return;
+    }
+  // 自己被拒了：忘掉这个准-儿子，把建议转告他
+  uint32_t child = joinHeader.GetChild ();
+  if (m_childTable.IsChild (child) || !m_childTable.IsPending (child, Simulator::Now ()))
+    {
+      return;
+    }
+  m_childTable.Remove (child);
+  p->RemoveHeader (joinHeader);
+  SendP2p (child, HEADER_REJECT_CHILD, p);
+}
+
+void
+ClusterTreeProtocol::ReceiveReleaseChild (uint32_t src, Ptr<Packet> p)
+{
+  if (src == m_father)
+    {
+      if (!m_joined)
+        {
+          return;
+        }
+      // 父亲不当簇头了，和丢了父亲一样，带着子树就近修复；他已经忘了自己，不用再告别
+      NS_LOG_INFO ("node " << m_index << " released by " << src);
+      LoseFather ();
+      m_lostFather = ClusterTreeNetwork::NO_NODE;
+      return;
+    }
+  if (!m_childTable.IsChild (src))
+    {
+      return;
+    }
+  ClusterJoinHeader joinHeader (m_extended);
+  if (p->PeekHeader (joinHeader) == 0)
+    {
+      return;
+    }
+  if (joinHeader.GetChild () == src)
+    {
+      // 儿子在别处重新入网了，来告别
+      NS_LOG_INFO ("node " << m_index << " lost child " << src << " to another father");
+      RemoveChild (src);
+      return;
+    }
+  // 下面的簇头少了个儿子，接着往Coor报
+  ReportDeparture (joinHeader.GetFather (), joinHeader.GetChild ());
+}
+
+void
+ClusterTreeProtocol::RemoveChild (uint32_t child)
+{
+  if (!m_childTable.IsChild (child))
+    {
+      return;
+    }
+  m_childTable.Remove (child);
+  m_descendants.Remove (child);
+  // 分块接纳的地址不收回，m_nextChild不变；Coor批准的要让Coor也减掉
+  if (m_admission == ADMISSION_COORDINATOR)
+    {
+      ReportDeparture (m_index, child);
+    }
+}
+
+void
+ClusterTreeProtocol::ReportDeparture (uint32_t father, uint32_t child)
+{
+  if (IsCoordinator ())
+    {
+      if (m_policy != 0)
+        {
+          m_policy->Detach (father, child);
+        }
+      return;
+    }
+  if (!m_joined)
+    {
+      // 没有上行的路，Coor的计数只会偏大
+      return;
+    }
+  ClusterJoinHeader joinHeader (m_extended);
+  joinHeader.SetFather (father);
+  joinHeader.SetChild (child);
+  Ptr<Packet> report = m_network->GetPacketPool ().Allocate (0);
+  report->AddHeader (joinHeader);
+  SendP2p (m_father, HEADER_RELEASE_CHILD, report);
+}
+
+void
+ClusterTreeProtocol::CheckChildren (void)
+{
+  // 一轮里一帧都没听到的儿子当他没了
+  std::vector<uint32_t> silent;
+  m_childTable.TakeSilent (silent);
+  for (std::vector<uint32_t>::const_iterator i = silent.begin (); i != silent.end (); ++i)
+    {
+      NS_LOG_INFO ("node " << m_index << " has not heard child " << *i << " for " << m_childTimeout);
+      RemoveChild (*i);
+    }
+  m_childCheckEvent = Simulator::Schedule (m_childTimeout, &ClusterTreeProtocol::CheckChildren, this);
+}
+
+uint32_t
+ClusterTreeProtocol::FindRedirect (uint32_t child)
+{
+  // Coor并不知道孤儿听得到谁，用网络的空间索引代替
+  if (m_range < 0)
+    {
+      m_range = m_network->GetRange (m_txPowerDbm, m_rxSensitivityDbm);
+    }
+  std::vector<uint32_t> neighbors;
+  m_network->GetNeighbors (child, m_range, neighbors);
+  return m_policy->FindAlternative (child, neighbors);
+}
+
+void
+ClusterTreeProtocol::ReceiveAcceptChild (uint32_t src, Ptr<Packet> p)
+{
+  if (IsCoordinator () || m_joined || src != m_father)
+    {
+      return;
+    }
+  // 收到认子回复，将收到的簇ID视为自己的簇ID，并广播求子
+  ClusterGrantHeader grantHeader (m_admission == ADMISSION_DELEGATED);
+  if (p->PeekHeader (grantHeader) == 0)
+    {
+      return;
+    }
+  m_clusterId = grantHeader.GetClusterId ();
+  m_treeAddress = grantHeader.GetTreeAddress ();
+  m_joined = true;
+  m_joinEvent.Cancel ();
+  m_selectEvent.Cancel ();
+  m_candidates.clear ();
+  m_fatherFailures = 0;
+  m_repairsLeft = 0;
+  NS_LOG_INFO ("node " << m_index << " gets father " << m_father << ", cluster " << m_clusterId);
+  m_joinTrace (m_father, m_clusterId);
+  CLUSTER_EVENT_TRACE (m_tracer, CLUSTER_TRACE_JOIN, m_index, m_father, m_clusterId);
+  if (m_lostFather != ClusterTreeNetwork::NO_NODE && m_lostFather != m_father)
+    {
+      // 修复后换了父亲，旧父亲要是还活着，告诉他把自己删掉
+      ClusterJoinHeader joinHeader (m_extended);
+      joinHeader.SetFather (m_lostFather);
+      joinHeader.SetChild (m_index);
+      Ptr<Packet> leave = m_network->GetPacketPool ().Allocate (0);
+      leave->AddHeader (joinHeader);
+      SendP2p (m_lostFather, HEADER_RELEASE_CHILD, leave);
+    }
+  m_lostFather = ClusterTreeNetwork::NO_NODE;
+  if (m_childTimeout.IsStrictlyPositive () && !m_childCheckEvent.IsRunning ())
+    {
+      m_childCheckEvent = Simulator::Schedule (m_childTimeout, &ClusterTreeProtocol::CheckChildren, this);
+    }
+  // 地址块用完的节点和退下来的簇头不再招儿子
+  if (!m_retired && (m_admission == ADMISSION_COORDINATOR || CanAdmit ()))
+    {
+      m_beaconEvent = Simulator::Schedule (GetJoinBackoff (), &ClusterTreeProtocol::SendBroadcast, this,
+                                           HEADER_BEACON, CreateBeaconPayload ());
+    }
+  if (m_beaconImin.IsStrictlyPositive ())
+    {
+      m_beaconTimer.Start ();
+    }
+}
+
+void
+ClusterTreeProtocol::ReceiveData (uint32_t src, Ptr<Packet> p)
+{
+  if (IsCoordinator ())
+    {
+      ClusterDataHeader dataHeader (m_extended);
+      if (p->RemoveHeader (dataHeader) == 0)
+        {
+          return;
+        }
+      m_dataRxTrace (p, dataHeader.GetOriginator ());
+      CLUSTER_EVENT_TRACE (m_tracer, CLUSTER_TRACE_DATA, m_index, dataHeader.GetOriginator (),
+                           HEADER_SEND_DATA_TO_COORDINATOR);
+      return;
+    }
+  if (!m_joined)
+    {
+      return;
+    }
+  if (!m_aggregationWindow.IsZero ())
+    {
+      ClusterDataHeader dataHeader (m_extended);
+      if (p->RemoveHeader (dataHeader) == 0)
+        {
+          return;
+        }
+      Aggregate (dataHeader.GetOriginator (), p);
+      return;
+    }
+  // 原样转发给父亲
+  SendP2p (m_father, HEADER_SEND_DATA_TO_COORDINATOR, p);
+}
+
+void
+ClusterTreeProtocol::ReceiveAggregate (uint32_t src, Ptr<Packet> p)
+{
+  if (!IsCoordinator () && m_aggregationWindow.IsZero ())
+    {
+      if (m_joined)
+        {
+          SendP2p (m_father, HEADER_SEND_AGGREGATE_TO_COORDINATOR, p);
+        }
+      return;
+    }
+  // 逐条拆开：Coor直接交付，簇头放进自己的包里
+  ClusterRecordHeader recordHeader (m_extended);
+  while (p->GetSize () >= recordHeader.GetSerializedSize ())
+    {
+      p->RemoveHeader (recordHeader);
+      if (recordHeader.GetSize () > p->GetSize ())
+        {
+          NS_LOG_LOGIC ("node " << m_index << " got a truncated aggregate from node " << src);
+          return;
+        }
+      Ptr<Packet> reading = p->CreateFragment (0, recordHeader.GetSize ());
+      p->RemoveAtStart (recordHeader.GetSize ());
+      if (IsCoordinator ())
+        {
+          m_dataRxTrace (reading, recordHeader.GetOriginator ());
+          CLUSTER_EVENT_TRACE (m_tracer, CLUSTER_TRACE_DATA, m_index, recordHeader.GetOriginator (),
+                               HEADER_SEND_AGGREGATE_TO_COORDINATOR);
+        }
+      else if (m_joined)
+        {
+          Aggregate (recordHeader.GetOriginator (), reading);
+        }
+    }
+}
+
+uint32_t
+ClusterTreeProtocol::GetMaxAggregateSize (void) const
+{
+  // 127字节PSDU减去MAC头(帧控制2、序号1、两个PAN ID各2、两个地址)和FCS 2，再减去ClusterHeader
+  uint32_t addressSize = m_extended ? 8 : 2;
+  uint32_t macOverhead = 2 + 1 + 2 + 2 + 2 * addressSize + 2;
+  ClusterHeader header (m_extended);
+  return 127 - macOverhead - header.GetSerializedSize ();
+}
+
+void
+ClusterTreeProtocol::Aggregate (uint32_t originator, Ptr<Packet> reading)
+{
+  ClusterRecordHeader recordHeader (m_extended);
+  uint32_t recordSize = recordHeader.GetSerializedSize () + reading->GetSize ();
+  if (reading->GetSize () > 0xff || recordSize > GetMaxAggregateSize ())
+    {
+      // 一条就装不下，单独发
+      ClusterDataHeader dataHeader (m_extended);
+      dataHeader.SetOriginator (originator);
+      reading->AddHeader (dataHeader);
+      SendP2p (m_father, HEADER_SEND_DATA_TO_COORDINATOR, reading);
+      return;
+    }
+  if (m_aggregate != 0 && m_aggregate->GetSize () + recordSize > GetMaxAggregateSize ())
+    {
+      FlushAggregate ();
+    }
+  if (m_aggregate == 0)
+    {
+      m_aggregate = Create<Packet> ();
+      m_aggregateRecords = 0;
+      m_aggregateEvent = Simulator::Schedule (m_aggregationWindow, &ClusterTreeProtocol::FlushAggregate, this);
+    }
+  recordHeader.SetOriginator (originator);
+  recordHeader.SetSize (reading->GetSize ());
+  reading->AddHeader (recordHeader);
+  m_aggregate->AddAtEnd (reading);
+  m_aggregateRecords++;
+}
+
+void
+ClusterTreeProtocol::FlushAggregate (void)
+{
+  m_aggregateEvent.Cancel ();
+  if (m_aggregate == 0)
+    {
+      return;
+    }
+  Ptr<Packet> p = m_aggregate;
+  m_aggregate = 0;
+  NS_LOG_LOGIC ("node " << m_index << " sends " << m_aggregateRecords << " readings in "
+                        << p->GetSize () << " bytes");
+  SendP2p (m_father, HEADER_SEND_AGGREGATE_TO_COORDINATOR, p);
+}
+
+void
+ClusterTreeProtocol::FloodToChildren (const ClusterHeader &header, Ptr<Packet> p)
+{
+  const std::vector<uint32_t> &children = m_childTable.GetChildren ();
+  for (uint32_t i = 0; i < children.size (); ++i)
+    {
+      // 最后一个儿子直接用收到的包
+      SendFrame (children[i], header, i + 1 == children.size () ? p : p->Copy ());
+    }
+}
+
+void
+ClusterTreeProtocol::SendToDescendant (uint32_t target, const ClusterHeader &header, Ptr<Packet> p)
+{
+  if (m_childTable.IsChild (target))
+    {
+      SendFrame (target, header, p);
+      return;
+    }
+  if (!m_descendants.IsEnabled ())
+    {
+      FloodToChildren (header, p);
+      return;
+    }
+  // 只发给过滤器里可能有他的儿子，误判时多发一支
+  const std::vector<uint32_t> &children = m_childTable.GetChildren ();
+  uint32_t last = ClusterTreeNetwork::NO_NODE;
+  for (uint32_t i = 0; i < children.size (); ++i)
+    {
+      if (!m_descendants.MayContain (children[i], target))
+        {
+          continue;
+        }
+      if (last != ClusterTreeNetwork::NO_NODE)
+        {
+          SendFrame (last, header, p->Copy ());
+        }
+      last = children[i];
+    }
+  if (last != ClusterTreeNetwork::NO_NODE)
+    {
+      SendFrame (last, header, p);
+    }
+  else
+    {
+      NS_LOG_LOGIC ("node " << m_index << " has no branch leading to " << target);
+    }
+}
+
+Ptr<Packet>
+ClusterTreeProtocol::CreateChildClusterPayload (uint32_t treeAddress) const
+{
+  ClusterGrantHeader grantHeader (m_admission == ADMISSION_DELEGATED);
+  grantHeader.SetClusterId (m_clusterId + 1);
+  grantHeader.SetTreeAddress (treeAddress);
+  Ptr<Packet> p = m_network->GetPacketPool ().Allocate (0);
+  p->AddHeader (grantHeader);
+  return p;
+}
+
+}
@@ -0,0 +1,633 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_TREE_PROTOCOL_H
+#define CLUSTER_TREE_PROTOCOL_H
+
+#include <ns3/object.h>
+#include <ns3/packet.h>
+#include <ns3/mac16-address.h>
+#include <ns3/address.h>
+#include <ns3/traced-callback.h>
+#include <ns3/nstime.h>
+#include <ns3/event-id.h>
+#include <ns3/random-variable-stream.h>
+#include <ns3/lr-wpan-mac.h>
+#include <ns3/energy-source.h>
+#include "ns3/cluster-admission-policy.h"
+#include "ns3/cluster-child-table.h"
+#include "ns3/cluster-descendant-filter.h"
+#include "ns3/cluster-duplicate-cache.h"
+#include "ns3/cluster-header.h"
+#include "ns3/cluster-event-tracer.h"
+#include "ns3/cluster-trickle-timer.h"
+#include "ns3/cluster-parent-selector.h"
+#include "ns3/cluster-slotted-mac.h"
+#include <deque>
+#include <vector>
+
+namespace ns3 {
+
+class LrWpanNetDevice;
+struct SpectrumSignalParameters;
+class ClusterTreeNetwork;
+
+/**
+ * \ingroup mylib
+ *
+ * Cluster-tree formation and convergecast on top of one LrWpanNetDevice.
+ *
+ * One instance is aggregated to every Node of the tree.  The coordinator
+ * (index 0) starts formation with a HEADER_BEACON; an orphan hearing a
+ * beacon asks the sender to become its father, and a non-coordinator
+ * father asks the coordinator for permission before adopting the child.
+ * The coordinator's permission travels back down only into the branch
+ * whose ClusterDescendantFilter holds the waiting father; every node
+ * learns its descendants from the requests it relays upwards.  With
+ * DescendantFilterBits set to 0 the permission is flooded to every child.
+ * Data sent with SendData is relayed hop by hop to the coordinator.
+ * With a non-zero AggregationWindow every node instead buffers its own
+ * and its descendants' readings for up to that long and sends them as
+ * ClusterRecordHeader records of one HEADER_SEND_AGGREGATE_TO_COORDINATOR
+ * frame, filled up to the 127-byte PSDU; the coordinator unpacks them.
+ *
+ * Nodes are identified by their index in the ClusterTreeNetwork; frames
+ * are addressed with the short or the extended address of that index,
+ * following the network's addressing mode.
+ *
+ * Join traffic is spread out so the answers to one beacon do not all
+ * contend for the channel at once: an orphan answers a beacon, and a new
+ * member sends its own beacon, after a random backoff drawn from a window
+ * of JoinBackoff per neighbour of this node.  With a non-zero JoinSlot the
+ * backoff is a whole number of slots.
+ *
+ * A node whose father fails to acknowledge ParentLossThreshold frames in
+ * a row repairs the tree locally: it keeps its children, broadcasts a
+ * HEADER_REPAIR_REQUEST with its depth, and joined neighbours that are
+ * shallower answer with a unicast beacon.  It then rejoins below one of
+ * them with its whole subtree, so the rest of the tree is untouched.
+ * Its descendants keep their cluster ids, which can only overstate
+ * their new depth.
+ *
+ * The cluster id handed to a child is its father's cluster id plus one,
+ * so it doubles as the tree depth.
+ *
+ * The father asking for a child numbers its HEADER_REQUEST_CLUSTER_FOR_CHILD
+ * with its own sequence number and puts itself in the ClusterHeader as
+ * originator; relays keep both, and the coordinator's
+ * HEADER_RETURN_CLUSTER_FOR_CHILD reuses them.  Every node remembers the
+ * relayed messages it handled in a ClusterDuplicateCache of
+ * DuplicateCacheSize slots for DuplicateLifetime and drops repeats, such as
+ * a frame retransmitted after a lost ACK.  DuplicateCacheSize 0 leaves the
+ * originator out of the header and handles every copy.
+ *
+ * With Admission set to Delegated every joined node owns a block of
+ * logical tree addresses, sized ZigBee-style from MaxChildren (Cm) and
+ * MaxDepth (Lm): a node at depth d hands child k the address
+ * own + 1 + k * Cskip(d), Cskip(d) = 1 + Cm + ... + Cm^(Lm-d-1), and
+ * admits it without asking the coordinator.  A node whose block is used
+ * up ignores further requests; the orphan tries the next father it heard
+ * once ChildWaitTimeout has run out.
+ *
+ * With coordinator admission the coordinator checks every adoption
+ * against its ClusterAdmissionPolicy.  A refused request comes back down
+ * as HEADER_REJECT_CHILD with a ClusterRedirectHeader naming the
+ * neighbour of the child the policy prefers; the refused father drops
+ * the waiting child and passes the redirect on, and the child asks the
+ * suggested father, or its next candidate when there is none.
+ *
+ * Given an EnergySource, a node advertises its residual energy in its
+ * beacons, so the parent selector can steer orphans away from drained
+ * fathers.  With a non-zero RotationThreshold a cluster head whose
+ * energy fraction falls below it retires: it sends HEADER_RELEASE_CHILD
+ * to its children, which repair locally with their subtrees, and stops
+ * adopting.  EnergyDepleted switches a node off for good.
+ *
+ * A father forgets a child that rejoined elsewhere, as the child sends
+ * its old father HEADER_RELEASE_CHILD once adopted again, and, with a
+ * non-zero ChildTimeout, a child it has not heard any frame from for one
+ * to two ChildTimeout.  The child's descendant filter goes with it, and
+ * under coordinator admission the departure travels up as
+ * HEADER_RELEASE_CHILD so the ClusterAdmissionPolicy detaches it too.
+ */
+class ClusterTreeProtocol : public Object
+{
+public:
+  /// Who decides whether a child may join.
+  enum Admission
+  {
+    ADMISSION_COORDINATOR, //!< every join is confirmed by the coordinator
+    ADMISSION_DELEGATED    //!< the father admits within its own address block
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClusterTreeProtocol ();
+  virtual ~ClusterTreeProtocol ();
+
+  /**
+   * Bind the protocol to a device and hook the MCPS callbacks.
+   * \param device the device of this node
+   * \param network state shared by the whole tree
+   * \param index index of this node in the network
+   */
+  void Setup (Ptr<LrWpanNetDevice> device, Ptr<ClusterTreeNetwork> network, uint32_t index);
+  /**
+   * Rank candidate fathers with selector instead of the default
+   * ClusterWeightedParentSelector.  Call before Setup.
+   * \param selector scores the beacons heard by an orphan
+   */
+  void SetParentSelector (Ptr<ClusterParentSelector> selector);
+  /**
+   * Send data towards the coordinator in the cells of slotted, instead
+   * of straight through CSMA-CA.  Control frames are not affected.
+   * \param slotted the slotted layer of this node, null to go back to CSMA-CA
+   */
+  void SetSlottedMac (Ptr<ClusterSlottedMac> slotted);
+  /**
+   * Check the adoptions the coordinator confirms against policy.  Only
+   * used on the coordinator with coordinator admission.
+   * \param policy the policy, null to admit every child
+   */
+  void SetAdmissionPolicy (Ptr<ClusterAdmissionPolicy> policy);
+  /**
+   * Advertise the residual energy of source in beacons and retire as a
+   * cluster head below RotationThreshold.
+   * \param source the battery of this node, null for mains power
+   */
+  void SetEnergySource (Ptr<EnergySource> source);
+  /**
+   * The battery is empty: forget the tree, switch the radio off and
+   * ignore everything from now on, Reset included.
+   */
+  void EnergyDepleted (void);
+  /**
+   * Tune to the listen channel the network's ClusterChannelPlan gives
+   * this node.  Call once the plan is built; afterwards every frame is
+   * sent on the listen channel of its destination, one at a time, and
+   * the radio returns to the own listen channel after the confirm.  A
+   * broadcast (beacon, repair request) is repeated on the own listen
+   * channel and on that of every neighbour in range, so clusters idling
+   * on their own channel still hear it.  Not meant to be combined with
+   * SetSlottedMac.
+   */
+  void ApplyChannelPlan (void);
+
+  /**
+   * Start (or restart) formation from the coordinator by broadcasting a
+   * beacon.  Only valid on the coordinator.
+   */
+  void StartFormation (void);
+  /**
+   * Forget the tree: drop father, children and pending work, as before
+   * the first beacon.  Resetting every node and calling StartFormation
+   * rebuilds the tree from scratch.  The cells of a slotted schedule
+   * belong to the old tree: the ClusterSlottedMac is stopped and
+   * detached, and data goes out with CSMA-CA until the schedule is
+   * installed again (ClusterTreeHelper::EnableSlottedConvergecast), which
+   * reuses the same ClusterSlottedMac.
+   */
+  void Reset (void);
+  /**
+   * Send a reading towards the coordinator through the current father.
+   * \param p the payload
+   */
+  void SendData (Ptr<Packet> p);
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this protocol.
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * \return true if this node is the PAN coordinator
+   */
+  bool IsCoordinator (void) const;
+  /**
+   * \return true if this node is part of the tree
+   */
+  bool IsJoined (void) const;
+  /**
+   * \return the cluster id (the depth in the tree)
+   */
+  uint16_t GetClusterId (void) const;
+  /**
+   * \return the index of the father, ClusterTreeNetwork::NO_NODE when
+   * orphaned
+   */
+  uint32_t GetFather (void) const;
+  /**
+   * \return the number of adopted children
+   */
+  uint32_t GetNChildren (void) const;
+  /**
+   * \return the short or extended address this node uses
+   */
+  Address GetAddress (void) const;
+  /**
+   * \return the index of this node in the network
+   */
+  uint32_t GetIndex (void) const;
+  /**
+   * \return the device given to Setup
+   */
+  Ptr<LrWpanNetDevice> GetDevice (void) const;
+  /**
+   * \return the logical tree address given by delegated admission, 0 on
+   * the coordinator and with coordinator admission
+   */
+  uint32_t GetTreeAddress (void) const;
+  /**
+   * \return the transmit power in dBm
+   */
+  double GetTxPower (void) const;
+  /**
+   * \return the weakest received power in dBm the protocol counts as a link
+   */
+  double GetRxSensitivity (void) const;
+  /**
+   * \return relayed messages this node dropped as duplicates
+   */
+  uint64_t GetNDuplicates (void) const;
+  /**
+   * \return adoptions the coordinator refused, 0 on other nodes
+   */
+  uint64_t GetNRejected (void) const;
+  /**
+   * \return the residual energy fraction of the battery, 1 without one
+   */
+  double GetEnergyFraction (void) const;
+  /**
+   * \return true if this node gave up being a cluster head for lack of energy
+   */
+  bool IsRetired (void) const;
+  /**
+   * \return true once EnergyDepleted was called
+   */
+  bool IsDepleted (void) const;
+
+  /**
+   * Nodes that hear this one at or above RxSensitivity with TxPower,
+   * found through the network's spatial index.
+   * \param neighbors receives the neighbour indices; cleared first
+   */
+  void GetNeighbors (std::vector<uint32_t> &neighbors);
+
+  /**
+   * MCPS-DATA.indication handler.
+   * \param params the indication parameters
+   * \param p the received MSDU
+   */
+  void DataIndication (McpsDataIndicationParams params, Ptr<Packet> p);
+  /**
+   * ClusterTreePhy RxBelowSensitivity sink, records CLUSTER_TRACE_RX_WEAK.
+   * \param params the ignored signal
+   * \param rxPowerDbm its received power
+   */
+  void RxBelowSensitivity (Ptr<const SpectrumSignalParameters> params, double rxPowerDbm);
+  /**
+   * MCPS-DATA.confirm handler.
+   * \param params the confirm parameters
+   */
+  void DataConfirm (McpsDataConfirmParams params);
+
+  /**
+   * TracedCallback signature for data delivered to the coordinator.
+   * \param [in] packet the payload, without protocol headers
+   * \param [in] originator index of the node that produced it
+   */
+  typedef void (* DataRxTracedCallback)(Ptr<const Packet> packet, uint32_t originator);
+  /**
+   * TracedCallback signature for a node joining the tree.
+   * \param [in] father index of the adopting node
+   * \param [in] clusterId the assigned cluster id
+   */
+  typedef void (* JoinTracedCallback)(uint32_t father, uint16_t clusterId);
+  /**
+   * TracedCallback signature for a frame handed to the MAC.
+   * \param [in] type the ClusterHeaderType
+   * \param [in] dst index of the next hop, ClusterTreeNetwork::NO_NODE
+   * for a broadcast
+   */
+  typedef void (* TxTracedCallback)(uint16_t type, uint32_t dst);
+  /**
+   * TracedCallback signature for a frame the MAC could not deliver.
+   * \param [in] status the MCPS-DATA.confirm status
+   */
+  typedef void (* TxFailedTracedCallback)(LrWpanMcpsDataConfirmStatus status);
+  /**
+   * TracedCallback signature for a node giving up on its father.
+   * \param [in] father index of the lost father
+   */
+  typedef void (* ParentLostTracedCallback)(uint32_t father);
+  /**
+   * TracedCallback signature for a node running out of energy.
+   * \param [in] index index of the node
+   */
+  typedef void (* EnergyDepletedTracedCallback)(uint32_t index);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// Candidate fathers remembered by an orphan, best scored first.
+  static const uint32_t MAX_CANDIDATES = 8;
+
+  /**
+   * Unicast a control or data message.
+   * \param dst index of the next hop
+   * \param type the ClusterHeaderType
+   * \param p the payload, a dummy payload is used when null
+   */
+  void SendP2p (uint32_t dst, uint16_t type, Ptr<Packet> p = 0);
+  /**
+   * Unicast a frame under a prepared ClusterHeader, keeping its type,
+   * originator and sequence number; the cluster id is set to this node's.
+   * \param dst index of the next hop
+   * \param header the header
+   * \param p the payload
+   */
+  void SendFrame (uint32_t dst, ClusterHeader header, Ptr<Packet> p);
+  /**
+   * Broadcast a control message.
+   * \param type the ClusterHeaderType
+   * \param p the payload, a dummy payload is used when null
+   */
+  void SendBroadcast (uint16_t type, Ptr<Packet> p = 0);
+  /**
+   * Hand a frame to the MAC.  When a channel plan is active a unicast
+   * goes out on the listen channel of dst, and a broadcast once on each
+   * listen channel of this node and its neighbours.
+   * \param dst destination index, NO_NODE for a broadcast
+   * \param params MCPS parameters
+   * \param p the frame
+   */
+  void HandToMac (uint32_t dst, McpsDataRequestParams params, Ptr<Packet> p);
+  /**
+   * Send a frame on a channel of the plan, queueing it while another
+   * frame is outstanding.
+   * \param channel IEEE 802.15.4 channel to send on
+   * \param params MCPS parameters
+   * \param p the frame
+   */
+  void TransmitOn (uint8_t channel, McpsDataRequestParams params, Ptr<Packet> p);
+  /**
+   * \param channel IEEE 802.15.4 channel to tune the PHY to
+   */
+  void TuneTo (uint8_t channel);
+
+  /// \name Message handlers, one per ClusterHeaderType; src is the sender index
+  /// \{
+  /**
+   * \param clusterId cluster id in the sender's ClusterHeader
+   * \param rxPowerDbm received power of the beacon
+   * \param lqi LQI the MAC reported for the beacon
+   */
+  void ReceiveBeacon (uint32_t src, uint16_t clusterId, Ptr<Packet> p, double rxPowerDbm, uint8_t lqi);
+  void ReceiveRepairRequest (uint32_t src, uint16_t clusterId);
+  void ReceiveRequestFather (uint32_t src, Ptr<Packet> p);
+  void ReceiveRequestClusterForChild (uint32_t src, const ClusterHeader &header, Ptr<Packet> p);
+  void ReceiveReturnClusterForChild (uint32_t src, const ClusterHeader &header, Ptr<Packet> p);
+  void ReceiveAcceptChild (uint32_t src, Ptr<Packet> p);
+  void ReceiveRejectChild (uint32_t src, const ClusterHeader &header, Ptr<Packet> p);
+  void ReceiveReleaseChild (uint32_t src, Ptr<Packet> p);
+  void ReceiveData (uint32_t src, Ptr<Packet> p);
+  void ReceiveAggregate (uint32_t src, Ptr<Packet> p);
+  /// \}
+
+  /**
+   * Ask a node to become the father and arm the join timeout.
+   * \param father index of the candidate father
+   */
+  void RequestFather (uint32_t father);
+  /**
+   * The requested father did not answer in ChildWaitTimeout: try the next
+   * candidate.
+   */
+  void JoinTimeout (void);
+  /**
+   * Remember a candidate father in score order, keeping the
+   * MAX_CANDIDATES best.
+   * \param candidate the beacon sender
+   */
+  void AddCandidate (const ClusterParentCandidate &candidate);
+  /**
+   * End of the collection window: ask the best candidate.
+   */
+  void ChooseFather (void);
+  /**
+   * The father stopped acknowledging: leave it and start local repair.
+   */
+  void LoseFather (void);
+  /**
+   * Forget a child with its descendant filter and report the departure
+   * towards the coordinator's admission policy.
+   * \param child the departed child
+   */
+  void RemoveChild (uint32_t child);
+  /**
+   * Tell the coordinator's ClusterAdmissionPolicy that child left father:
+   * directly on the coordinator, as HEADER_RELEASE_CHILD to the father
+   * elsewhere.
+   * \param father the node the child left
+   * \param child the departed node
+   */
+  void ReportDeparture (uint32_t father, uint32_t child);
+  /**
+   * Forget the children not heard from since the previous check and
+   * schedule the next one ChildTimeout later.
+   */
+  void CheckChildren (void);
+  /**
+   * Broadcast the next HEADER_REPAIR_REQUEST, if attempts are left.
+   */
+  void SendRepairRequest (void);
+  /**
+   * \param fatherClusterId cluster id advertised by a candidate father
+   * \return false if joining it could attach this node below its own subtree
+   */
+  bool CanAdoptFrom (uint16_t fatherClusterId) const;
+  /**
+   * Retire as a cluster head if the energy fraction is below
+   * RotationThreshold: release the children and stop adopting.
+   * Under coordinator admission every released child is reported to
+   * the coordinator, as RemoveChild does.
+   */
+  void CheckEnergy (void);
+  /**
+   * \return the ClusterBeaconHeader payload of a beacon
+   */
+  Ptr<Packet> CreateBeaconPayload (void) const;
+  /**
+   * Periodic beacon of a joined node, driven by m_beaconTimer.
+   */
+  void SendTrickleBeacon (void);
+  /**
+   * \return a random delay for a join answer or beacon, within a window
+   * sized from the number of neighbours
+   */
+  Time GetJoinBackoff (void);
+  /**
+   * \param depth cluster id of the father
+   * \return the tree addresses reserved for each child of a father at
+   * depth, 0 past MaxDepth or when the blocks overflow 32 bits
+   */
+  uint32_t GetCskip (uint16_t depth) const;
+  /**
+   * \return true if delegated admission still has an address for a child
+   */
+  bool CanAdmit (void) const;
+
+  /**
+   * Add a reading to the aggregate towards the father, sending the
+   * aggregate first if the reading does not fit.
+   * \param originator index of the node that produced the reading
+   * \param reading the reading, without protocol headers
+   */
+  void Aggregate (uint32_t originator, Ptr<Packet> reading);
+  /**
+   * Send the pending aggregate, if any.
+   */
+  void FlushAggregate (void);
+  /**
+   * \return the largest aggregate payload that fits in one frame
+   */
+  uint32_t GetMaxAggregateSize (void) const;
+
+  /**
+   * Send a message to every child, reusing p for the last one.
+   * \param header the header, see SendFrame
+   * \param p the payload
+   */
+  void FloodToChildren (const ClusterHeader &header, Ptr<Packet> p);
+  /**
+   * Send a message towards a descendant: directly if it is a child,
+   * otherwise to every child whose descendant filter may hold it, or to
+   * every child when the filters are disabled.
+   * \param target index of the descendant
+   * \param header the header, see SendFrame
+   * \param p the payload
+   */
+  void SendToDescendant (uint32_t target, const ClusterHeader &header, Ptr<Packet> p);
+
+  /**
+   * Drop a waiting child whose ChildWaitTimeout has run out.
+   * \param child index of the waiting child
+   */
+  void ExpireWaitingChild (uint32_t child);
+  /**
+   * Build the ClusterGrantHeader payload of HEADER_ACCEPT_CHILD.
+   * \param treeAddress the child's tree address, delegated admission only
+   * \return the payload
+   */
+  Ptr<Packet> CreateChildClusterPayload (uint32_t treeAddress = 0) const;
+  /**
+   * Coordinator only: the father a refused child should ask instead,
+   * chosen by the admission policy among the nodes the child can hear.
+   * \param child the refused node
+   * \return the suggested father, ClusterTreeNetwork::NO_NODE if none
+   */
+  uint32_t FindRedirect (uint32_t child);
+
+  Ptr<LrWpanNetDevice> m_device;       //!< device of this node
+  Ptr<LrWpanMac> m_mac;                //!< MAC of m_device, resolved once in Setup
+  Ptr<ClusterTreeNetwork> m_network;   //!< shared tree state
+  Ptr<ClusterEventTracer> m_tracer;    //!< binary event trace of the network, null when disabled
+  uint32_t m_index;                    //!< index of this node
+  bool m_extended;                     //!< frames use extended addresses
+  Mac16Address m_broadcast;            //!< ff:ff
+
+  uint16_t m_clusterId;                       //!< cluster id, equal to the depth
+  bool m_joined;                              //!< part of the tree
+  uint32_t m_father;                          //!< father index, NO_NODE when orphaned
+  uint32_t m_lostFather;                      //!< father given up by the last repair, NO_NODE if none
+  ClusterChildTable m_childTable;             //!< children and children waiting for the coordinator
+  ClusterDescendantFilter m_descendants;      //!< which child leads to which descendant
+  uint32_t m_descendantFilterBits;            //!< size of each filter of m_descendants
+  Time m_childWaitTimeout;                    //!< lifetime of a waiting child and of a father request
+  Time m_childTimeout;                        //!< silence after which a child is forgotten, zero never
+  EventId m_childCheckEvent;                  //!< next CheckChildren
+  ClusterDuplicateCache m_duplicates;         //!< relayed messages already handled
+  uint32_t m_duplicateCacheSize;              //!< slots of m_duplicates
+  Time m_duplicateLifetime;                   //!< how long m_duplicates remembers a message
+  Admission m_admission;                      //!< who admits children
+  Ptr<ClusterAdmissionPolicy> m_policy;       //!< coordinator's limits on adoptions, may be null
+  uint64_t m_nRejected;                       //!< adoptions refused by m_policy
+  Ptr<EnergySource> m_energySource;           //!< battery of this node, null for mains power
+  double m_rotationThreshold;                 //!< energy fraction below which a cluster head retires
+  bool m_retired;                             //!< no longer adopts children
+  bool m_depleted;                            //!< battery empty, the node is off
+  uint32_t m_maxChildren;                     //!< Cm of delegated admission
+  uint16_t m_maxDepth;                        //!< Lm of delegated admission
+  uint32_t m_treeAddress;                     //!< own tree address, delegated admission
+  uint32_t m_nextChild;                       //!< children admitted from the own block
+  std::vector<ClusterParentCandidate> m_candidates; //!< fathers heard, best scored first
+  Ptr<ClusterParentSelector> m_selector;      //!< scores the candidates
+  Time m_selectionWindow;                     //!< beacons collected before choosing a father
+  EventId m_selectEvent;                      //!< end of the collection window
+  Ptr<ClusterSlottedMac> m_slotted;           //!< cells for data to the father, may be null
+  EventId m_joinEvent;                        //!< delayed request or JoinTimeout of the outstanding one
+  EventId m_beaconEvent;                      //!< delayed beacon after joining
+  ClusterTrickleTimer m_beaconTimer;          //!< periodic beacons while joined
+  Time m_beaconImin;                          //!< Trickle Imin, zero for no periodic beacons
+  uint32_t m_beaconDoublings;                 //!< Trickle Imax = Imin * 2^doublings
+  uint32_t m_beaconRedundancy;                //!< Trickle k
+  Time m_joinBackoff;                         //!< backoff window per neighbour
+  Time m_joinSlot;                            //!< backoff granularity, zero for continuous
+  int32_t m_nNeighbors;                       //!< neighbour count, negative until needed
+  Ptr<UniformRandomVariable> m_jitter;        //!< draws the join backoff
+  uint32_t m_parentLossThreshold;             //!< failed confirms to the father before repair
+  uint32_t m_fatherFailures;                  //!< consecutive failed confirms to the father
+  uint16_t m_repairDepth;                     //!< cluster id held when the father was lost
+  uint32_t m_repairAttempts;                  //!< repair requests per repair
+  uint32_t m_repairsLeft;                     //!< repair requests still to send
+  uint8_t m_nextHandle;                       //!< msduHandle of the next unicast
+  uint8_t m_sequence;                         //!< sequence number of the next frame this node originates
+  std::vector<uint32_t> m_handleDst;          //!< destination of each msduHandle
+  /// A frame waiting for the radio under a channel plan.
+  struct ChannelTx
+  {
+    uint8_t channel;                //!< channel to send on
+    McpsDataRequestParams params;   //!< MCPS parameters
+    Ptr<Packet> packet;             //!< the frame
+  };
+  std::deque<ChannelTx> m_channelQueue;       //!< frames behind the outstanding one
+  bool m_channelTxPending;                    //!< a frame is with the MAC on some channel
+  uint8_t m_currentChannel;                   //!< channel the PHY is tuned to
+
+  double m_txPowerDbm;        //!< transmit power assumed by the receive filter
+  double m_rxSensitivityDbm;  //!< frames received below this power are dropped
+  uint32_t m_dummyPayloadSize; //!< payload size of control frames without data
+  Time m_aggregationWindow;   //!< how long readings wait for an aggregate, zero disables
+  Ptr<Packet> m_aggregate;    //!< records waiting for FlushAggregate, null when empty
+  uint32_t m_aggregateRecords; //!< records in m_aggregate
+  EventId m_aggregateEvent;   //!< end of the current aggregation window
+  double m_range;             //!< radio range for TxPower and RxSensitivity, negative until needed
+
+  TracedCallback<Ptr<const Packet>, uint32_t> m_dataRxTrace; //!< data reached the coordinator
+  TracedCallback<uint32_t, uint16_t> m_joinTrace;           //!< this node joined the tree
+  TracedCallback<uint16_t, uint32_t> m_txTrace;             //!< a frame was handed to the MAC
+  TracedCallback<LrWpanMcpsDataConfirmStatus> m_txFailedTrace; //!< the MAC gave up on a frame
+  TracedCallback<uint32_t> m_parentLostTrace;               //!< the father was given up
+  TracedCallback<uint32_t> m_energyDepletedTrace;           //!< the battery ran out
+};
+
+}
+#endif /* CLUSTER_TREE_PROTOCOL_H */
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/simulator.h>
+#include "ns3/cluster-trickle-timer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClusterTrickleTimer");
+
+ClusterTrickleTimer::ClusterTrickleTimer ()
+  : m_doublings (0),
+    m_k (0),
+    m_counter (0),
+    m_running (false)
+{
+}
+
+ClusterTrickleTimer::~ClusterTrickleTimer ()
+{
+  Stop ();
+}
+
+void
+ClusterTrickleTimer::SetParameters (Time imin, uint32_t doublings, uint32_t k)
+{
+  m_imin = imin;
+  m_doublings = doublings;
+  m_k = k;
+}
+
+void
+ClusterTrickleTimer::SetFunction (Callback<void> transmit)
+{
+  m_transmit = transmit;
+}
+
+void
+ClusterTrickleTimer::SetRandomVariable (Ptr<UniformRandomVariable> random)
+{
+  m_random = random;
+}
+
+void
+ClusterTrickleTimer::Start (void)
+{
+  NS_ASSERT_MSG (m_imin.IsStrictlyPositive (), "Trickle Imin must be positive");
+  Stop ();
+  m_running = true;
+  m_interval = m_imin;
+  StartInterval ();
+}
+
+void
+ClusterTrickleTimer::Stop (void)
+{
+  m_running = false;
+  m_fireEvent.Cancel ();
+  m_endEvent.Cancel ();
+}
+
+void
+ClusterTrickleTimer::Reset (void)
+{
+  // 已经是最短间隔就不用重来，免得一直重置一直不发
+  if (!m_running || m_interval == m_imin)
+    {
+      return;
+    }
+  NS_LOG_LOGIC ("trickle reset from " << m_interval.GetSeconds () << " s");
+  Start ();
+}
+
+void
+ClusterTrickleTimer::HearConsistent (void)
+{
+  m_counter++;
+}
+
+bool
+ClusterTrickleTimer::IsRunning (void) const
+{
+  return m_running;
+}
+
+Time
+ClusterTrickleTimer::GetInterval (void) const
+{
+  return m_interval;
+}
+
+void
+ClusterTrickleTimer::StartInterval (void)
+{
+  m_counter = 0;
+  int64_t half = m_interval.GetTimeStep () / 2;
+  Time t = TimeStep (half + int64_t (m_random->GetValue (0, m_interval.GetTimeStep () - half)));
+  m_fireEvent = Simulator::Schedule (t, &ClusterTrickleTimer::Fire, this);
+  m_endEvent = Simulator::Schedule (m_interval, &ClusterTrickleTimer::EndInterval, this);
+}
+
+void
+ClusterTrickleTimer::Fire (void)
+{
+  if (m_k == 0 || m_counter < m_k)
+    {
+      m_transmit ();
+    }
+}
+
+void
+ClusterTrickleTimer::EndInterval (void)
+{
+  Time imax = m_imin;
+  for (uint32_t i = 0; i < m_doublings; ++i)
+    {
+      imax = imax + imax;
+    }
+  m_interval = m_interval + m_interval;
+  if (m_interval > imax)
+    {
+      m_interval = imax;
+    }
+  StartInterval ();
+}
+
+}
@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CLUSTER_TRICKLE_TIMER_H
+#define CLUSTER_TRICKLE_TIMER_H
+
+#include <ns3/nstime.h>
+#include <ns3/event-id.h>
+#include <ns3/callback.h>
+#include <ns3/random-variable-stream.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup mylib
+ *
+ * Trickle timer (RFC 6206) for periodic control messages.
+ *
+ * Each interval I starts at Imin and doubles up to Imin * 2^doublings
+ * while the neighbourhood stays consistent.  At a random time t in
+ * [I/2, I) the callback fires unless k consistent messages were heard in
+ * the current interval.  Reset goes back to Imin on an inconsistency.
+ */
+class ClusterTrickleTimer
+{
+public:
+  ClusterTrickleTimer ();
+  ~ClusterTrickleTimer ();
+
+  /**
+   * \param imin smallest interval
+   * \param doublings how many times the interval may double
+   * \param k redundancy constant, 0 never suppresses
+   */
+  void SetParameters (Time imin, uint32_t doublings, uint32_t k);
+  /**
+   * \param transmit called at t when not suppressed
+   */
+  void SetFunction (Callback<void> transmit);
+  /**
+   * \param random draws t within each interval
+   */
+  void SetRandomVariable (Ptr<UniformRandomVariable> random);
+
+  /**
+   * Start with an interval of Imin.
+   */
+  void Start (void);
+  /**
+   * Stop the timer.
+   */
+  void Stop (void);
+  /**
+   * Inconsistency heard: restart with an interval of Imin unless the
+   * interval already is Imin.
+   */
+  void Reset (void);
+  /**
+   * A consistent message was heard in the current interval.
+   */
+  void HearConsistent (void);
+
+  /**
+   * \return true between Start and Stop
+   */
+  bool IsRunning (void) const;
+  /**
+   * \return the current interval
+   */
+  Time GetInterval (void) const;
+
+private:
+  /**
+   * Begin an interval of length m_interval.
+   */
+  void StartInterval (void);
+  /**
+   * Time t of the current interval.
+   */
+  void Fire (void);
+  /**
+   * End of the current interval: double it and start the next one.
+   */
+  void EndInterval (void);
+
+  Time m_imin;                           //!< smallest interval
+  uint32_t m_doublings;                  //!< Imax = Imin * 2^m_doublings
+  uint32_t m_k;                          //!< redundancy constant
+  Time m_interval;                       //!< current interval I
+  uint32_t m_counter;                    //!< consistent messages heard in I
+  bool m_running;                        //!< started and not stopped
+  EventId m_fireEvent;                   //!< time t
+  EventId m_endEvent;                    //!< end of I
+  Callback<void> m_transmit;             //!< sends the message
+  Ptr<UniformRandomVariable> m_random;   //!< draws t
+};
+
+}
+#endif /* CLUSTER_TRICKLE_TIMER_H */
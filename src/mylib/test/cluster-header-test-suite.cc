@@ -0,0 +1,462 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/test.h>
+#include <ns3/packet.h>
+#include <ns3/random-variable-stream.h>
+#include "ns3/cluster-header.h"
+#include "ns3/cluster-tree-network.h"
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * \param extended address width
+ * \return bytes of one address in a ClusterHeader
+ */
+uint32_t
+AddressSize (bool extended)
+{
+  return extended ? 8 : 2;
+}
+
+/**
+ * \param header the header to serialize
+ * \return the bytes Serialize writes
+ */
+std::vector<uint8_t>
+ToBytes (const Header &header)
+{
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (header);
+  std::vector<uint8_t> bytes (p->GetSize ());
+  p->CopyData (&bytes[0], bytes.size ());
+  return bytes;
+}
+
+}
+
+/**
+ * \ingroup mylib
+ * Every header type with every combination of the originator and target
+ * flags survives AddHeader and RemoveHeader unchanged.
+ */
+class ClusterHeaderRoundTripTestCase : public TestCase
+{
+public:
+  /**
+   * \param extended test 8-byte instead of 2-byte addresses
+   */
+  ClusterHeaderRoundTripTestCase (bool extended);
+
+private:
+  virtual void DoRun (void);
+  bool m_extended;  //!< address width under test
+};
+
+ClusterHeaderRoundTripTestCase::ClusterHeaderRoundTripTestCase (bool extended)
+  : TestCase (extended ? "Round trip with extended addresses" : "Round trip with short addresses"),
+    m_extended (extended)
+{
+}
+
+void
+ClusterHeaderRoundTripTestCase::DoRun (void)
+{
+  // 短地址网络最大的节点号是MAX_SHORT_NODES - 1，NO_NODE 写成地址0也要原样读回来
+  uint32_t nodes[] = { 0, 1, 0x1234, ClusterTreeNetwork::MAX_SHORT_NODES - 1, ClusterTreeNetwork::NO_NODE };
+  for (uint16_t type = HEADER_REQUEST_FATHER; type <= HEADER_RELEASE_CHILD; ++type)
+    {
+      for (uint32_t flags = 0; flags < 4; ++flags)
+        {
+          for (uint32_t n = 0; n < sizeof (nodes) / sizeof (nodes[0]); ++n)
+            {
+              ClusterHeader header (m_extended);
+              header.SetType (type);
+              header.SetSequence (uint8_t (type * 37 + n));
+              header.SetClusterId (uint16_t (0xffff - n));
+              if (flags & 1)
+                {
+                  header.SetOriginator (nodes[n]);
+                }
+              if (flags & 2)
+                {
+                  header.SetTarget (nodes[(n + 1) % 5]);
+                }
+              uint32_t addresses = (flags & 1) + (flags >> 1);
+              NS_TEST_ASSERT_MSG_EQ (header.GetSerializedSize (), 4 + addresses * AddressSize (m_extended),
+                                     "wrong size of type " << type << " flags " << flags);
+
+              Ptr<Packet> p = Create<Packet> ();
+              p->AddHeader (header);
+              ClusterHeader parsed (m_extended);
+              uint32_t read = p->RemoveHeader (parsed);
+              NS_TEST_ASSERT_MSG_EQ (read, header.GetSerializedSize (), "read a different size");
+              NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 0, "bytes left behind");
+              NS_TEST_ASSERT_MSG_EQ (uint32_t (parsed.GetVersion ()), uint32_t (ClusterHeader::VERSION), "version");
+              NS_TEST_ASSERT_MSG_EQ (parsed.GetType (), type, "type");
+              NS_TEST_ASSERT_MSG_EQ (uint32_t (parsed.GetSequence ()), uint32_t (header.GetSequence ()), "sequence");
+              NS_TEST_ASSERT_MSG_EQ (parsed.GetClusterId (), header.GetClusterId (), "cluster id");
+              NS_TEST_ASSERT_MSG_EQ (parsed.HasOriginator (), (flags & 1) != 0, "originator flag");
+              NS_TEST_ASSERT_MSG_EQ (parsed.HasTarget (), (flags & 2) != 0, "target flag");
+              if (flags & 1)
+                {
+                  NS_TEST_ASSERT_MSG_EQ (parsed.GetOriginator (), nodes[n], "originator");
+                }
+              if (flags & 2)
+                {
+                  NS_TEST_ASSERT_MSG_EQ (parsed.GetTarget (), nodes[(n + 1) % 5], "target");
+                }
+            }
+        }
+    }
+}
+
+/**
+ * \ingroup mylib
+ * The packed word has the documented layout,
+ * version:2 | originator:1 | target:1 | type:4 | sequence:8 | cluster id:16,
+ * and a word of another version is reported as such without its fields.
+ */
+class ClusterHeaderBitsTestCase : public TestCase
+{
+public:
+  ClusterHeaderBitsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ClusterHeaderBitsTestCase::ClusterHeaderBitsTestCase ()
+  : TestCase ("Layout of the packed word")
+{
+}
+
+void
+ClusterHeaderBitsTestCase::DoRun (void)
+{
+  ClusterHeader header;
+  header.SetType (HEADER_REJECT_CHILD);
+  header.SetSequence (0xa5);
+  header.SetClusterId (0x1234);
+  std::vector<uint8_t> bytes = ToBytes (header);
+  NS_TEST_ASSERT_MSG_EQ (bytes.size (), 4, "plain header is one word");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (bytes[0]), uint32_t (ClusterHeader::VERSION << 6 | HEADER_REJECT_CHILD),
+                         "version, flags and type");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (bytes[1]), 0xa5u, "sequence");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (bytes[2]), 0x12u, "cluster id, high byte first");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (bytes[3]), 0x34u, "cluster id, low byte");
+
+  header.SetOriginator (7);
+  bytes = ToBytes (header);
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (bytes[0] & 0x30), 0x20u, "originator bit alone");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (bytes[4] << 8 | bytes[5]), 8u, "originator written as index + 1");
+  header.SetTarget (9);
+  bytes = ToBytes (header);
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (bytes[0] & 0x30), 0x30u, "originator and target bits");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (bytes[6] << 8 | bytes[7]), 10u, "target after the originator");
+
+  // 别的版本：标志位都置上也不去读地址
+  for (uint8_t version = 0; version < 4; ++version)
+    {
+      if (version == ClusterHeader::VERSION)
+        {
+          continue;
+        }
+      uint8_t word[] = { uint8_t (version << 6 | 0x30 | HEADER_BEACON), 1, 0, 2 };
+      Ptr<Packet> p = Create<Packet> (word, sizeof (word));
+      ClusterHeader parsed;
+      NS_TEST_ASSERT_MSG_EQ (p->PeekHeader (parsed), 4, "only the word is read");
+      NS_TEST_ASSERT_MSG_EQ (uint32_t (parsed.GetVersion ()), uint32_t (version), "version reported");
+      NS_TEST_ASSERT_MSG_EQ (parsed.HasOriginator (), false, "no originator in an unknown version");
+      NS_TEST_ASSERT_MSG_EQ (parsed.HasTarget (), false, "no target in an unknown version");
+    }
+}
+
+/**
+ * \ingroup mylib
+ * Every strict prefix of a valid header deserializes as version 0
+ * without reading past its end.
+ */
+class ClusterHeaderTruncatedTestCase : public TestCase
+{
+public:
+  /**
+   * \param extended test 8-byte instead of 2-byte addresses
+   */
+  ClusterHeaderTruncatedTestCase (bool extended);
+
+private:
+  virtual void DoRun (void);
+  bool m_extended;  //!< address width under test
+};
+
+ClusterHeaderTruncatedTestCase::ClusterHeaderTruncatedTestCase (bool extended)
+  : TestCase (extended ? "Truncated headers with extended addresses" : "Truncated headers with short addresses"),
+    m_extended (extended)
+{
+}
+
+void
+ClusterHeaderTruncatedTestCase::DoRun (void)
+{
+  for (uint32_t flags = 0; flags < 4; ++flags)
+    {
+      ClusterHeader header (m_extended);
+      header.SetType (HEADER_RETURN_CLUSTER_FOR_CHILD);
+      header.SetSequence (3);
+      header.SetClusterId (4);
+      if (flags & 1)
+        {
+          header.SetOriginator (5);
+        }
+      if (flags & 2)
+        {
+          header.SetTarget (6);
+        }
+      std::vector<uint8_t> bytes = ToBytes (header);
+      for (uint32_t length = 0; length < bytes.size (); ++length)
+        {
+          Ptr<Packet> p = length != 0 ? Create<Packet> (&bytes[0], length) : Create<Packet> ();
+          ClusterHeader parsed (m_extended);
+          uint32_t read = p->PeekHeader (parsed);
+          NS_TEST_ASSERT_MSG_LT_OR_EQ (read, length, "read past the end of a " << length << "-byte frame");
+          NS_TEST_ASSERT_MSG_EQ (uint32_t (parsed.GetVersion ()), 0u, "truncated frame accepted, length " << length);
+          NS_TEST_ASSERT_MSG_EQ (parsed.HasOriginator (), false, "originator of a truncated frame");
+          NS_TEST_ASSERT_MSG_EQ (parsed.HasTarget (), false, "target of a truncated frame");
+        }
+    }
+}
+
+/**
+ * \ingroup mylib
+ * Random byte strings never make Deserialize read past the end, and
+ * whatever it accepts as VERSION is self-consistent.
+ */
+class ClusterHeaderFuzzTestCase : public TestCase
+{
+public:
+  ClusterHeaderFuzzTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ClusterHeaderFuzzTestCase::ClusterHeaderFuzzTestCase ()
+  : TestCase ("Random byte strings")
+{
+}
+
+void
+ClusterHeaderFuzzTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+  uint8_t bytes[24];
+  for (uint32_t k = 0; k < 20000; ++k)
+    {
+      bool extended = (k & 1) != 0;
+      uint32_t length = random->GetInteger (0, sizeof (bytes));
+      for (uint32_t i = 0; i < length; ++i)
+        {
+          bytes[i] = random->GetInteger (0, 255);
+        }
+      Ptr<Packet> p = length != 0 ? Create<Packet> (bytes, length) : Create<Packet> ();
+      ClusterHeader parsed (extended);
+      uint32_t read = p->PeekHeader (parsed);
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (read, length, "read past the end of a " << length << "-byte frame");
+      std::ostringstream os;
+      parsed.Print (os);
+      if (parsed.GetVersion () != ClusterHeader::VERSION)
+        {
+          NS_TEST_ASSERT_MSG_EQ (parsed.HasOriginator () || parsed.HasTarget (), false,
+                                 "addresses kept from a rejected frame");
+          continue;
+        }
+      NS_TEST_ASSERT_MSG_EQ (read, parsed.GetSerializedSize (), "accepted size disagrees with the flags");
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (parsed.GetType (), 0x0f, "type wider than 4 bits");
+      // 接受下来的头重新编码要和原来的字节一样；扩展地址只有低32位是节点号，只比公共字
+      std::vector<uint8_t> again = ToBytes (parsed);
+      NS_TEST_ASSERT_MSG_EQ (again.size (), read, "re-encoded size");
+      for (uint32_t i = 0; i < (extended ? 4 : read); ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ (uint32_t (again[i]), uint32_t (bytes[i]), "re-encoded byte " << i);
+        }
+    }
+}
+
+/**
+ * \ingroup mylib
+ * The payload headers read either all of their bytes or none: every
+ * strict prefix and every short random string deserializes to 0 bytes
+ * with node fields at NO_NODE.
+ */
+class ClusterPayloadHeaderTestCase : public TestCase
+{
+public:
+  /**
+   * \param extended test 8-byte instead of 2-byte addresses
+   */
+  ClusterPayloadHeaderTestCase (bool extended);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Deserialize every prefix of header's bytes into parsed, ending
+   * with the complete header.
+   * \param header a valid header
+   * \param parsed a header of the same type and addressing
+   */
+  void CheckPrefixes (const Header &header, Header &parsed);
+  bool m_extended;  //!< address width under test
+};
+
+ClusterPayloadHeaderTestCase::ClusterPayloadHeaderTestCase (bool extended)
+  : TestCase (extended ? "Payload headers with extended addresses" : "Payload headers with short addresses"),
+    m_extended (extended)
+{
+}
+
+void
+ClusterPayloadHeaderTestCase::CheckPrefixes (const Header &header, Header &parsed)
+{
+  std::vector<uint8_t> bytes = ToBytes (header);
+  for (uint32_t length = 0; length <= bytes.size (); ++length)
+    {
+      Ptr<Packet> p = length != 0 ? Create<Packet> (&bytes[0], length) : Create<Packet> ();
+      uint32_t read = p->PeekHeader (parsed);
+      NS_TEST_ASSERT_MSG_EQ (read, length == bytes.size () ? length : 0,
+                             header.GetInstanceTypeId ().GetName () << " read " << read << " of " << length << " bytes");
+    }
+}
+
+void
+ClusterPayloadHeaderTestCase::DoRun (void)
+{
+  const uint32_t none = ClusterTreeNetwork::NO_NODE;
+  Ptr<Packet> empty = Create<Packet> ();
+
+  ClusterJoinHeader join (m_extended);
+  join.SetFather (3);
+  join.SetChild (4);
+  join.SetSubtree (true);
+  ClusterJoinHeader parsedJoin (m_extended);
+  CheckPrefixes (join, parsedJoin);
+  NS_TEST_ASSERT_MSG_EQ (parsedJoin.GetFather (), 3u, "join father");
+  NS_TEST_ASSERT_MSG_EQ (parsedJoin.GetChild (), 4u, "join child");
+  NS_TEST_ASSERT_MSG_EQ (parsedJoin.HasSubtree (), true, "join subtree");
+  empty->PeekHeader (parsedJoin);
+  NS_TEST_ASSERT_MSG_EQ (parsedJoin.GetFather (), none, "father of a truncated join");
+  NS_TEST_ASSERT_MSG_EQ (parsedJoin.GetChild (), none, "child of a truncated join");
+  NS_TEST_ASSERT_MSG_EQ (parsedJoin.HasSubtree (), false, "subtree of a truncated join");
+
+  // 扩展地址那一轮顺便测带树地址的分块接纳
+  ClusterGrantHeader grant (m_extended);
+  grant.SetClusterId (5);
+  grant.SetTreeAddress (6);
+  ClusterGrantHeader parsedGrant (m_extended);
+  CheckPrefixes (grant, parsedGrant);
+  NS_TEST_ASSERT_MSG_EQ (parsedGrant.GetClusterId (), 5, "grant cluster id");
+  empty->PeekHeader (parsedGrant);
+  NS_TEST_ASSERT_MSG_EQ (parsedGrant.GetClusterId (), 0, "cluster id of a truncated grant");
+
+  ClusterRedirectHeader redirect (m_extended);
+  redirect.SetFather (7);
+  ClusterRedirectHeader parsedRedirect (m_extended);
+  CheckPrefixes (redirect, parsedRedirect);
+  NS_TEST_ASSERT_MSG_EQ (parsedRedirect.GetFather (), 7u, "redirect father");
+  empty->PeekHeader (parsedRedirect);
+  NS_TEST_ASSERT_MSG_EQ (parsedRedirect.GetFather (), none, "father of a truncated redirect");
+
+  ClusterBeaconHeader beacon;
+  beacon.SetNChildren (8);
+  beacon.SetEnergy (9);
+  ClusterBeaconHeader parsedBeacon;
+  CheckPrefixes (beacon, parsedBeacon);
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (parsedBeacon.GetNChildren ()), 8u, "beacon children");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (parsedBeacon.GetEnergy ()), 9u, "beacon energy");
+  empty->PeekHeader (parsedBeacon);
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (parsedBeacon.GetEnergy ()), 0u, "energy of a truncated beacon");
+
+  ClusterDataHeader data (m_extended);
+  data.SetOriginator (10);
+  ClusterDataHeader parsedData (m_extended);
+  CheckPrefixes (data, parsedData);
+  NS_TEST_ASSERT_MSG_EQ (parsedData.GetOriginator (), 10u, "data originator");
+  empty->PeekHeader (parsedData);
+  NS_TEST_ASSERT_MSG_EQ (parsedData.GetOriginator (), none, "originator of truncated data");
+
+  ClusterRecordHeader record (m_extended);
+  record.SetOriginator (11);
+  record.SetSize (12);
+  ClusterRecordHeader parsedRecord (m_extended);
+  CheckPrefixes (record, parsedRecord);
+  NS_TEST_ASSERT_MSG_EQ (parsedRecord.GetOriginator (), 11u, "record originator");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (parsedRecord.GetSize ()), 12u, "record size");
+  empty->PeekHeader (parsedRecord);
+  NS_TEST_ASSERT_MSG_EQ (parsedRecord.GetOriginator (), none, "originator of a truncated record");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (parsedRecord.GetSize ()), 0u, "size of a truncated record");
+
+  // 随机字节：够长就整个读，不够就一个字节也不读
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (2);
+  uint8_t bytes[20];
+  for (uint32_t k = 0; k < 5000; ++k)
+    {
+      uint32_t length = random->GetInteger (0, sizeof (bytes));
+      for (uint32_t i = 0; i < length; ++i)
+        {
+          bytes[i] = random->GetInteger (0, 255);
+        }
+      Ptr<Packet> p = length != 0 ? Create<Packet> (bytes, length) : Create<Packet> ();
+      Header *headers[] = { &parsedJoin, &parsedGrant, &parsedRedirect, &parsedBeacon, &parsedData, &parsedRecord };
+      for (uint32_t h = 0; h < sizeof (headers) / sizeof (headers[0]); ++h)
+        {
+          uint32_t size = headers[h]->GetSerializedSize ();
+          uint32_t read = p->PeekHeader (*headers[h]);
+          NS_TEST_ASSERT_MSG_EQ (read, length >= size ? size : 0,
+                                 headers[h]->GetInstanceTypeId ().GetName () << " read " << read
+                                 << " of a " << length << "-byte frame");
+        }
+    }
+}
+
+/**
+ * \ingroup mylib
+ * Tests of ClusterHeader and the payload headers.
+ */
+class ClusterHeaderTestSuite : public TestSuite
+{
+public:
+  ClusterHeaderTestSuite ();
+};
+
+ClusterHeaderTestSuite::ClusterHeaderTestSuite ()
+  : TestSuite ("cluster-header", UNIT)
+{
+  AddTestCase (new ClusterHeaderRoundTripTestCase (false), TestCase::QUICK);
+  AddTestCase (new ClusterHeaderRoundTripTestCase (true), TestCase::QUICK);
+  AddTestCase (new ClusterHeaderBitsTestCase, TestCase::QUICK);
+  AddTestCase (new ClusterHeaderTruncatedTestCase (false), TestCase::QUICK);
+  AddTestCase (new ClusterHeaderTruncatedTestCase (true), TestCase::QUICK);
+  AddTestCase (new ClusterHeaderFuzzTestCase, TestCase::QUICK);
+  AddTestCase (new ClusterPayloadHeaderTestCase (false), TestCase::QUICK);
+  AddTestCase (new ClusterPayloadHeaderTestCase (true), TestCase::QUICK);
+}
+
+static ClusterHeaderTestSuite g_clusterHeaderTestSuite; //!< Static variable for test initialization
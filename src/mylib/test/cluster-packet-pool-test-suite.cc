@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/test.h>
+#include <ns3/packet.h>
+#include <ns3/lr-wpan-lqi-tag.h>
+#include "ns3/cluster-packet-pool.h"
+#include <deque>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \ingroup mylib
+ * Frames released in the order they were sent, as the MAC confirms them,
+ * keep the pool at the number in flight: over many readings the pool
+ * creates window + 1 packets and recycles every other one.
+ */
+class ClusterPacketPoolWindowTestCase : public TestCase
+{
+public:
+  /**
+   * \param capacity pool size
+   * \param window frames still held after each allocation
+   */
+  ClusterPacketPoolWindowTestCase (uint32_t capacity, uint32_t window);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param capacity pool size
+   * \param window frames held
+   * \return the name of the test case
+   */
+  static std::string Name (uint32_t capacity, uint32_t window);
+
+  static const uint32_t READINGS = 10000; //!< allocations per run
+  uint32_t m_capacity;  //!< pool size
+  uint32_t m_window;    //!< frames held
+};
+
+ClusterPacketPoolWindowTestCase::ClusterPacketPoolWindowTestCase (uint32_t capacity, uint32_t window)
+  : TestCase (Name (capacity, window)),
+    m_capacity (capacity),
+    m_window (window)
+{
+}
+
+std::string
+ClusterPacketPoolWindowTestCase::Name (uint32_t capacity, uint32_t window)
+{
+  std::ostringstream oss;
+  oss << "Capacity " << capacity << ", " << window << " frames in flight";
+  return oss.str ();
+}
+
+void
+ClusterPacketPoolWindowTestCase::DoRun (void)
+{
+  ClusterPacketPool pool;
+  pool.SetCapacity (m_capacity);
+  // 模拟MAC手里压着的帧，按发送顺序确认、释放
+  std::deque<Ptr<Packet> > inFlight;
+  for (uint32_t i = 0; i < READINGS; ++i)
+    {
+      uint32_t size = i % 20;
+      Ptr<Packet> p = pool.Allocate (size);
+      NS_TEST_ASSERT_MSG_EQ (p->GetSize (), size, "payload of allocation " << i);
+      LrWpanLqiTag tag;
+      NS_TEST_ASSERT_MSG_EQ (p->PeekPacketTag (tag), false, "tag left on allocation " << i);
+      p->AddPacketTag (LrWpanLqiTag (uint8_t (i)));
+      p->AddPaddingAtEnd (7);
+      inFlight.push_back (p);
+      if (inFlight.size () > m_window)
+        {
+          inFlight.pop_front ();
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (pool.GetNAllocated () + pool.GetNRecycled (), READINGS, "every allocation counted");
+  if (m_capacity == 0)
+    {
+      NS_TEST_ASSERT_MSG_EQ (pool.GetNAllocated (), READINGS, "no pool, no reuse");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_LT (m_window, m_capacity, "the window must fit in the pool");
+      NS_TEST_ASSERT_MSG_EQ (pool.GetNAllocated (), m_window + 1, "packets created");
+    }
+}
+
+/**
+ * \ingroup mylib
+ * Packets still referenced outside the pool are never handed out again,
+ * and a smaller capacity releases the extra ones.
+ */
+class ClusterPacketPoolBusyTestCase : public TestCase
+{
+public:
+  ClusterPacketPoolBusyTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ClusterPacketPoolBusyTestCase::ClusterPacketPoolBusyTestCase ()
+  : TestCase ("Busy packets are not recycled")
+{
+}
+
+void
+ClusterPacketPoolBusyTestCase::DoRun (void)
+{
+  ClusterPacketPool pool;
+  pool.SetCapacity (4);
+  std::deque<Ptr<Packet> > held;
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      held.push_back (pool.Allocate (0));
+      for (uint32_t j = 0; j < i; ++j)
+        {
+          NS_TEST_ASSERT_MSG_NE (held[j], held[i], "allocation " << i << " reuses busy packet " << j);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (pool.GetNAllocated (), 6, "every packet busy");
+  NS_TEST_ASSERT_MSG_EQ (pool.GetNRecycled (), 0, "nothing to recycle");
+
+  // 只有进了池子的前4个能回收
+  held.clear ();
+  pool.SetCapacity (2);
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      held.push_back (pool.Allocate (0));
+      if (held.size () > 1)
+        {
+          held.pop_front ();
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (pool.GetNAllocated (), 6, "two pooled packets serve one in flight");
+  NS_TEST_ASSERT_MSG_EQ (pool.GetNRecycled (), 100, "every later allocation recycled");
+}
+
+/**
+ * \ingroup mylib
+ * Tests of ClusterPacketPool.
+ */
+class ClusterPacketPoolTestSuite : public TestSuite
+{
+public:
+  ClusterPacketPoolTestSuite ();
+};
+
+ClusterPacketPoolTestSuite::ClusterPacketPoolTestSuite ()
+  : TestSuite ("cluster-packet-pool", UNIT)
+{
+  AddTestCase (new ClusterPacketPoolWindowTestCase (0, 4), TestCase::QUICK);
+  AddTestCase (new ClusterPacketPoolWindowTestCase (8, 0), TestCase::QUICK);
+  AddTestCase (new ClusterPacketPoolWindowTestCase (8, 7), TestCase::QUICK);
+  AddTestCase (new ClusterPacketPoolWindowTestCase (64, 20), TestCase::QUICK);
+  AddTestCase (new ClusterPacketPoolBusyTestCase, TestCase::QUICK);
+}
+
+static ClusterPacketPoolTestSuite g_clusterPacketPoolTestSuite; //!< Static variable for test initialization
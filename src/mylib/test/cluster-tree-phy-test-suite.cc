@@ -0,0 +1,217 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/node.h>
+#include <ns3/packet.h>
+#include <ns3/lr-wpan-net-device.h>
+#include <ns3/lr-wpan-mac.h>
+#include <ns3/single-model-spectrum-channel.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/propagation-delay-model.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <ns3/spectrum-signal-parameters.h>
+#include "ns3/cluster-tree-phy.h"
+#include <sstream>
+
+using namespace ns3;
+
+namespace {
+
+const double SENSITIVITY_DBM = -70.0; //!< RxSensitivity of the receiver
+const uint32_t FRAMES = 5;            //!< frames sent per run
+
+}
+
+/**
+ * \ingroup mylib
+ * Two devices with ClusterTreePhy over a fixed-RSS link.  Frames arriving
+ * below RxSensitivity are counted and traced by the receiver's PHY and
+ * never handed to its MAC, so its MacSniffer trace stays silent; frames
+ * above it are delivered as usual.
+ */
+class ClusterTreePhySensitivityTestCase : public TestCase
+{
+public:
+  /**
+   * \param rssDbm received power of every frame
+   */
+  ClusterTreePhySensitivityTestCase (double rssDbm);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param rssDbm received power of every frame
+   * \return the name of the test case
+   */
+  static std::string Name (double rssDbm);
+  /**
+   * Send one unacknowledged frame to the receiver.
+   */
+  void Send (void);
+  /**
+   * \param params MCPS parameters
+   * \param p the frame
+   */
+  void DataIndication (McpsDataIndicationParams params, Ptr<Packet> p);
+  /**
+   * \param params the ignored signal
+   * \param rxPowerDbm its received power
+   */
+  void RxBelowSensitivity (Ptr<const SpectrumSignalParameters> params, double rxPowerDbm);
+  /**
+   * \param p a frame the receiver's PHY passed to its MAC
+   */
+  void MacSniffer (Ptr<const Packet> p);
+
+  double m_rssDbm;          //!< received power of every frame
+  Ptr<LrWpanMac> m_sender;  //!< MAC of the sending device
+  uint32_t m_nIndicated;    //!< frames the receiver's MAC indicated
+  uint32_t m_nMacRx;        //!< frames the receiver's MAC got from its PHY
+  uint32_t m_nTraced;       //!< RxBelowSensitivity trace hits
+  double m_tracedPowerDbm;  //!< power reported by the last trace hit
+};
+
+ClusterTreePhySensitivityTestCase::ClusterTreePhySensitivityTestCase (double rssDbm)
+  : TestCase (Name (rssDbm)),
+    m_rssDbm (rssDbm),
+    m_nIndicated (0),
+    m_nMacRx (0),
+    m_nTraced (0),
+    m_tracedPowerDbm (0.0)
+{
+}
+
+std::string
+ClusterTreePhySensitivityTestCase::Name (double rssDbm)
+{
+  std::ostringstream oss;
+  oss << "Frames at " << rssDbm << " dBm, sensitivity " << SENSITIVITY_DBM << " dBm";
+  return oss.str ();
+}
+
+void
+ClusterTreePhySensitivityTestCase::Send (void)
+{
+  McpsDataRequestParams params;
+  params.m_srcAddrMode = SHORT_ADDR;
+  params.m_dstAddrMode = SHORT_ADDR;
+  params.m_dstPanId = 0;
+  params.m_dstAddr = Mac16Address ("00:02");
+  params.m_msduHandle = 0;
+  // 不要ACK，免得重传把一帧算成几帧
+  params.m_txOptions = TX_OPTION_NONE;
+  m_sender->McpsDataRequest (params, Create<Packet> (20));
+}
+
+void
+ClusterTreePhySensitivityTestCase::DataIndication (McpsDataIndicationParams params, Ptr<Packet> p)
+{
+  m_nIndicated++;
+}
+
+void
+ClusterTreePhySensitivityTestCase::RxBelowSensitivity (Ptr<const SpectrumSignalParameters> params, double rxPowerDbm)
+{
+  m_nTraced++;
+  m_tracedPowerDbm = rxPowerDbm;
+}
+
+void
+ClusterTreePhySensitivityTestCase::MacSniffer (Ptr<const Packet> p)
+{
+  m_nMacRx++;
+}
+
+void
+ClusterTreePhySensitivityTestCase::DoRun (void)
+{
+  // FixedRss 不管距离和发射功率，每帧都按这个功率收到
+  Ptr<SingleModelSpectrumChannel> channel = CreateObject<SingleModelSpectrumChannel> ();
+  Ptr<FixedRssLossModel> loss = CreateObject<FixedRssLossModel> ();
+  loss->SetRss (m_rssDbm);
+  channel->AddPropagationLossModel (loss);
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+
+  Ptr<ClusterTreePhy> phys[2];
+  Ptr<LrWpanNetDevice> devices[2];
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      Ptr<ConstantPositionMobilityModel> position = CreateObject<ConstantPositionMobilityModel> ();
+      position->SetPosition (Vector (10.0 * i, 0.0, 0.0));
+      phys[i] = CreateObject<ClusterTreePhy> ();
+      phys[i]->SetRxSensitivity (SENSITIVITY_DBM);
+      devices[i] = CreateObject<LrWpanNetDevice> ();
+      devices[i]->SetPhy (phys[i]);
+      devices[i]->SetChannel (channel);
+      node->AddDevice (devices[i]);
+      devices[i]->SetNode (node);
+      phys[i]->SetMobility (position);
+    }
+  m_sender = devices[0]->GetMac ();
+  m_sender->SetShortAddress (Mac16Address ("00:01"));
+  Ptr<LrWpanMac> receiver = devices[1]->GetMac ();
+  receiver->SetShortAddress (Mac16Address ("00:02"));
+  receiver->SetMcpsDataIndicationCallback (MakeCallback (&ClusterTreePhySensitivityTestCase::DataIndication, this));
+  // MacSniffer 在MAC过滤之前触发，PHY交上来的每一帧都算
+  receiver->TraceConnectWithoutContext ("MacSniffer",
+                                        MakeCallback (&ClusterTreePhySensitivityTestCase::MacSniffer, this));
+  phys[1]->TraceConnectWithoutContext ("RxBelowSensitivity",
+                                       MakeCallback (&ClusterTreePhySensitivityTestCase::RxBelowSensitivity, this));
+
+  for (uint32_t i = 0; i < FRAMES; ++i)
+    {
+      Simulator::Schedule (MilliSeconds (100 * (i + 1)), &ClusterTreePhySensitivityTestCase::Send, this);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  if (m_rssDbm < SENSITIVITY_DBM)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_nMacRx, 0, "a frame below sensitivity reached the MAC");
+      NS_TEST_ASSERT_MSG_EQ (m_nIndicated, 0, "a frame below sensitivity was indicated");
+      NS_TEST_ASSERT_MSG_EQ (phys[1]->GetNRxBelowSensitivity (), FRAMES, "frames counted below sensitivity");
+      NS_TEST_ASSERT_MSG_EQ (m_nTraced, FRAMES, "RxBelowSensitivity trace hits");
+      NS_TEST_ASSERT_MSG_EQ_TOL (m_tracedPowerDbm, m_rssDbm, 0.01, "traced received power");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_nMacRx, FRAMES, "frames above sensitivity handed to the MAC");
+      NS_TEST_ASSERT_MSG_EQ (m_nIndicated, FRAMES, "frames above sensitivity indicated");
+      NS_TEST_ASSERT_MSG_EQ (phys[1]->GetNRxBelowSensitivity (), 0, "no frame counted below sensitivity");
+      NS_TEST_ASSERT_MSG_EQ (m_nTraced, 0, "no RxBelowSensitivity trace hit");
+    }
+}
+
+/**
+ * \ingroup mylib
+ * Tests of ClusterTreePhy.
+ */
+class ClusterTreePhyTestSuite : public TestSuite
+{
+public:
+  ClusterTreePhyTestSuite ();
+};
+
+ClusterTreePhyTestSuite::ClusterTreePhyTestSuite ()
+  : TestSuite ("cluster-tree-phy", UNIT)
+{
+  AddTestCase (new ClusterTreePhySensitivityTestCase (-80.0), TestCase::QUICK);
+  AddTestCase (new ClusterTreePhySensitivityTestCase (-60.0), TestCase::QUICK);
+}
+
+static ClusterTreePhyTestSuite g_clusterTreePhyTestSuite; //!< Static variable for test initialization